@@ -0,0 +1,356 @@
+#include <iomanip>
+#include <sstream>
+
+#include "3ac.hpp"
+#include "errors.hpp"
+#include "symbol_table.hpp"
+#include "type_analysis.hpp"
+#include "types.hpp"
+
+namespace holeyc{
+
+OpdWidth Opd::width(const DataType * type){
+	if (type->isBool() || type->isChar()){ return BYTE; }
+	if (type->isPtr()){ return ADDR; }
+	return QUADWORD;
+}
+
+static std::string opName(OpKind op){
+	switch (op){
+	case PLUS_OP: return "ADD";
+	case MINUS_OP: return "SUB";
+	case TIMES_OP: return "MULT";
+	case DIVIDE_OP: return "DIV";
+	case AND_OP: return "AND";
+	case OR_OP: return "OR";
+	case EQUALS_OP: return "EQ";
+	case NOT_EQUALS_OP: return "NEQ";
+	case LESS_OP: return "LT";
+	case LESS_EQ_OP: return "LTE";
+	case GREATER_OP: return "GT";
+	case GREATER_EQ_OP: return "GTE";
+	case NEG_OP: return "NEG";
+	case NOT_OP: return "NOT";
+	case OP_KIND_COUNT: break;
+	}
+	throw new InternalError("Bad operator in 3AC");
+}
+
+static std::string opName(OpKind op, const Opd * src){
+	return opName(op) + (src->getWidth() == BYTE ? "8" : "64");
+}
+
+std::string Quad::toString() const{
+	std::string label;
+	if (myLabel != nullptr){
+		label = myLabel->getName() + ":";
+	}
+	std::ostringstream out;
+	out << std::left << std::setw(12) << label << " " << repr();
+	return out.str();
+}
+
+void Quad::setDef(Opd * opd){
+	throw new InternalError("Quad without a def given one");
+}
+
+std::string AssignQuad::repr() const{
+	return myDst->toString() + " := " + mySrc->toString();
+}
+
+std::string BinOpQuad::repr() const{
+	return myDst->toString() + " := " + mySrc1->toString() + " "
+		+ opName(myOp, mySrc1) + " " + mySrc2->toString();
+}
+
+std::string UnaryOpQuad::repr() const{
+	return myDst->toString() + " := " + opName(myOp, mySrc) + " "
+		+ mySrc->toString();
+}
+
+std::string AddrQuad::repr() const{
+	return myDst->toString() + " := &" + myVar->toString();
+}
+
+std::string LoadQuad::repr() const{
+	return myDst->toString() + " := *" + myAddr->toString();
+}
+
+std::string StoreQuad::repr() const{
+	return "*" + myAddr->toString() + " := " + mySrc->toString();
+}
+
+std::string JmpQuad::repr() const{
+	return "goto " + myTgt->getName();
+}
+
+std::string JmpIfQuad::repr() const{
+	return "ifz " + myCnd->toString() + " goto " + myTgt->getName();
+}
+
+std::string ReadQuad::repr() const{
+	return "READ " + myDst->toString() + " (" + myType->getString() + ")";
+}
+
+std::string WriteQuad::repr() const{
+	return "WRITE " + mySrc->toString() + " (" + myType->getString() + ")";
+}
+
+std::string CallQuad::repr() const{
+	return "call " + myCallee->getName();
+}
+
+std::string EnterQuad::repr() const{
+	return "enter " + myProc->getName();
+}
+
+std::string LeaveQuad::repr() const{
+	return "leave " + myProc->getName();
+}
+
+std::string SetArgQuad::repr() const{
+	return "setarg " + std::to_string(myIndex) + " " + myOpd->toString();
+}
+
+std::string GetArgQuad::repr() const{
+	return "getarg " + std::to_string(myIndex) + " " + myOpd->toString();
+}
+
+std::string SetRetQuad::repr() const{
+	return "setret " + myOpd->toString();
+}
+
+std::string GetRetQuad::repr() const{
+	return "getret " + myOpd->toString();
+}
+
+std::string PhiQuad::repr() const{
+	std::string res = myDst->toString() + " := phi(";
+	for (size_t i = 0; i < myArgs.size(); i++){
+		if (i > 0){ res += ", "; }
+		res += std::to_string(myArgs[i].first) + ": "
+			+ myArgs[i].second->toString();
+	}
+	return res + ")";
+}
+
+Procedure::Procedure(IRProgram * prog, SemSymbol * fn, TypeAnalysis * types)
+: myProg(prog), myFn(fn), myTypes(types){
+	myLeave = prog->makeLabel();
+	addLabel(prog->makeLabel("fun_" + fn->getName()));
+	addQuad(new EnterQuad(this));
+}
+
+const std::string& Procedure::getName() const{
+	return myFn->getName();
+}
+
+const DataType * Procedure::nodeType(const ASTNode * node) const{
+	return myTypes->nodeType(node);
+}
+
+void Procedure::addQuad(Quad * quad){
+	if (myPending != nullptr){
+		quad->setLabel(myPending);
+		myPending = nullptr;
+	}
+	myQuads.emplace_back(quad);
+}
+
+void Procedure::addLabel(Label * label){
+	//A quad has one label, so two in a row need a quad
+	// between them
+	if (myPending != nullptr){
+		addQuad(new NopQuad());
+	}
+	myPending = label;
+}
+
+Label * Procedure::makeLabel(){
+	return myProg->makeLabel();
+}
+
+void Procedure::finish(){
+	addLabel(myLeave);
+	addQuad(new LeaveQuad(this));
+}
+
+SymOpd * Procedure::gather(SemSymbol * sym, std::vector<SymOpd *>& into){
+	auto found = myVars.find(sym);
+	if (found != myVars.end()){ return found->second; }
+	SymOpd * opd = new SymOpd(sym, takeName(sym->getName()),
+		Opd::width(sym->getDataType()));
+	myOpds.emplace_back(opd);
+	myVars[sym] = opd;
+	into.push_back(opd);
+	return opd;
+}
+
+bool Procedure::isFree(const std::string& name) const{
+	return myNames.count(name) == 0 && !myProg->isGlobalName(name);
+}
+
+std::string Procedure::takeName(const std::string& base){
+	std::string name = base;
+	for (size_t n = 1; !isFree(name); n++){
+		name = base + "_" + std::to_string(n);
+	}
+	myNames.insert(name);
+	return name;
+}
+
+SymOpd * Procedure::gatherFormal(SemSymbol * sym){
+	return gather(sym, myFormals);
+}
+
+SymOpd * Procedure::gatherLocal(SemSymbol * sym){
+	return gather(sym, myLocals);
+}
+
+SymOpd * Procedure::getSymOpd(SemSymbol * sym){
+	auto found = myVars.find(sym);
+	if (found != myVars.end()){ return found->second; }
+	SymOpd * global = myProg->getGlobal(sym);
+	if (global == nullptr){
+		throw new InternalError("Unknown variable in 3AC");
+	}
+	return global;
+}
+
+AuxOpd * Procedure::makeTmp(OpdWidth width){
+	//Numbered on past any variable the program called tmp<n>
+	size_t n = myTmps.size();
+	while (!isFree("tmp" + std::to_string(n))){ n++; }
+	std::string name = "tmp" + std::to_string(n);
+	myNames.insert(name);
+	AuxOpd * opd = new AuxOpd(name, width);
+	myOpds.emplace_back(opd);
+	myTmps.push_back(opd);
+	return opd;
+}
+
+//The name of a variable or temporary
+static const std::string& varName(const Opd * opd){
+	if (auto sym = dynamic_cast<const SymOpd *>(opd)){
+		return sym->getName();
+	} else if (auto tmp = dynamic_cast<const AuxOpd *>(opd)){
+		return tmp->getName();
+	}
+	throw new InternalError("Version of a constant or a version");
+}
+
+VersionOpd * Procedure::makeVersion(Opd * orig){
+	//The original itself names one value, so versions are
+	// numbered from 1
+	size_t count = ++myVersionCounts[orig];
+	VersionOpd * opd = new VersionOpd(orig,
+		varName(orig) + "." + std::to_string(count));
+	myOpds.emplace_back(opd);
+	myVersions.push_back(opd);
+	return opd;
+}
+
+static std::string sizeString(const Opd * opd){
+	size_t bytes = Opd::bytes(opd->getWidth());
+	return std::to_string(bytes) + (bytes == 1 ? " byte" : " bytes");
+}
+
+void Procedure::toString(std::ostream& out) const{
+	out << "[BEGIN " << getName() << " LOCALS]\n";
+	for (const SymOpd * formal : myFormals){
+		out << formal->getName() << " (formal arg of "
+			<< sizeString(formal) << ")\n";
+	}
+	for (const SymOpd * local : myLocals){
+		out << local->getName() << " (local var of "
+			<< sizeString(local) << ")\n";
+	}
+	for (const AuxOpd * tmp : myTmps){
+		out << tmp->getName() << " (tmp var of "
+			<< sizeString(tmp) << ")\n";
+	}
+	for (const VersionOpd * version : myVersions){
+		out << version->getName() << " (version of "
+			<< varName(version->getOrig()) << ", "
+			<< sizeString(version) << ")\n";
+	}
+	out << "[END " << getName() << " LOCALS]\n";
+	for (const auto& quad : myQuads){
+		out << quad->toString() << "\n";
+	}
+}
+
+Procedure * IRProgram::makeProc(SemSymbol * fn){
+	return makeProc(fn, myTypes);
+}
+
+Procedure * IRProgram::makeProc(SemSymbol * fn, TypeAnalysis * types){
+	myProcs.emplace_back(new Procedure(this, fn, types));
+	return myProcs.back().get();
+}
+
+SymOpd * IRProgram::gatherGlobal(SemSymbol * sym){
+	SymOpd * old = getGlobal(sym);
+	if (old != nullptr){ return old; }
+	SymOpd * opd = new SymOpd(sym, sym->getName(),
+		Opd::width(sym->getDataType()));
+	myOpds.emplace_back(opd);
+	myGlobals[sym] = opd;
+	myGlobalList.push_back(opd);
+	myGlobalNames.insert(sym->getName());
+	myEscaping.insert(opd);
+	return opd;
+}
+
+SymOpd * IRProgram::getGlobal(SemSymbol * sym) const{
+	auto found = myGlobals.find(sym);
+	return found == myGlobals.end() ? nullptr : found->second;
+}
+
+bool IRProgram::isEscaping(const Opd * opd) const{
+	return myEscaping.count(opd) > 0;
+}
+
+LitOpd * IRProgram::makeString(const std::string& val){
+	std::string name = "str_" + std::to_string(myStrings.size());
+	LitOpd * opd = new LitOpd(name, ADDR);
+	myOpds.emplace_back(opd);
+	myStrings.emplace_back(opd, val);
+	return opd;
+}
+
+LitOpd * IRProgram::makeLit(const std::string& val, OpdWidth width){
+	LitOpd *& opd = myLits[std::make_pair(val, width)];
+	if (opd == nullptr){
+		opd = new LitOpd(val, width);
+		myOpds.emplace_back(opd);
+	}
+	return opd;
+}
+
+Label * IRProgram::makeLabel(){
+	return makeLabel("lbl_" + std::to_string(myLabelCount++));
+}
+
+Label * IRProgram::makeLabel(const std::string& name){
+	myLabels.emplace_back(new Label(name));
+	return myLabels.back().get();
+}
+
+void IRProgram::toString(std::ostream& out) const{
+	out << "[BEGIN GLOBALS]\n";
+	for (const SymOpd * global : myGlobalList){
+		out << global->getName() << " (global var of "
+			<< sizeString(global) << ")\n";
+	}
+	for (const auto& str : myStrings){
+		out << str.first->toString() << " " << str.second << "\n";
+	}
+	out << "[END GLOBALS]\n";
+	for (const auto& proc : myProcs){
+		out << "\n";
+		proc->toString(out);
+	}
+}
+
+}
@@ -0,0 +1,579 @@
+#ifndef HOLEYC_3AC_HPP
+#define HOLEYC_3AC_HPP
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "operators.hpp"
+
+namespace holeyc{
+
+class ASTNode;
+class DataType;
+class SemSymbol;
+class TypeAnalysis;
+class Procedure;
+class IRProgram;
+
+//How much storage a value takes: a byte (bool and char), an
+// int, or an address (pointers and strings)
+enum OpdWidth { BYTE, QUADWORD, ADDR };
+
+//An operand of a three-address instruction
+class Opd{
+public:
+	virtual ~Opd(){ }
+	//How the operand is written in the IR: a location in
+	// brackets, or a constant as it is
+	virtual std::string toString() const = 0;
+	//Constants aren't locations, so analyses skip them
+	virtual bool isConst() const { return false; }
+	OpdWidth getWidth() const { return myWidth; }
+	//The width of a value of the given type
+	static OpdWidth width(const DataType * type);
+	static size_t bytes(OpdWidth width){ return width == BYTE ? 1 : 8; }
+protected:
+	Opd(OpdWidth widthIn) : myWidth(widthIn){ }
+private:
+	OpdWidth myWidth;
+};
+
+//A variable of the source program: a global, or a formal or
+// local of one procedure
+class SymOpd : public Opd{
+public:
+	std::string toString() const override { return "[" + myName + "]"; }
+	SemSymbol * getSym() const { return mySym; }
+	//Unique within the procedure (or among the globals)
+	const std::string& getName() const { return myName; }
+private:
+	friend class Procedure;
+	friend class IRProgram;
+	SymOpd(SemSymbol * sym, const std::string& name, OpdWidth width)
+	: Opd(width), mySym(sym), myName(name){ }
+	SemSymbol * mySym;
+	std::string myName;
+};
+
+//A constant. The value of a string literal is the address
+// of its global, so it is one too.
+class LitOpd : public Opd{
+public:
+	std::string toString() const override { return myVal; }
+	bool isConst() const override { return true; }
+private:
+	friend class IRProgram;
+	LitOpd(const std::string& val, OpdWidth width)
+	: Opd(width), myVal(val){ }
+	std::string myVal;
+};
+
+//A temporary introduced by lowering
+class AuxOpd : public Opd{
+public:
+	std::string toString() const override { return "[" + myName + "]"; }
+	const std::string& getName() const { return myName; }
+private:
+	friend class Procedure;
+	AuxOpd(const std::string& name, OpdWidth width)
+	: Opd(width), myName(name){ }
+	std::string myName;
+};
+
+//One of the values of a variable or temporary in SSA form,
+// written [x.2] (see Procedure::toSSA)
+class VersionOpd : public Opd{
+public:
+	std::string toString() const override { return "[" + myName + "]"; }
+	const std::string& getName() const { return myName; }
+	//The variable or temporary this is a version of
+	Opd * getOrig() const { return myOrig; }
+private:
+	friend class Procedure;
+	VersionOpd(Opd * orig, const std::string& name)
+	: Opd(orig->getWidth()), myOrig(orig), myName(name){ }
+	Opd * myOrig;
+	std::string myName;
+};
+
+class Label{
+public:
+	const std::string& getName() const { return myName; }
+private:
+	friend class IRProgram;
+	Label(const std::string& name) : myName(name){ }
+	std::string myName;
+};
+
+//A three-address instruction, possibly labelled
+class Quad{
+public:
+	virtual ~Quad(){ }
+	//The instruction, without its label
+	virtual std::string repr() const = 0;
+	//The instruction, after a column for its label
+	std::string toString() const;
+	Label * getLabel() const { return myLabel; }
+	void setLabel(Label * label){ myLabel = label; }
+
+	//The operand the quad writes, if any
+	virtual Opd * getDef() const { return nullptr; }
+	//Add the operands the quad reads to uses
+	virtual void getUses(std::vector<Opd *>& uses) const { }
+	//Where the quad may jump, other than to the next quad
+	virtual Label * getJumpTarget() const { return nullptr; }
+	//Whether control may go on to the next quad
+	virtual bool fallsThrough() const { return true; }
+	//Whether the quad may read or write variables other than
+	// its operands: those whose address has been taken, and
+	// globals (see IRProgram::isEscaping)
+	virtual bool readsMemory() const { return false; }
+	virtual bool writesMemory() const { return false; }
+	//Replace the operand the quad writes, which it must have
+	virtual void setDef(Opd * opd);
+	//Replace each operand the quad reads with f of it
+	virtual void mapUses(const std::function<Opd *(Opd *)>& f){ }
+private:
+	Label * myLabel = nullptr;
+};
+
+//dst := src
+class AssignQuad : public Quad{
+public:
+	AssignQuad(Opd * dst, Opd * src) : myDst(dst), mySrc(src){ }
+	std::string repr() const override;
+	Opd * getDef() const override { return myDst; }
+	void setDef(Opd * opd) override { myDst = opd; }
+	void getUses(std::vector<Opd *>& uses) const override {
+		uses.push_back(mySrc);
+	}
+	void mapUses(const std::function<Opd *(Opd *)>& f) override {
+		mySrc = f(mySrc);
+	}
+	Opd * getDst() const { return myDst; }
+	Opd * getSrc() const { return mySrc; }
+private:
+	Opd * myDst;
+	Opd * mySrc;
+};
+
+//dst := src1 op src2. The operator is written with the
+// width of its operands, e.g. ADD64 or EQ8.
+class BinOpQuad : public Quad{
+public:
+	BinOpQuad(Opd * dst, OpKind op, Opd * src1, Opd * src2)
+	: myDst(dst), myOp(op), mySrc1(src1), mySrc2(src2){ }
+	std::string repr() const override;
+	Opd * getDef() const override { return myDst; }
+	void setDef(Opd * opd) override { myDst = opd; }
+	void getUses(std::vector<Opd *>& uses) const override {
+		uses.push_back(mySrc1);
+		uses.push_back(mySrc2);
+	}
+	void mapUses(const std::function<Opd *(Opd *)>& f) override {
+		mySrc1 = f(mySrc1);
+		mySrc2 = f(mySrc2);
+	}
+	Opd * getDst() const { return myDst; }
+	OpKind getOp() const { return myOp; }
+	Opd * getSrc1() const { return mySrc1; }
+	Opd * getSrc2() const { return mySrc2; }
+private:
+	Opd * myDst;
+	OpKind myOp;
+	Opd * mySrc1;
+	Opd * mySrc2;
+};
+
+//dst := op src
+class UnaryOpQuad : public Quad{
+public:
+	UnaryOpQuad(Opd * dst, OpKind op, Opd * src)
+	: myDst(dst), myOp(op), mySrc(src){ }
+	std::string repr() const override;
+	Opd * getDef() const override { return myDst; }
+	void setDef(Opd * opd) override { myDst = opd; }
+	void getUses(std::vector<Opd *>& uses) const override {
+		uses.push_back(mySrc);
+	}
+	void mapUses(const std::function<Opd *(Opd *)>& f) override {
+		mySrc = f(mySrc);
+	}
+	Opd * getDst() const { return myDst; }
+	OpKind getOp() const { return myOp; }
+	Opd * getSrc() const { return mySrc; }
+private:
+	Opd * myDst;
+	OpKind myOp;
+	Opd * mySrc;
+};
+
+//dst := &var
+class AddrQuad : public Quad{
+public:
+	AddrQuad(Opd * dst, SymOpd * var) : myDst(dst), myVar(var){ }
+	std::string repr() const override;
+	Opd * getDef() const override { return myDst; }
+	void setDef(Opd * opd) override { myDst = opd; }
+	Opd * getDst() const { return myDst; }
+	SymOpd * getVar() const { return myVar; }
+private:
+	Opd * myDst;
+	SymOpd * myVar;
+};
+
+//dst := *addr
+class LoadQuad : public Quad{
+public:
+	LoadQuad(Opd * dst, Opd * addr) : myDst(dst), myAddr(addr){ }
+	std::string repr() const override;
+	Opd * getDef() const override { return myDst; }
+	void setDef(Opd * opd) override { myDst = opd; }
+	void getUses(std::vector<Opd *>& uses) const override {
+		uses.push_back(myAddr);
+	}
+	void mapUses(const std::function<Opd *(Opd *)>& f) override {
+		myAddr = f(myAddr);
+	}
+	bool readsMemory() const override { return true; }
+	Opd * getDst() const { return myDst; }
+	Opd * getAddr() const { return myAddr; }
+private:
+	Opd * myDst;
+	Opd * myAddr;
+};
+
+//*addr := src
+class StoreQuad : public Quad{
+public:
+	StoreQuad(Opd * addr, Opd * src) : myAddr(addr), mySrc(src){ }
+	std::string repr() const override;
+	void getUses(std::vector<Opd *>& uses) const override {
+		uses.push_back(myAddr);
+		uses.push_back(mySrc);
+	}
+	void mapUses(const std::function<Opd *(Opd *)>& f) override {
+		myAddr = f(myAddr);
+		mySrc = f(mySrc);
+	}
+	bool writesMemory() const override { return true; }
+	Opd * getAddr() const { return myAddr; }
+	Opd * getSrc() const { return mySrc; }
+private:
+	Opd * myAddr;
+	Opd * mySrc;
+};
+
+class JmpQuad : public Quad{
+public:
+	JmpQuad(Label * tgt) : myTgt(tgt){ }
+	std::string repr() const override;
+	Label * getJumpTarget() const override { return myTgt; }
+	bool fallsThrough() const override { return false; }
+	Label * getTarget() const { return myTgt; }
+private:
+	Label * myTgt;
+};
+
+//Jump if cnd is false (zero)
+class JmpIfQuad : public Quad{
+public:
+	JmpIfQuad(Opd * cnd, Label * tgt) : myCnd(cnd), myTgt(tgt){ }
+	std::string repr() const override;
+	void getUses(std::vector<Opd *>& uses) const override {
+		uses.push_back(myCnd);
+	}
+	void mapUses(const std::function<Opd *(Opd *)>& f) override {
+		myCnd = f(myCnd);
+	}
+	Label * getJumpTarget() const override { return myTgt; }
+	Opd * getCnd() const { return myCnd; }
+	Label * getTarget() const { return myTgt; }
+	void setTarget(Label * tgt){ myTgt = tgt; }
+private:
+	Opd * myCnd;
+	Label * myTgt;
+};
+
+class NopQuad : public Quad{
+public:
+	std::string repr() const override { return "nop"; }
+};
+
+//Read a value of the given type from the console into dst
+class ReadQuad : public Quad{
+public:
+	ReadQuad(Opd * dst, const DataType * type)
+	: myDst(dst), myType(type){ }
+	std::string repr() const override;
+	Opd * getDef() const override { return myDst; }
+	void setDef(Opd * opd) override { myDst = opd; }
+	Opd * getDst() const { return myDst; }
+	const DataType * getType() const { return myType; }
+private:
+	Opd * myDst;
+	const DataType * myType;
+};
+
+//Write a value of the given type to the console
+class WriteQuad : public Quad{
+public:
+	WriteQuad(Opd * src, const DataType * type)
+	: mySrc(src), myType(type){ }
+	std::string repr() const override;
+	void getUses(std::vector<Opd *>& uses) const override {
+		uses.push_back(mySrc);
+	}
+	void mapUses(const std::function<Opd *(Opd *)>& f) override {
+		mySrc = f(mySrc);
+	}
+	Opd * getSrc() const { return mySrc; }
+	const DataType * getType() const { return myType; }
+private:
+	Opd * mySrc;
+	const DataType * myType;
+};
+
+//Call a function, whose arguments have been set with
+// SetArgQuads
+class CallQuad : public Quad{
+public:
+	CallQuad(SemSymbol * callee) : myCallee(callee){ }
+	std::string repr() const override;
+	bool readsMemory() const override { return true; }
+	bool writesMemory() const override { return true; }
+	SemSymbol * getCallee() const { return myCallee; }
+private:
+	SemSymbol * myCallee;
+};
+
+class EnterQuad : public Quad{
+public:
+	EnterQuad(Procedure * proc) : myProc(proc){ }
+	std::string repr() const override;
+private:
+	Procedure * myProc;
+};
+
+class LeaveQuad : public Quad{
+public:
+	LeaveQuad(Procedure * proc) : myProc(proc){ }
+	std::string repr() const override;
+	bool fallsThrough() const override { return false; }
+	//The caller can see the globals
+	bool readsMemory() const override { return true; }
+private:
+	Procedure * myProc;
+};
+
+//Pass opd as argument number index (counting from 1)
+class SetArgQuad : public Quad{
+public:
+	SetArgQuad(size_t index, Opd * opd) : myIndex(index), myOpd(opd){ }
+	std::string repr() const override;
+	void getUses(std::vector<Opd *>& uses) const override {
+		uses.push_back(myOpd);
+	}
+	void mapUses(const std::function<Opd *(Opd *)>& f) override {
+		myOpd = f(myOpd);
+	}
+	size_t getIndex() const { return myIndex; }
+	Opd * getOpd() const { return myOpd; }
+private:
+	size_t myIndex;
+	Opd * myOpd;
+};
+
+//Take argument number index (counting from 1) into opd
+class GetArgQuad : public Quad{
+public:
+	GetArgQuad(size_t index, Opd * opd) : myIndex(index), myOpd(opd){ }
+	std::string repr() const override;
+	Opd * getDef() const override { return myOpd; }
+	void setDef(Opd * opd) override { myOpd = opd; }
+	size_t getIndex() const { return myIndex; }
+	Opd * getOpd() const { return myOpd; }
+private:
+	size_t myIndex;
+	Opd * myOpd;
+};
+
+class SetRetQuad : public Quad{
+public:
+	SetRetQuad(Opd * opd) : myOpd(opd){ }
+	std::string repr() const override;
+	void getUses(std::vector<Opd *>& uses) const override {
+		uses.push_back(myOpd);
+	}
+	void mapUses(const std::function<Opd *(Opd *)>& f) override {
+		myOpd = f(myOpd);
+	}
+	Opd * getOpd() const { return myOpd; }
+private:
+	Opd * myOpd;
+};
+
+//Take the return value of the last call into opd
+class GetRetQuad : public Quad{
+public:
+	GetRetQuad(Opd * opd) : myOpd(opd){ }
+	std::string repr() const override;
+	Opd * getDef() const override { return myOpd; }
+	void setDef(Opd * opd) override { myOpd = opd; }
+	Opd * getOpd() const { return myOpd; }
+private:
+	Opd * myOpd;
+};
+
+//dst := phi(b1: src1, b2: src2, ...), which takes the value
+// of src_i when control came from the block with id b_i in
+// the procedure's CFG. Phis only appear in SSA form, at the
+// tops of blocks, and all of a block's phis happen at once.
+class PhiQuad : public Quad{
+public:
+	PhiQuad(Opd * dst) : myDst(dst){ }
+	std::string repr() const override;
+	Opd * getDef() const override { return myDst; }
+	void setDef(Opd * opd) override { myDst = opd; }
+	void getUses(std::vector<Opd *>& uses) const override {
+		for (const auto& arg : myArgs){ uses.push_back(arg.second); }
+	}
+	void mapUses(const std::function<Opd *(Opd *)>& f) override {
+		for (auto& arg : myArgs){ arg.second = f(arg.second); }
+	}
+	void addArg(size_t block, Opd * src){ myArgs.emplace_back(block, src); }
+	const std::vector<std::pair<size_t, Opd *>>& getArgs() const {
+		return myArgs;
+	}
+private:
+	Opd * myDst;
+	std::vector<std::pair<size_t, Opd *>> myArgs;
+};
+
+//The instructions of one function, and the variables and
+// temporaries they use. Quads are added in order; a label
+// added on its own marks the next quad added.
+class Procedure{
+public:
+	Procedure(IRProgram * prog, SemSymbol * fn, TypeAnalysis * types);
+	IRProgram * getProg() const { return myProg; }
+	//The checked type of an expression of the function
+	const DataType * nodeType(const ASTNode * node) const;
+	const std::string& getName() const;
+	void addQuad(Quad * quad);
+	void addLabel(Label * label);
+	Label * makeLabel();
+	//Where a return jumps to
+	Label * getLeaveLabel() const { return myLeave; }
+	//End the procedure with its leave quad
+	void finish();
+
+	SymOpd * gatherFormal(SemSymbol * sym);
+	SymOpd * gatherLocal(SemSymbol * sym);
+	//The operand of a formal, local or global
+	SymOpd * getSymOpd(SemSymbol * sym);
+	AuxOpd * makeTmp(OpdWidth width);
+
+	const std::vector<std::unique_ptr<Quad>>& getQuads() const {
+		return myQuads;
+	}
+	const std::vector<SymOpd *>& getFormals() const { return myFormals; }
+	const std::vector<SymOpd *>& getLocals() const { return myLocals; }
+	const std::vector<AuxOpd *>& getTmps() const { return myTmps; }
+	const std::vector<VersionOpd *>& getVersions() const {
+		return myVersions;
+	}
+	void toString(std::ostream& out) const;
+
+	//Rename the procedure's formals, locals and temporaries so
+	// that each is written by exactly one quad, with phis where
+	// control flow merges values (see ssa.cpp). Escaping
+	// variables (see IRProgram::isEscaping) stay as they are.
+	void toSSA();
+	//Replace the phis with copies, leaving ordinary 3AC
+	void fromSSA();
+	bool isSSA() const { return mySSA; }
+	VersionOpd * makeVersion(Opd * orig);
+private:
+	SymOpd * gather(SemSymbol * sym, std::vector<SymOpd *>& into);
+	//Whether no variable or temporary of the procedure, and
+	// no global, is called name
+	bool isFree(const std::string& name) const;
+	//Take base, or the first of base_1, base_2... that is free
+	std::string takeName(const std::string& base);
+	void dropUnreachable();
+
+	IRProgram * myProg;
+	SemSymbol * myFn;
+	TypeAnalysis * myTypes;
+	std::vector<std::unique_ptr<Quad>> myQuads;
+	Label * myPending = nullptr;
+	Label * myLeave;
+	std::vector<std::unique_ptr<Opd>> myOpds;
+	std::map<SemSymbol *, SymOpd *> myVars;
+	std::vector<SymOpd *> myFormals;
+	std::vector<SymOpd *> myLocals;
+	std::vector<AuxOpd *> myTmps;
+	std::vector<VersionOpd *> myVersions;
+	std::map<const Opd *, size_t> myVersionCounts;
+	bool mySSA = false;
+	//The names of the variables and temporaries so far, so
+	// that each is told apart in the output
+	std::set<std::string> myNames;
+};
+
+//A whole program in three-address form. It refers to the
+// symbols and types of the analysis it was lowered from,
+// which must outlive it.
+class IRProgram{
+public:
+	IRProgram(TypeAnalysis * ta) : myTypes(ta){ }
+	Procedure * makeProc(SemSymbol * fn);
+	//A procedure for a function checked by another analysis
+	// (a prelude function)
+	Procedure * makeProc(SemSymbol * fn, TypeAnalysis * types);
+	SymOpd * gatherGlobal(SemSymbol * sym);
+	//The operand of a global, or nullptr
+	SymOpd * getGlobal(SemSymbol * sym) const;
+	bool isGlobalName(const std::string& name) const {
+		return myGlobalNames.count(name) > 0;
+	}
+	//Whether a quad that reads or writes memory may touch opd:
+	// a global, or a variable whose address is taken
+	bool isEscaping(const Opd * opd) const;
+	void addressTaken(const SymOpd * opd){ myEscaping.insert(opd); }
+	//The address of a new global holding the string
+	LitOpd * makeString(const std::string& val);
+	LitOpd * makeLit(const std::string& val, OpdWidth width);
+	Label * makeLabel();
+	Label * makeLabel(const std::string& name);
+
+	const std::vector<std::unique_ptr<Procedure>>& getProcs() const {
+		return myProcs;
+	}
+	void toString(std::ostream& out) const;
+	void toSSA();
+	void fromSSA();
+private:
+	TypeAnalysis * myTypes;
+	std::vector<std::unique_ptr<Procedure>> myProcs;
+	std::vector<std::unique_ptr<Label>> myLabels;
+	std::vector<std::unique_ptr<Opd>> myOpds;
+	std::map<SemSymbol *, SymOpd *> myGlobals;
+	std::vector<SymOpd *> myGlobalList;
+	std::set<std::string> myGlobalNames;
+	//The globals and the variables whose address is taken
+	std::set<const Opd *> myEscaping;
+	std::vector<std::pair<LitOpd *, std::string>> myStrings;
+	std::map<std::pair<std::string, OpdWidth>, LitOpd *> myLits;
+	size_t myLabelCount = 0;
+};
+
+}
+
+#endif
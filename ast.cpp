@@ -0,0 +1,146 @@
+#include "ast.hpp"
+
+namespace holeyc{
+
+//Delete each node in a child list, then the list itself
+template <typename T>
+static void deleteList(std::list<T *> * elts){
+	if (elts == nullptr){ return; }
+	for (T * elt : *elts){
+		delete elt;
+	}
+	delete elts;
+}
+
+//Ids are handed out per thread, so threads parsing different
+// programs never contend. A program's ids start where the
+// previous program built on the same thread left off.
+static thread_local size_t nextNodeID = 0;
+static thread_local size_t programStartID = 0;
+
+size_t ASTNode::peekNodeID(){
+	return nextNodeID;
+}
+
+size_t ASTNode::takeNodeID(){
+	return nextNodeID++;
+}
+
+static thread_local NodeLog * currentLog = nullptr;
+
+NodeLog::NodeLog() : myOuter(currentLog){
+	currentLog = this;
+}
+
+NodeLog::~NodeLog(){
+	currentLog = myOuter;
+}
+
+void NodeLog::record(ASTNode * node){
+	if (currentLog != nullptr){
+		currentLog->myNodes.push_back(node);
+	}
+}
+
+//The parser (and the AST image reader) build the program
+// node last, once every other node of the program exists
+ProgramNode::ProgramNode(std::list<DeclNode *> * globalsIn)
+: ASTNode(1,1), myGlobals(globalsIn){
+	myFirstNodeID = programStartID;
+	myNodeCount = peekNodeID() - programStartID;
+	programStartID = peekNodeID();
+}
+
+ProgramNode::~ProgramNode(){
+	deleteList(myGlobals);
+}
+
+RefNode::~RefNode(){
+	delete myID;
+}
+
+DerefNode::~DerefNode(){
+	delete myID;
+}
+
+IndexNode::~IndexNode(){
+	delete myBase;
+	delete myOffset;
+}
+
+VarDeclNode::~VarDeclNode(){
+	delete myType;
+	delete myID;
+}
+
+FnDeclNode::~FnDeclNode(){
+	delete myID;
+	delete myRetType;
+	deleteList(myFormals);
+	deleteList(myBody);
+}
+
+AssignStmtNode::~AssignStmtNode(){
+	delete myExp;
+}
+
+FromConsoleStmtNode::~FromConsoleStmtNode(){
+	delete myDst;
+}
+
+ToConsoleStmtNode::~ToConsoleStmtNode(){
+	delete mySrc;
+}
+
+PostDecStmtNode::~PostDecStmtNode(){
+	delete myLVal;
+}
+
+PostIncStmtNode::~PostIncStmtNode(){
+	delete myLVal;
+}
+
+IfStmtNode::~IfStmtNode(){
+	delete myCond;
+	deleteList(myBody);
+}
+
+IfElseStmtNode::~IfElseStmtNode(){
+	delete myCond;
+	deleteList(myBodyTrue);
+	deleteList(myBodyFalse);
+}
+
+WhileStmtNode::~WhileStmtNode(){
+	delete myCond;
+	deleteList(myBody);
+}
+
+ReturnStmtNode::~ReturnStmtNode(){
+	delete myExp;
+}
+
+CallStmtNode::~CallStmtNode(){
+	delete myCallExp;
+}
+
+CallExpNode::~CallExpNode(){
+	delete myID;
+	deleteList(myArgs);
+}
+
+BinaryExpNode::~BinaryExpNode(){
+	delete myExp1;
+	delete myExp2;
+}
+
+UnaryExpNode::~UnaryExpNode(){
+	delete myExp;
+}
+
+AssignExpNode::~AssignExpNode(){
+	delete myDst;
+	delete mySrc;
+}
+
+} //End namespace holeyc
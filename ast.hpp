@@ -5,14 +5,20 @@
 #include <sstream>
 #include <string.h>
 #include <list>
+#include <vector>
+#include <cstdint>
 #include "tokens.hpp"
 #include "types.hpp"
+#include "operators.hpp"
 
 namespace holeyc {
 
 class TypeAnalysis;
+class ASTWriter;
 
 class Opd;
+class Procedure;
+class IRProgram;
 
 class SymbolTable;
 class SemSymbol;
@@ -32,36 +38,111 @@ class StructTypeNode;
 class ExpNode;
 class LValNode;
 class IDNode;
+class FnCache;
+class ASTNode;
+
+//Collects every node constructed on its thread while it is
+// the innermost live log, in construction order (so children
+// come before their parents). Used to index a freshly parsed
+// tree without a pass over it.
+class NodeLog{
+public:
+	NodeLog();
+	~NodeLog();
+	const std::vector<ASTNode *>& nodes() const { return myNodes; }
+	static void record(ASTNode * node);
+private:
+	NodeLog * myOuter;
+	std::vector<ASTNode *> myNodes;
+};
 
 class ASTNode{
 public:
 	ASTNode(size_t lineIn, size_t colIn)
-	: l(lineIn), c(colIn){ }
+	: l(lineIn), c(colIn), myNodeID(takeNodeID()){
+		NodeLog::record(this);
+	}
+	//Every node owns its children (and the lists holding
+	// them), so deleting the root frees the whole tree
+	virtual ~ASTNode(){ }
 	virtual void unparse(std::ostream&, int) = 0;
 	size_t line() const { return this->l; }
 	size_t col() const { return this->c; }
+	//Nodes are numbered densely, in construction order, per
+	// thread. The nodes of one program have ids in 
+	// [getFirstNodeID(), getFirstNodeID() + getNodeCount())
+	// of its ProgramNode, so passes can keep per-node results
+	// in flat arrays instead of hash maps.
+	size_t nodeID() const { return myNodeID; }
 	std::string pos(){
 		return "[" + std::to_string(line()) + ","
 			+ std::to_string(col()) + "]";
 	}
 	virtual bool nameAnalysis(SymbolTable *) = 0;
+	virtual void serialize(ASTWriter *) = 0;
 	//Note that there is no ASTNode::typeAnalysis. To allow
 	// for different type signatures, type analysis is 
 	// implemented as needed in various subclasses
+
+	//A hash of the structure of this subtree (node kinds,
+	// names and literal values, but not source positions).
+	// It is computed from the children's hashes the first 
+	// time it is asked for and cached on the node, so 
+	// hashing a whole tree is a single pass.
+	uint64_t structHash(){
+		if (myHash == 0){
+			myHash = computeHash();
+			//0 marks "not yet computed"
+			if (myHash == 0){ myHash = 1; }
+		}
+		return myHash;
+	}
+protected:
+	virtual uint64_t computeHash() = 0;
+	//Forget the cached hash, when a pass is about to change
+	// the subtree. Its ancestors must forget theirs as well.
+	void rehash(){ myHash = 0; }
+	//The id the next node built on this thread will get
+	static size_t peekNodeID();
+	static size_t takeNodeID();
 private:
 	size_t l;
 	size_t c;
+	size_t myNodeID;
+	uint64_t myHash = 0;
 };
 
 class ProgramNode : public ASTNode{
 public:
-	ProgramNode(std::list<DeclNode *> * globalsIn)
-	: ASTNode(1,1), myGlobals(globalsIn){}
+	ProgramNode(std::list<DeclNode *> * globalsIn);
+	~ProgramNode();
 	void unparse(std::ostream&, int) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *);
+	//Name analysis that type-checks each declaration right
+	// after binding its names, until a name error is found.
+	// With a cache, the functions it has results for are
+	// replayed rather than analysed.
+	bool fusedAnalysis(SymbolTable *, TypeAnalysis *, 
+		FnCache * cache = nullptr);
+	std::list<DeclNode *> * getGlobals(){ return myGlobals; }
+	size_t getFirstNodeID() const { return myFirstNodeID; }
+	//The number of nodes built for this program, itself 
+	// included (nodes added to the tree later may have ids
+	// past the end)
+	size_t getNodeCount() const { return myNodeCount; }
+	//Fold constants in the (type-checked) program
+	void fold(TypeAnalysis * ta);
+	//Lower the (type-checked) program to three-address code
+	IRProgram * to3AC(TypeAnalysis * ta);
 private:
+	bool nameAnalysisParallel(SymbolTable * symTab);
+	void typeAnalysisParallel(TypeAnalysis * ta);
 	std::list<DeclNode *> * myGlobals;
+	size_t myFirstNodeID;
+	size_t myNodeCount;
 };
 
 class ExpNode : public ASTNode{
@@ -71,6 +152,17 @@ public:
 	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *);
+	//Emit the quads computing this expression, and give back
+	// the operand holding its value (nullptr for a void call)
+	virtual Opd * flatten(Procedure * proc) = 0;
+	//Fold constant subexpressions (see fold.cpp), and give
+	// back the node to use in this one's place: this one, a
+	// new node, or a child that this one lets go of
+	virtual ExpNode * fold(TypeAnalysis * ta){ return this; }
+	//Whether evaluating the expression can do more than
+	// produce its value: change something, or trap (as a
+	// division or a load through a pointer can)
+	virtual bool hasEffects() const { return false; }
 };
 
 class LValNode : public ExpNode{
@@ -80,18 +172,24 @@ public:
 	void unparseNested(std::ostream& out) override;
 	void attachSymbol(SemSymbol * symbolIn) { } 
 	bool nameAnalysis(SymbolTable * symTab) override { return false; }
+	//Emit the quads storing src into this location
+	virtual void store(Procedure * proc, Opd * src) = 0;
 };
 
 class IDNode : public LValNode{
 public:
 	IDNode(size_t lIn, size_t cIn, std::string nameIn)
 	: LValNode(lIn, cIn), name(nameIn){}
-	std::string getName(){ return name; }
+	const std::string& getName() const { return name; }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	void attachSymbol(SemSymbol * symbolIn);
 	SemSymbol * getSymbol() const { return mySymbol; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	Opd * flatten(Procedure * proc) override;
+	void store(Procedure * proc, Opd * src) override;
 private:
 	std::string name;
 	SemSymbol * mySymbol = nullptr;
@@ -101,9 +199,14 @@ class RefNode : public LValNode{
 public:
 	RefNode(size_t l, size_t c, IDNode * id)
 	: LValNode(l, c), myID(id){ }
+	~RefNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 
 	virtual bool nameAnalysis(SymbolTable *) override;
+	Opd * flatten(Procedure * proc) override;
+	void store(Procedure * proc, Opd * src) override;
 private:
 	IDNode * myID;
 };
@@ -112,8 +215,14 @@ class DerefNode : public LValNode{
 public:
 	DerefNode(size_t l, size_t c, IDNode * id)
 	: LValNode(l, c), myID(id){ }
+	~DerefNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual bool nameAnalysis(SymbolTable *) override;
+	Opd * flatten(Procedure * proc) override;
+	bool hasEffects() const override;
+	void store(Procedure * proc, Opd * src) override;
 private:
 	IDNode * myID;
 };
@@ -122,8 +231,15 @@ class IndexNode : public LValNode{
 public:
 	IndexNode(size_t l, size_t c, IDNode * id, ExpNode * offset)
 	: LValNode(l, c), myBase(id), myOffset(offset){ }
+	~IndexNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
+	Opd * flatten(Procedure * proc) override;
+	ExpNode * fold(TypeAnalysis * ta) override;
+	bool hasEffects() const override;
+	void store(Procedure * proc, Opd * src) override;
 private:
 	IDNode * myBase;
 	ExpNode * myOffset;
@@ -143,6 +259,8 @@ public:
 	CharTypeNode(size_t lIn, size_t cIn, bool isPtrIn)
 	: TypeNode(lIn, cIn), isPtr(isPtrIn){}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual DataType * getType() override;
 private:
 	bool isPtr;
@@ -153,23 +271,47 @@ public:
 	StmtNode(size_t lIn, size_t cIn) : ASTNode(lIn, cIn){ }
 	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *);
+	virtual void to3AC(Procedure * proc) = 0;
+	//Fold the statement's expressions. A statement that
+	// should go moves what takes its place, if anything, into
+	// replacement and returns false.
+	virtual bool fold(TypeAnalysis * ta,
+	  std::list<StmtNode *>& replacement){ return true; }
 };
 
 class DeclNode : public StmtNode{
 public:
 	DeclNode(size_t l, size_t c) : StmtNode(l, c){ }
 	void unparse(std::ostream& out, int indent) override = 0;
+	//Name analysis of a top-level declaration, split into
+	// the part that binds names in the global scope and the
+	// part that only reads it (see ProgramNode)
+	virtual bool nameAnalysisDecl(SymbolTable * symTab){
+		return nameAnalysis(symTab);
+	}
+	virtual bool nameAnalysisBody(SymbolTable * symTab){
+		return true;
+	}
+	//The name being declared
+	virtual IDNode * ID() const = 0;
+	//Lower a top-level declaration
+	virtual void to3ACGlobal(IRProgram * prog) = 0;
 };
 
 class VarDeclNode : public DeclNode{
 public:
 	VarDeclNode(size_t lIn, size_t cIn, TypeNode * typeIn, IDNode * IDIn)
 	: DeclNode(lIn, cIn), myType(typeIn), myID(IDIn){ }
+	~VarDeclNode();
 	void unparse(std::ostream& out, int indent) override;
-	IDNode * ID(){ return myID; }
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	IDNode * ID() const override { return myID; }
 	TypeNode * getTypeNode(){ return myType; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void to3AC(Procedure * proc) override;
+	void to3ACGlobal(IRProgram * prog) override;
 private:
 	TypeNode * myType;
 	IDNode * myID;
@@ -180,7 +322,10 @@ public:
 	FormalDeclNode(size_t lIn, size_t cIn, TypeNode * type, IDNode * id) 
 	: VarDeclNode(lIn, cIn, type, id){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void to3AC(Procedure * proc) override;
 };
 
 class FnDeclNode : public DeclNode{
@@ -192,16 +337,27 @@ public:
 	: DeclNode(lIn, cIn), 
 	  myID(idIn), myRetType(retTypeIn),
 	  myFormals(formalsIn), myBody(bodyIn){ }
-	IDNode * ID() const { return myID; }
+	IDNode * ID() const override { return myID; }
 	std::list<FormalDeclNode *> * getFormals() const{
 		return myFormals;
 	}
 	virtual TypeNode * getRetTypeNode() { 
 		return myRetType;
 	}
+	~FnDeclNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
+	virtual bool nameAnalysisDecl(SymbolTable * symTab) override;
+	virtual bool nameAnalysisBody(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
+	void to3ACGlobal(IRProgram * prog) override;
+	//Lower the function into proc, made for it
+	void to3ACProc(Procedure * proc);
 private:
 	IDNode * myID;
 	TypeNode * myRetType;
@@ -213,9 +369,15 @@ class AssignStmtNode : public StmtNode{
 public:
 	AssignStmtNode(size_t l, size_t c, AssignExpNode * expIn)
 	: StmtNode(l, c), myExp(expIn){ }
+	~AssignStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
 private:
 	AssignExpNode * myExp;
 };
@@ -224,9 +386,15 @@ class FromConsoleStmtNode : public StmtNode{
 public:
 	FromConsoleStmtNode(size_t l, size_t c, LValNode * dstIn)
 	: StmtNode(l, c), myDst(dstIn){ }
+	~FromConsoleStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
 private:
 	LValNode * myDst;
 };
@@ -235,9 +403,15 @@ class ToConsoleStmtNode : public StmtNode{
 public:
 	ToConsoleStmtNode(size_t l, size_t c, ExpNode * srcIn)
 	: StmtNode(l, c), mySrc(srcIn){ }
+	~ToConsoleStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
 private:
 	ExpNode * mySrc;
 };
@@ -246,9 +420,15 @@ class PostDecStmtNode : public StmtNode{
 public:
 	PostDecStmtNode(size_t l, size_t c, LValNode * lvalIn)
 	: StmtNode(l, c), myLVal(lvalIn){ }
+	~PostDecStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
 private:
 	LValNode * myLVal;
 };
@@ -257,9 +437,15 @@ class PostIncStmtNode : public StmtNode{
 public:
 	PostIncStmtNode(size_t l, size_t c, LValNode * lvalIn)
 	: StmtNode(l, c), myLVal(lvalIn){ }
+	~PostIncStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
 private:
 	LValNode * myLVal;
 };
@@ -269,9 +455,15 @@ public:
 	IfStmtNode(size_t l, size_t c, ExpNode * condIn,
 	  std::list<StmtNode *> * bodyIn)
 	: StmtNode(l, c), myCond(condIn), myBody(bodyIn){ }
+	~IfStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *ta) override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
 private:
 	ExpNode * myCond;
 	std::list<StmtNode *> * myBody;
@@ -284,9 +476,15 @@ public:
 	  std::list<StmtNode *> * bodyFalseIn)
 	: StmtNode(l, c), myCond(condIn),
 	  myBodyTrue(bodyTrueIn), myBodyFalse(bodyFalseIn) { }
+	~IfElseStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *)override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
 private:
 	ExpNode * myCond;
 	std::list<StmtNode *> * myBodyTrue;
@@ -298,9 +496,15 @@ public:
 	WhileStmtNode(size_t l, size_t c, ExpNode * condIn, 
 	  std::list<StmtNode *> * bodyIn)
 	: StmtNode(l, c), myCond(condIn), myBody(bodyIn){ }
+	~WhileStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *ta) override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
 private:
 	ExpNode * myCond;
 	std::list<StmtNode *> * myBody;
@@ -310,9 +514,15 @@ class ReturnStmtNode : public StmtNode{
 public:
 	ReturnStmtNode(size_t l, size_t c, ExpNode * exp)
 	: StmtNode(l, c), myExp(exp){ }
+	~ReturnStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *)override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
 private:
 	ExpNode * myExp;
 };
@@ -322,9 +532,15 @@ public:
 	CallExpNode(size_t l, size_t c, IDNode * id,
 	  std::list<ExpNode *> * argsIn)
 	: ExpNode(l, c), myID(id), myArgs(argsIn){ }
+	~CallExpNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	Opd * flatten(Procedure * proc) override;
+	ExpNode * fold(TypeAnalysis * ta) override;
+	bool hasEffects() const override;
 private:
 	IDNode * myID;
 	std::list<ExpNode *> * myArgs;
@@ -334,9 +550,14 @@ class BinaryExpNode : public ExpNode{
 public:
 	BinaryExpNode(size_t lIn, size_t cIn, ExpNode * lhs, ExpNode * rhs)
 	: ExpNode(lIn, cIn), myExp1(lhs), myExp2(rhs) { }
+	~BinaryExpNode();
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual OpKind getOp() const = 0;
 
+	virtual Opd * flatten(Procedure * proc) override;
+	ExpNode * fold(TypeAnalysis * ta) override;
+	bool hasEffects() const override;
 protected:
 	ExpNode * myExp1;
 	ExpNode * myExp2;
@@ -347,7 +568,9 @@ public:
 	PlusNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *)override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return PLUS_OP; }
 };
 
 class MinusNode : public BinaryExpNode{
@@ -355,7 +578,9 @@ public:
 	MinusNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *)override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return MINUS_OP; }
 };
 
 class TimesNode : public BinaryExpNode{
@@ -363,7 +588,9 @@ public:
 	TimesNode(size_t l, size_t c, ExpNode * e1In, ExpNode * e2In)
 	: BinaryExpNode(l, c, e1In, e2In){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *)override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return TIMES_OP; }
 };
 
 class DivideNode : public BinaryExpNode{
@@ -371,7 +598,9 @@ public:
 	DivideNode(size_t lIn, size_t cIn, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(lIn, cIn, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *)override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return DIVIDE_OP; }
 };
 
 class AndNode : public BinaryExpNode{
@@ -379,7 +608,10 @@ public:
 	AndNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *)override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return AND_OP; }
+	Opd * flatten(Procedure * proc) override;
 };
 
 class OrNode : public BinaryExpNode{
@@ -387,7 +619,10 @@ public:
 	OrNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *)override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return OR_OP; }
+	Opd * flatten(Procedure * proc) override;
 };
 
 class EqualsNode : public BinaryExpNode{
@@ -395,7 +630,9 @@ public:
 	EqualsNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *)override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return EQUALS_OP; }
 };
 
 class NotEqualsNode : public BinaryExpNode{
@@ -403,6 +640,9 @@ public:
 	NotEqualsNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return NOT_EQUALS_OP; }
 };
 
 class LessNode : public BinaryExpNode{
@@ -411,7 +651,9 @@ public:
 		ExpNode * exp1, ExpNode * exp2)
 	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return LESS_OP; }
 };
 
 class LessEqNode : public BinaryExpNode{
@@ -419,7 +661,9 @@ public:
 	LessEqNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return LESS_EQ_OP; }
 };
 
 class GreaterNode : public BinaryExpNode{
@@ -428,7 +672,9 @@ public:
 		ExpNode * exp1, ExpNode * exp2)
 	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return GREATER_OP; }
 };
 
 class GreaterEqNode : public BinaryExpNode{
@@ -436,7 +682,9 @@ public:
 	GreaterEqNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	virtual void typeAnalysis(TypeAnalysis *) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
+	OpKind getOp() const override { return GREATER_EQ_OP; }
 };
 
 class UnaryExpNode : public ExpNode {
@@ -445,8 +693,14 @@ public:
 	: ExpNode(lIn, cIn){
 		this->myExp = expIn;
 	}
+	~UnaryExpNode();
 	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
+	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual OpKind getOp() const = 0;
+	virtual Opd * flatten(Procedure * proc) override;
+	ExpNode * fold(TypeAnalysis * ta) override;
+	bool hasEffects() const override;
 protected:
 	ExpNode * myExp;
 };
@@ -456,8 +710,10 @@ public:
 	NegNode(size_t l, size_t c, ExpNode * exp)
 	: UnaryExpNode(l, c, exp){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
-	virtual void typeAnalysis(TypeAnalysis *) override;
+	OpKind getOp() const override { return NEG_OP; }
 };
 
 class NotNode : public UnaryExpNode{
@@ -465,14 +721,18 @@ public:
 	NotNode(size_t lIn, size_t cIn, ExpNode * exp)
 	: UnaryExpNode(lIn, cIn, exp){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
-	virtual void typeAnalysis(TypeAnalysis *) override;
+	OpKind getOp() const override { return NOT_OP; }
 };
 
 class VoidTypeNode : public TypeNode{ // not needed
 public:
 	VoidTypeNode(size_t l, size_t c) : TypeNode(l, c){}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual DataType * getType() override { 
 		return BasicType::VOID(); 
 	}
@@ -482,6 +742,8 @@ class IntTypeNode : public TypeNode{ // not needed
 public:
 	IntTypeNode(size_t l, size_t c, bool ptrIn): TypeNode(l, c), isPtr(ptrIn){}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual DataType * getType() override;
 private:
 	const bool isPtr;
@@ -491,6 +753,8 @@ class BoolTypeNode : public TypeNode{ // not needed
 public:
 	BoolTypeNode(size_t l, size_t c, bool ptrIn): TypeNode(l, c), isPtr(ptrIn) { }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	virtual DataType * getType() override;
 private:
 	const bool isPtr;
@@ -501,9 +765,15 @@ class AssignExpNode : public ExpNode{
 public:
 	AssignExpNode(size_t l, size_t c, LValNode * dstIn, ExpNode * srcIn)
 	: ExpNode(l, c), myDst(dstIn), mySrc(srcIn){ }
+	~AssignExpNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	Opd * flatten(Procedure * proc) override;
+	ExpNode * fold(TypeAnalysis * ta) override;
+	bool hasEffects() const override;
 private:
 	LValNode * myDst;
 	ExpNode * mySrc;
@@ -517,8 +787,12 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	Opd * flatten(Procedure * proc) override;
+	int getNum() const { return myNum; }
 private:
 	const int myNum;
 };
@@ -531,8 +805,11 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable *) override;
 	// virtual void typeAnalysis(TypeAnalysis *) override;
+	Opd * flatten(Procedure * proc) override;
 private:
 	 const std::string myStr;
 };
@@ -545,8 +822,12 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	Opd * flatten(Procedure * proc) override;
+	char getVal() const { return myVal; }
 private:
 	 const char myVal;
 };
@@ -558,8 +839,11 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable *) override;
 	// virtual void typeAnalysis(TypeAnalysis *) override;
+	Opd * flatten(Procedure * proc) override;
 };
 
 class TrueNode : public ExpNode{
@@ -569,8 +853,11 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	Opd * flatten(Procedure * proc) override;
 };
 
 class FalseNode : public ExpNode{
@@ -580,17 +867,26 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	Opd * flatten(Procedure * proc) override;
 };
 
 class CallStmtNode : public StmtNode{
 public:
 	CallStmtNode(size_t l, size_t c, CallExpNode * expIn)
 	: StmtNode(l, c), myCallExp(expIn){ }
+	~CallStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter *) override;
+	uint64_t computeHash() override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void to3AC(Procedure * proc) override;
+	bool fold(TypeAnalysis * ta, std::list<StmtNode *>& replacement)
+	  override;
 private:
 	CallExpNode * myCallExp;
 };
@@ -0,0 +1,203 @@
+#include <map>
+
+#include "cfg.hpp"
+#include "errors.hpp"
+
+namespace holeyc{
+
+CFG::CFG(const Procedure * proc) : myProc(proc){
+	const auto& quads = proc->getQuads();
+	size_t count = quads.size();
+	if (count == 0){
+		throw new InternalError("CFG of an empty procedure");
+	}
+
+	std::map<const Label *, size_t> targets;
+	for (size_t i = 0; i < count; i++){
+		if (quads[i]->getLabel() != nullptr){
+			targets[quads[i]->getLabel()] = i;
+		}
+	}
+	std::vector<bool> leader(count, false);
+	leader[0] = true;
+	for (size_t i = 0; i < count; i++){
+		const Quad * quad = quads[i].get();
+		Label * target = quad->getJumpTarget();
+		if (target == nullptr && quad->fallsThrough()){ continue; }
+		if (target != nullptr){
+			auto found = targets.find(target);
+			if (found == targets.end()){
+				throw new InternalError("Jump to a missing label");
+			}
+			leader[found->second] = true;
+		}
+		if (i + 1 < count){ leader[i + 1] = true; }
+	}
+
+	myBlockOf.resize(count);
+	for (size_t i = 0; i < count; i++){
+		if (leader[i]){
+			if (!myBlocks.empty()){ myBlocks.back().myEnd = i; }
+			myBlocks.push_back(BasicBlock(myBlocks.size(), i, count));
+		}
+		myBlockOf[i] = myBlocks.size() - 1;
+	}
+
+	myExit = myBlocks.size() - 1;
+	for (BasicBlock& block : myBlocks){
+		const Quad * last = quads[block.myEnd - 1].get();
+		if (last->fallsThrough() && block.myEnd < count){
+			block.mySuccs.push_back(block.myID + 1);
+		}
+		if (last->getJumpTarget() != nullptr){
+			size_t target = myBlockOf[targets[last->getJumpTarget()]];
+			//A conditional jump to the next quad is one edge
+			if (block.mySuccs.empty() || block.mySuccs[0] != target){
+				block.mySuccs.push_back(target);
+			}
+		}
+		if (!last->fallsThrough() && last->getJumpTarget() == nullptr){
+			myExit = block.myID;
+		}
+	}
+	for (const BasicBlock& block : myBlocks){
+		for (size_t succ : block.mySuccs){
+			myBlocks[succ].myPreds.push_back(block.myID);
+		}
+	}
+
+	//Depth-first from the entry, with an explicit stack so
+	// that long chains of blocks can't overflow the call stack.
+	// Successors are taken last first: a while loop's exit is
+	// then finished before its body, which puts the body
+	// first in reverse postorder, and dataflow over it settles
+	// before anything after the loop is looked at.
+	myReachable.assign(myBlocks.size(), false);
+	std::vector<size_t> post;
+	post.reserve(myBlocks.size());
+	std::vector<std::pair<size_t, size_t>> stack;
+	stack.emplace_back(0, 0);
+	myReachable[0] = true;
+	while (!stack.empty()){
+		size_t id = stack.back().first;
+		size_t& next = stack.back().second;
+		const std::vector<size_t>& succs = myBlocks[id].mySuccs;
+		if (next < succs.size()){
+			size_t succ = succs[succs.size() - 1 - next++];
+			if (!myReachable[succ]){
+				myReachable[succ] = true;
+				stack.emplace_back(succ, 0);
+			}
+		} else {
+			post.push_back(id);
+			stack.pop_back();
+		}
+	}
+	myOrder.assign(post.rbegin(), post.rend());
+	for (size_t id = 0; id < myBlocks.size(); id++){
+		if (!myReachable[id]){ myOrder.push_back(id); }
+	}
+}
+
+static void idList(std::ostream& out, const std::vector<size_t>& ids){
+	for (size_t id : ids){ out << " " << id; }
+}
+
+void CFG::toString(std::ostream& out) const{
+	for (const BasicBlock& block : myBlocks){
+		out << "[BLOCK " << block.getID() << "] preds:";
+		idList(out, block.preds());
+		out << " succs:";
+		idList(out, block.succs());
+		out << "\n";
+		for (size_t i = block.first(); i < block.end(); i++){
+			out << quad(i)->toString() << "\n";
+		}
+	}
+}
+
+//Cooper, Harvey and Kennedy's "A Simple, Fast Dominance
+// Algorithm": iterate idom(b) = the common dominator of b's
+// processed predecessors, over the blocks in reverse
+// postorder, which needs only a pass or two unless loops
+// are deeply nested.
+const size_t DomTree::NONE;
+
+DomTree::DomTree(const CFG& cfg){
+	size_t count = cfg.size();
+	const std::vector<size_t>& order = cfg.order();
+	std::vector<size_t> rank(count);
+	for (size_t i = 0; i < count; i++){ rank[order[i]] = i; }
+	auto common = [&](size_t a, size_t b){
+		while (a != b){
+			while (rank[a] > rank[b]){ a = myIDom[a]; }
+			while (rank[b] > rank[a]){ b = myIDom[b]; }
+		}
+		return a;
+	};
+
+	myIDom.assign(count, NONE);
+	myIDom[cfg.entry()] = cfg.entry();
+	bool changed = true;
+	while (changed){
+		changed = false;
+		for (size_t i = 1; i < count && cfg.reachable(order[i]); i++){
+			size_t id = order[i];
+			size_t idom = NONE;
+			for (size_t pred : cfg.block(id).preds()){
+				if (myIDom[pred] == NONE){ continue; }
+				idom = idom == NONE ? pred : common(pred, idom);
+			}
+			if (idom != myIDom[id]){
+				myIDom[id] = idom;
+				changed = true;
+			}
+		}
+	}
+	myIDom[cfg.entry()] = NONE;
+
+	myChildren.resize(count);
+	myFrontier.resize(count);
+	for (size_t id = 0; id < count; id++){
+		if (myIDom[id] != NONE){ myChildren[myIDom[id]].push_back(id); }
+	}
+	for (size_t id = 0; id < count; id++){
+		const std::vector<size_t>& preds = cfg.block(id).preds();
+		if (!cfg.reachable(id) || preds.size() < 2){ continue; }
+		for (size_t pred : preds){
+			if (!cfg.reachable(pred)){ continue; }
+			for (size_t up = pred; up != myIDom[id]; up = myIDom[up]){
+				std::vector<size_t>& frontier = myFrontier[up];
+				if (frontier.empty() || frontier.back() != id){
+					frontier.push_back(id);
+				}
+			}
+		}
+	}
+
+	myEnter.assign(count, NONE);
+	myLeave.assign(count, NONE);
+	size_t clock = 0;
+	std::vector<std::pair<size_t, size_t>> stack;
+	stack.emplace_back(cfg.entry(), 0);
+	myEnter[cfg.entry()] = clock++;
+	while (!stack.empty()){
+		size_t id = stack.back().first;
+		size_t& next = stack.back().second;
+		if (next < myChildren[id].size()){
+			size_t child = myChildren[id][next++];
+			myEnter[child] = clock++;
+			stack.emplace_back(child, 0);
+		} else {
+			myLeave[id] = clock++;
+			stack.pop_back();
+		}
+	}
+}
+
+bool DomTree::dominates(size_t a, size_t b) const{
+	if (myEnter[a] == NONE || myEnter[b] == NONE){ return false; }
+	return myEnter[a] <= myEnter[b] && myLeave[b] <= myLeave[a];
+}
+
+}
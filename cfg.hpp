@@ -0,0 +1,100 @@
+#ifndef HOLEYC_CFG_HPP
+#define HOLEYC_CFG_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "3ac.hpp"
+
+namespace holeyc{
+
+//A run of quads that control only enters at the top of and
+// only leaves from the bottom of
+class BasicBlock{
+public:
+	size_t getID() const { return myID; }
+	//The block is quads [first(), end()) of the procedure
+	size_t first() const { return myFirst; }
+	size_t end() const { return myEnd; }
+	const std::vector<size_t>& succs() const { return mySuccs; }
+	const std::vector<size_t>& preds() const { return myPreds; }
+private:
+	friend class CFG;
+	BasicBlock(size_t id, size_t first, size_t end)
+	: myID(id), myFirst(first), myEnd(end){ }
+	size_t myID;
+	size_t myFirst;
+	size_t myEnd;
+	std::vector<size_t> mySuccs;
+	std::vector<size_t> myPreds;
+};
+
+//The control-flow graph of one procedure. A block starts at
+// the first quad, at every quad that is jumped to, and after
+// every jump; lowering only jumps for if, if-else, while and
+// return statements and for && and ||, so those are where
+// blocks split. Blocks are numbered in quad order, so the
+// entry is block 0. The procedure must outlive its graph.
+class CFG{
+public:
+	CFG(const Procedure * proc);
+	const Procedure * getProc() const { return myProc; }
+	size_t size() const { return myBlocks.size(); }
+	const BasicBlock& block(size_t id) const { return myBlocks[id]; }
+	const Quad * quad(size_t index) const {
+		return myProc->getQuads()[index].get();
+	}
+	//The block quad index is in
+	size_t blockOf(size_t index) const { return myBlockOf[index]; }
+	size_t entry() const { return 0; }
+	//The block of the leave quad
+	size_t exit() const { return myExit; }
+	//The blocks reachable from the entry, in reverse postorder
+	// (so, outside of loops, a block comes after those that
+	// lead to it), then the unreachable ones
+	const std::vector<size_t>& order() const { return myOrder; }
+	bool reachable(size_t id) const { return myReachable[id]; }
+	void toString(std::ostream& out) const;
+private:
+	const Procedure * myProc;
+	std::vector<BasicBlock> myBlocks;
+	std::vector<size_t> myBlockOf;
+	size_t myExit;
+	std::vector<size_t> myOrder;
+	std::vector<bool> myReachable;
+};
+
+//The dominator tree of a CFG. Block a dominates block b if
+// every path from the entry to b goes through a; the tree
+// links each block to its closest strict dominator. Only
+// reachable blocks are in the tree.
+class DomTree{
+public:
+	static const size_t NONE = SIZE_MAX;
+	DomTree(const CFG& cfg);
+	//The immediate dominator of a block, or NONE for the
+	// entry and unreachable blocks
+	size_t idom(size_t id) const { return myIDom[id]; }
+	const std::vector<size_t>& children(size_t id) const {
+		return myChildren[id];
+	}
+	bool dominates(size_t a, size_t b) const;
+	//The blocks where a's dominance ends: those that a
+	// dominates a predecessor of, but not strictly the block
+	const std::vector<size_t>& frontier(size_t id) const {
+		return myFrontier[id];
+	}
+private:
+	std::vector<size_t> myIDom;
+	std::vector<std::vector<size_t>> myChildren;
+	std::vector<std::vector<size_t>> myFrontier;
+	//When a depth-first walk of the tree enters and leaves
+	// each block
+	std::vector<size_t> myEnter;
+	std::vector<size_t> myLeave;
+};
+
+}
+
+#endif
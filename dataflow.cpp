@@ -0,0 +1,359 @@
+#include <functional>
+#include <map>
+#include <queue>
+#include <tuple>
+
+#include "dataflow.hpp"
+#include "errors.hpp"
+
+namespace holeyc{
+
+BitSet::BitSet(size_t size, bool full)
+: myWords((size + 63) / 64, 0), mySize(size){
+	if (full){ fill(); }
+}
+
+void BitSet::clear(){
+	for (uint64_t& word : myWords){ word = 0; }
+}
+
+void BitSet::fill(){
+	for (uint64_t& word : myWords){ word = ~uint64_t(0); }
+	//Keep the bits past the end clear, so that equal sets
+	// have equal words
+	if (mySize % 64 != 0){
+		myWords.back() = (uint64_t(1) << (mySize % 64)) - 1;
+	}
+}
+
+size_t BitSet::count() const{
+	size_t res = 0;
+	for (uint64_t word : myWords){
+		res += static_cast<size_t>(__builtin_popcountll(word));
+	}
+	return res;
+}
+
+//The loops below OR the changes into one word rather than
+// comparing as they go, which keeps them branch-free
+bool BitSet::unionWith(const BitSet& other){
+	uint64_t changed = 0;
+	uint64_t * dst = myWords.data();
+	const uint64_t * src = other.myWords.data();
+	for (size_t w = 0, n = myWords.size(); w < n; w++){
+		uint64_t val = dst[w] | src[w];
+		changed |= val ^ dst[w];
+		dst[w] = val;
+	}
+	return changed != 0;
+}
+
+bool BitSet::intersectWith(const BitSet& other){
+	uint64_t changed = 0;
+	uint64_t * dst = myWords.data();
+	const uint64_t * src = other.myWords.data();
+	for (size_t w = 0, n = myWords.size(); w < n; w++){
+		uint64_t val = dst[w] & src[w];
+		changed |= val ^ dst[w];
+		dst[w] = val;
+	}
+	return changed != 0;
+}
+
+bool BitSet::transfer(const BitSet& in, const BitSet& gen,
+	const BitSet& kill){
+	uint64_t changed = 0;
+	uint64_t * dst = myWords.data();
+	const uint64_t * i = in.myWords.data();
+	const uint64_t * g = gen.myWords.data();
+	const uint64_t * k = kill.myWords.data();
+	for (size_t w = 0, n = myWords.size(); w < n; w++){
+		uint64_t val = g[w] | (i[w] & ~k[w]);
+		changed |= val ^ dst[w];
+		dst[w] = val;
+	}
+	return changed != 0;
+}
+
+void BitSet::subtract(const BitSet& other){
+	for (size_t w = 0; w < myWords.size(); w++){
+		myWords[w] &= ~other.myWords[w];
+	}
+}
+
+Variables::Variables(const CFG& cfg){
+	const IRProgram * prog = cfg.getProc()->getProg();
+	std::vector<Opd *> uses;
+	//The block each variable was last written in, plus one
+	std::unordered_map<const Opd *, size_t> written;
+	for (size_t b = 0; b < cfg.size(); b++){
+		const BasicBlock& block = cfg.block(b);
+		for (size_t i = block.first(); i < block.end(); i++){
+			const Quad * quad = cfg.quad(i);
+			uses.clear();
+			quad->getUses(uses);
+			for (const Opd * use : uses){
+				if (use->isConst()){ continue; }
+				auto found = written.find(use);
+				if (found == written.end() || found->second != b + 1
+				    || prog->isEscaping(use)){
+					add(use);
+				}
+			}
+			const Opd * def = quad->getDef();
+			if (def != nullptr){
+				written[def] = b + 1;
+				if (prog->isEscaping(def)){ add(def); }
+			}
+		}
+	}
+	myEscaping = BitSet(myOpds.size());
+	for (size_t id = 0; id < myOpds.size(); id++){
+		if (prog->isEscaping(myOpds[id])){ myEscaping.set(id); }
+	}
+}
+
+size_t Variables::add(const Opd * opd){
+	auto found = myIDs.find(opd);
+	if (found != myIDs.end()){ return found->second; }
+	size_t id = myOpds.size();
+	myOpds.push_back(opd);
+	myIDs.emplace(opd, id);
+	return id;
+}
+
+long Variables::find(const Opd * opd) const{
+	auto found = myIDs.find(opd);
+	if (found == myIDs.end()){ return -1; }
+	return static_cast<long>(found->second);
+}
+
+Dataflow::Dataflow(const CFG& cfg, size_t universe, FlowDirection dir,
+	FlowMeet meet)
+: myCFG(cfg), myUniverse(universe),
+  myGen(cfg.size(), BitSet(universe)), myKill(cfg.size(), BitSet(universe)),
+  myBoundary(universe), myDir(dir), myMeet(meet){ }
+
+void Dataflow::solve(){
+	size_t count = myCFG.size();
+	bool forward = myDir == FORWARD;
+	//before is what flows in from the neighbours, after is
+	// what the block passes on
+	std::vector<BitSet>& before = forward ? myIn : myOut;
+	std::vector<BitSet>& after = forward ? myOut : myIn;
+	before.assign(count, BitSet(myUniverse));
+	after.assign(count, BitSet(myUniverse, myMeet == INTERSECTION));
+	myVisits = 0;
+
+	//The worklist always hands out the pending block that
+	// comes first in reverse postorder (last, going backward).
+	// Blocks then mostly see their neighbours' final values
+	// first, and a loop settles before the blocks after it
+	// are looked at again, rather than each loop sending a
+	// fresh wave down the rest of the function.
+	const std::vector<size_t>& order = myCFG.order();
+	std::vector<size_t> rank(count);
+	for (size_t i = 0; i < count; i++){
+		rank[order[i]] = forward ? i : count - 1 - i;
+	}
+	std::priority_queue<size_t, std::vector<size_t>,
+		std::greater<size_t>> work;
+	for (size_t i = 0; i < count; i++){ work.push(i); }
+	std::vector<bool> queued(count, true);
+
+	while (!work.empty()){
+		size_t b = order[forward ? work.top() : count - 1 - work.top()];
+		work.pop();
+		queued[b] = false;
+		myVisits++;
+
+		const BasicBlock& block = myCFG.block(b);
+		const std::vector<size_t>& from = forward ? block.preds() : block.succs();
+		const std::vector<size_t>& to = forward ? block.succs() : block.preds();
+		BitSet& meet = before[b];
+		if (from.empty()){
+			meet = myBoundary;
+		} else {
+			meet = after[from[0]];
+			for (size_t i = 1; i < from.size(); i++){
+				if (myMeet == UNION){
+					meet.unionWith(after[from[i]]);
+				} else {
+					meet.intersectWith(after[from[i]]);
+				}
+			}
+		}
+		//Every block starts on the worklist, so a block whose
+		// result stays the same has nothing new to pass on
+		if (!after[b].transfer(meet, myGen[b], myKill[b])){
+			continue;
+		}
+		for (size_t next : to){
+			if (!queued[next]){
+				queued[next] = true;
+				work.push(rank[next]);
+			}
+		}
+	}
+}
+
+Liveness::Liveness(const CFG& cfg, const Variables& vars)
+: Dataflow(cfg, vars.size(), BACKWARD, UNION), myVars(vars){
+	std::vector<Opd *> uses;
+	for (size_t b = 0; b < cfg.size(); b++){
+		const BasicBlock& block = cfg.block(b);
+		BitSet& gen = myGen[b];
+		BitSet& kill = myKill[b];
+		for (size_t i = block.end(); i-- > block.first(); ){
+			const Quad * quad = cfg.quad(i);
+			long def = quad->getDef() == nullptr ? -1 : vars.find(quad->getDef());
+			if (def >= 0){
+				gen.reset(static_cast<size_t>(def));
+				kill.set(static_cast<size_t>(def));
+			}
+			uses.clear();
+			quad->getUses(uses);
+			for (const Opd * use : uses){
+				long id = vars.find(use);
+				if (id >= 0){ gen.set(static_cast<size_t>(id)); }
+			}
+			if (quad->readsMemory()){
+				gen.unionWith(vars.escaping());
+			}
+		}
+	}
+	solve();
+}
+
+ReachingDefs::ReachingDefs(const CFG& cfg, const Variables& vars)
+: Dataflow(cfg, 0, FORWARD, UNION), myVars(vars), myVarSites(vars.size()){
+	size_t quads = cfg.getProc()->getQuads().size();
+	mySiteOf.assign(quads, -1);
+	for (size_t i = 0; i < quads; i++){
+		const Quad * quad = cfg.quad(i);
+		long def = quad->getDef() == nullptr ? -1 : vars.find(quad->getDef());
+		if (def >= 0){
+			mySiteOf[i] = static_cast<long>(mySites.size());
+			myVarSites[static_cast<size_t>(def)].push_back(mySites.size());
+			mySites.push_back(DefSite{i, quad->getDef()});
+		} else if (quad->writesMemory()){
+			mySiteOf[i] = static_cast<long>(mySites.size());
+			mySites.push_back(DefSite{i, nullptr});
+		}
+	}
+
+	myUniverse = mySites.size();
+	myBoundary = BitSet(myUniverse);
+	for (size_t b = 0; b < cfg.size(); b++){
+		myGen[b] = BitSet(myUniverse);
+		myKill[b] = BitSet(myUniverse);
+		const BasicBlock& block = cfg.block(b);
+		for (size_t i = block.first(); i < block.end(); i++){
+			step(i, myGen[b], &myKill[b]);
+		}
+	}
+	solve();
+}
+
+//The effect of quad index on the definitions reaching past
+// it: a definition of a variable replaces all others of it,
+// and a write to memory adds to them
+void ReachingDefs::step(size_t index, BitSet& gen, BitSet * kill) const{
+	long site = mySiteOf[index];
+	if (site < 0){ return; }
+	const DefSite& def = mySites[static_cast<size_t>(site)];
+	if (def.var != nullptr){
+		size_t var = static_cast<size_t>(myVars.find(def.var));
+		for (size_t other : myVarSites[var]){
+			gen.reset(other);
+			if (kill != nullptr){ kill->set(other); }
+		}
+	}
+	gen.set(static_cast<size_t>(site));
+}
+
+BitSet ReachingDefs::reachingAt(size_t index) const{
+	const BasicBlock& block = myCFG.block(myCFG.blockOf(index));
+	BitSet res = in(block.getID());
+	for (size_t i = block.first(); i < index; i++){
+		step(i, res, nullptr);
+	}
+	return res;
+}
+
+AvailableExprs::AvailableExprs(const CFG& cfg, const Variables& vars)
+: Dataflow(cfg, 0, FORWARD, INTERSECTION), myVars(vars), myUsers(vars.size()){
+	size_t quads = cfg.getProc()->getQuads().size();
+	myExprOf.assign(quads, -1);
+	std::map<std::tuple<OpKind, const Opd *, const Opd *>, size_t> ids;
+	//Only operands the analysis tracks (or constants) can be
+	// followed from block to block
+	auto tracked = [&](const Opd * opd){
+		return opd == nullptr || opd->isConst() || vars.find(opd) >= 0;
+	};
+	for (size_t i = 0; i < quads; i++){
+		Expr expr;
+		const Quad * quad = cfg.quad(i);
+		if (auto bin = dynamic_cast<const BinOpQuad *>(quad)){
+			expr = Expr{bin->getOp(), bin->getSrc1(), bin->getSrc2()};
+		} else if (auto un = dynamic_cast<const UnaryOpQuad *>(quad)){
+			expr = Expr{un->getOp(), un->getSrc(), nullptr};
+		} else {
+			continue;
+		}
+		if (!tracked(expr.src1) || !tracked(expr.src2)){ continue; }
+		auto key = std::make_tuple(expr.op, expr.src1, expr.src2);
+		auto found = ids.find(key);
+		if (found == ids.end()){
+			found = ids.emplace(key, myExprs.size()).first;
+			for (const Opd * src : {expr.src1, expr.src2}){
+				long id = src == nullptr ? -1 : vars.find(src);
+				if (id < 0){ continue; }
+				std::vector<size_t>& users = myUsers[static_cast<size_t>(id)];
+				if (users.empty() || users.back() != myExprs.size()){
+					users.push_back(myExprs.size());
+				}
+			}
+			myExprs.push_back(expr);
+		}
+		myExprOf[i] = static_cast<long>(found->second);
+	}
+
+	myUniverse = myExprs.size();
+	myBoundary = BitSet(myUniverse);
+	//The expressions that read an escaping variable
+	BitSet memoryKill(myUniverse);
+	vars.escaping().forEach([&](size_t var){
+		for (size_t expr : myUsers[var]){ memoryKill.set(expr); }
+	});
+	for (size_t b = 0; b < cfg.size(); b++){
+		BitSet& gen = myGen[b];
+		BitSet& kill = myKill[b];
+		gen = BitSet(myUniverse);
+		kill = BitSet(myUniverse);
+		const BasicBlock& block = cfg.block(b);
+		for (size_t i = block.first(); i < block.end(); i++){
+			const Quad * quad = cfg.quad(i);
+			//The operands are read before the result is written,
+			// so an expression that writes one of its own
+			// operands is killed straight away
+			if (myExprOf[i] >= 0){
+				gen.set(static_cast<size_t>(myExprOf[i]));
+			}
+			long def = quad->getDef() == nullptr ? -1 : vars.find(quad->getDef());
+			if (def >= 0){
+				for (size_t expr : myUsers[static_cast<size_t>(def)]){
+					gen.reset(expr);
+					kill.set(expr);
+				}
+			}
+			if (quad->writesMemory()){
+				gen.subtract(memoryKill);
+				kill.unionWith(memoryKill);
+			}
+		}
+	}
+	solve();
+}
+
+}
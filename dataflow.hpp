@@ -0,0 +1,181 @@
+#ifndef HOLEYC_DATAFLOW_HPP
+#define HOLEYC_DATAFLOW_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "cfg.hpp"
+
+namespace holeyc{
+
+//A set of the integers [0, size()), one bit each, packed
+// into 64-bit words. The whole-set operations work a word
+// (64 facts) at a time, in plain loops the compiler can
+// vectorize.
+class BitSet{
+public:
+	BitSet() : mySize(0){ }
+	explicit BitSet(size_t size, bool full = false);
+	size_t size() const { return mySize; }
+	bool test(size_t i) const {
+		return ((myWords[i / 64] >> (i % 64)) & 1) != 0;
+	}
+	void set(size_t i){ myWords[i / 64] |= uint64_t(1) << (i % 64); }
+	void reset(size_t i){ myWords[i / 64] &= ~(uint64_t(1) << (i % 64)); }
+	void clear();
+	void fill();
+	size_t count() const;
+	bool operator==(const BitSet& other) const {
+		return myWords == other.myWords;
+	}
+	//Each of these says whether the set changed
+	bool unionWith(const BitSet& other);
+	bool intersectWith(const BitSet& other);
+	//this = gen | (in & ~kill)
+	bool transfer(const BitSet& in, const BitSet& gen, const BitSet& kill);
+	//this &= ~other
+	void subtract(const BitSet& other);
+	//Call f on each member, in increasing order
+	template <typename F> void forEach(F f) const {
+		for (size_t w = 0; w < myWords.size(); w++){
+			uint64_t word = myWords[w];
+			while (word != 0){
+				f(w * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+				word &= word - 1;
+			}
+		}
+	}
+private:
+	std::vector<uint64_t> myWords;
+	size_t mySize;
+};
+
+//The variables of a procedure that the block-level analyses
+// track: those read in some block before that block writes
+// them, and those memory operations may touch (globals and
+// variables whose address is taken). A variable outside
+// these, such as most temporaries, is only ever live inside
+// one block, so it needs no bits.
+class Variables{
+public:
+	Variables(const CFG& cfg);
+	size_t size() const { return myOpds.size(); }
+	const Opd * opd(size_t id) const { return myOpds[id]; }
+	//The id of opd, or -1 if it isn't tracked
+	long find(const Opd * opd) const;
+	//The variables a quad that reads or writes memory may touch
+	const BitSet& escaping() const { return myEscaping; }
+private:
+	size_t add(const Opd * opd);
+	std::vector<const Opd *> myOpds;
+	std::unordered_map<const Opd *, size_t> myIDs;
+	BitSet myEscaping;
+};
+
+enum FlowDirection { FORWARD, BACKWARD };
+//How facts from several blocks combine: a fact holds if it
+// holds along any path (UNION) or along all of them
+// (INTERSECTION)
+enum FlowMeet { UNION, INTERSECTION };
+
+//A dataflow problem over the blocks of a CFG, whose facts
+// are the members of a set of fixed size. A subclass builds
+// each block's gen and kill sets and calls solve(), which
+// iterates a worklist to the fixed point of
+//   after = gen | (before & ~kill)
+// where before is the meet of the neighbours' after sets:
+// the predecessors' going forward, the successors' going
+// backward. Blocks without such neighbours start from the
+// boundary set.
+class Dataflow{
+public:
+	virtual ~Dataflow(){ }
+	const CFG& getCFG() const { return myCFG; }
+	size_t universe() const { return myUniverse; }
+	//The facts at the top and at the bottom of a block
+	const BitSet& in(size_t block) const { return myIn[block]; }
+	const BitSet& out(size_t block) const { return myOut[block]; }
+	//How many times solve() evaluated a block
+	size_t visits() const { return myVisits; }
+protected:
+	Dataflow(const CFG& cfg, size_t universe, FlowDirection dir,
+		FlowMeet meet);
+	void solve();
+
+	const CFG& myCFG;
+	size_t myUniverse;
+	std::vector<BitSet> myGen;
+	std::vector<BitSet> myKill;
+	BitSet myBoundary;
+private:
+	FlowDirection myDir;
+	FlowMeet myMeet;
+	std::vector<BitSet> myIn;
+	std::vector<BitSet> myOut;
+	size_t myVisits = 0;
+};
+
+//The tracked variables that may be read before they are
+// next written
+class Liveness : public Dataflow{
+public:
+	Liveness(const CFG& cfg, const Variables& vars);
+	const Variables& getVars() const { return myVars; }
+private:
+	const Variables& myVars;
+};
+
+//A quad that writes var, or, with var null, one that writes
+// memory and so may write any escaping variable
+struct DefSite{
+	size_t quad;
+	const Opd * var;
+};
+
+//The definitions of tracked variables that may reach a
+// point without being overwritten on the way. A variable no
+// definition reaches still holds what it did on entry.
+class ReachingDefs : public Dataflow{
+public:
+	ReachingDefs(const CFG& cfg, const Variables& vars);
+	const std::vector<DefSite>& sites() const { return mySites; }
+	//The definitions reaching the top of quad index
+	BitSet reachingAt(size_t index) const;
+private:
+	void step(size_t index, BitSet& gen, BitSet * kill) const;
+	const Variables& myVars;
+	std::vector<DefSite> mySites;
+	//Site ids by quad (or -1), and by tracked variable
+	std::vector<long> mySiteOf;
+	std::vector<std::vector<size_t>> myVarSites;
+};
+
+//An operator applied to operands (src2 is null for a unary
+// operator)
+struct Expr{
+	OpKind op;
+	const Opd * src1;
+	const Opd * src2;
+};
+
+//The expressions over tracked variables and constants that
+// have been computed on every path to a point, with none of
+// their operands written since
+class AvailableExprs : public Dataflow{
+public:
+	AvailableExprs(const CFG& cfg, const Variables& vars);
+	const std::vector<Expr>& exprs() const { return myExprs; }
+	//The expression quad index computes, or -1
+	long exprOf(size_t index) const { return myExprOf[index]; }
+private:
+	const Variables& myVars;
+	std::vector<Expr> myExprs;
+	std::vector<long> myExprOf;
+	//The expressions that use each tracked variable
+	std::vector<std::vector<size_t>> myUsers;
+};
+
+}
+
+#endif
@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+
+#include "ast.hpp"
+#include "document.hpp"
+#include "hash.hpp"
+#include "prelude.hpp"
+#include "scanner.hpp"
+#include "type_analysis.hpp"
+
+namespace holeyc{
+
+static uint64_t hashText(const std::string& text){
+	return Hasher().add(text).done();
+}
+
+//Finds where chunks may end. Chunks end at the start of a
+// line, after a complete declaration, with no declaration
+// started since: then whatever follows parses the same
+// whether or not it is cut off. Comments, strings and
+// character literals are skipped so that braces and
+// semicolons in them don't count.
+class Splitter{
+public:
+	Splitter(std::vector<std::string>& out) : myOut(out){ }
+	//Scan more text. Pieces must be whole lines, except
+	// for the last line of the text.
+	void feed(const std::string& text){
+		size_t start = 0;
+		size_t len = text.size();
+		while (start < len){
+			size_t end = text.find('\n', start);
+			end = end == std::string::npos ? len : end + 1;
+			if (clean() && mySawDecl){
+				myOut.push_back(std::move(myCurrent));
+				myCurrent.clear();
+				mySawDecl = false;
+			}
+			scanLine(text, start, end);
+			myCurrent.append(text, start, end - start);
+			start = end;
+		}
+	}
+	//Is the scan between declarations?
+	bool clean() const { return myDepth == 0 && !myPending; }
+	void finish(){
+		if (!myCurrent.empty()){
+			myOut.push_back(std::move(myCurrent));
+			myCurrent.clear();
+		}
+	}
+private:
+	void scanLine(const std::string& text, size_t pos, size_t end){
+		while (pos < end){
+			char ch = text[pos++];
+			switch (ch){
+			case '#':
+				return;
+			case '"':
+				while (pos < end && text[pos] != '"' && text[pos] != '\n'){
+					pos += text[pos] == '\\' ? 2u : 1u;
+				}
+				pos++;
+				myPending = true;
+				break;
+			case '\'':
+				if (pos < end && text[pos] == '\\'){ pos++; }
+				if (pos < end && text[pos] != '\n'){ pos++; }
+				myPending = true;
+				break;
+			case '{':
+				myDepth++;
+				myPending = true;
+				break;
+			case '}':
+				if (myDepth > 0){ myDepth--; }
+				if (myDepth == 0){ complete(); }
+				break;
+			case ';':
+				if (myDepth == 0){ complete(); }
+				break;
+			case ' ': case '\t': case '\r': case '\n':
+				break;
+			default:
+				myPending = true;
+			}
+		}
+	}
+	void complete(){
+		myPending = false;
+		mySawDecl = true;
+	}
+
+	std::vector<std::string>& myOut;
+	std::string myCurrent;
+	size_t myDepth = 0;
+	bool myPending = false;
+	bool mySawDecl = false;
+};
+
+//The offset of (line, col) in text, clamped to the end of
+// the line and of the text
+static size_t offsetOf(const std::string& text, size_t line, size_t col){
+	size_t pos = 0;
+	for (size_t l = 0; l < line; l++){
+		size_t nl = text.find('\n', pos);
+		if (nl == std::string::npos){ return text.size(); }
+		pos = nl + 1;
+	}
+	size_t lineEnd = text.find('\n', pos);
+	if (lineEnd == std::string::npos){ lineEnd = text.size(); }
+	return pos + std::min(col, lineEnd - pos);
+}
+
+ChunkAnalysis::~ChunkAnalysis(){
+	delete types;
+	delete symbols;
+	delete ast;
+}
+
+Document::Chunk Document::makeChunk(const std::string& text){
+	Chunk chunk;
+	chunk.text = text;
+	chunk.lines = static_cast<size_t>(
+		std::count(text.begin(), text.end(), '\n'));
+	if (!text.empty() && text.back() != '\n'){ chunk.lines++; }
+	chunk.textHash = hashText(text);
+	return chunk;
+}
+
+void Document::replace(const std::string& text){
+	std::vector<std::string> pieces;
+	Splitter splitter(pieces);
+	splitter.feed(text);
+	splitter.finish();
+
+	//Chunks whose text survives keep their analyses
+	std::unordered_multimap<uint64_t, Chunk> old;
+	for (Chunk& chunk : myChunks){
+		old.emplace(chunk.textHash, std::move(chunk));
+	}
+	myChunks.clear();
+	myRescanned = 0;
+	for (const std::string& piece : pieces){
+		Chunk chunk = makeChunk(piece);
+		auto range = old.equal_range(chunk.textHash);
+		for (auto it = range.first; it != range.second; ++it){
+			if (it->second.text == piece){
+				chunk.analysis = it->second.analysis;
+				old.erase(it);
+				break;
+			}
+		}
+		if (chunk.analysis == nullptr){ myRescanned++; }
+		myChunks.push_back(std::move(chunk));
+	}
+}
+
+void Document::edit(size_t startLine, size_t startCol,
+	size_t endLine, size_t endCol, const std::string& text){
+	if (myChunks.empty()){
+		replace(text);
+		return;
+	}
+	//Find the chunks holding the start and the end
+	size_t first = 0;
+	size_t firstLine = 0;
+	while (first + 1 < myChunks.size()
+		&& firstLine + myChunks[first].lines <= startLine){
+		firstLine += myChunks[first].lines;
+		first++;
+	}
+	size_t last = first;
+	size_t lastLine = firstLine;
+	while (last + 1 < myChunks.size()
+		&& lastLine + myChunks[last].lines <= endLine){
+		lastLine += myChunks[last].lines;
+		last++;
+	}
+
+	std::string region;
+	for (size_t i = first; i <= last; i++){
+		region += myChunks[i].text;
+	}
+	size_t start = offsetOf(region, startLine - firstLine, startCol);
+	size_t end = offsetOf(region, endLine - firstLine, endCol);
+	if (end < start){ end = start; }
+	region.replace(start, end - start, text);
+
+	//Rescan the region, and then as many of the following
+	// chunks as it takes to get back to a chunk boundary
+	std::vector<std::string> pieces;
+	Splitter splitter(pieces);
+	splitter.feed(region);
+	while (!splitter.clean() && last + 1 < myChunks.size()){
+		last++;
+		splitter.feed(myChunks[last].text);
+	}
+	splitter.finish();
+
+	std::vector<Chunk> fresh;
+	myRescanned = 0;
+	for (const std::string& piece : pieces){
+		Chunk chunk = makeChunk(piece);
+		for (size_t i = first; i <= last; i++){
+			if (myChunks[i].analysis != nullptr
+				&& myChunks[i].textHash == chunk.textHash
+				&& myChunks[i].text == piece){
+				chunk.analysis = std::move(myChunks[i].analysis);
+				break;
+			}
+		}
+		if (chunk.analysis == nullptr){ myRescanned++; }
+		fresh.push_back(std::move(chunk));
+	}
+	auto from = myChunks.begin() + static_cast<std::ptrdiff_t>(first);
+	auto to = myChunks.begin() + static_cast<std::ptrdiff_t>(last + 1);
+	myChunks.erase(from, to);
+	myChunks.insert(myChunks.begin() + static_cast<std::ptrdiff_t>(first),
+		std::make_move_iterator(fresh.begin()),
+		std::make_move_iterator(fresh.end()));
+}
+
+std::string Document::text() const {
+	std::string res;
+	for (const Chunk& chunk : myChunks){
+		res += chunk.text;
+	}
+	return res;
+}
+
+std::vector<std::string> Document::chunkTexts() const {
+	std::vector<std::string> res;
+	res.reserve(myChunks.size());
+	for (const Chunk& chunk : myChunks){
+		res.push_back(chunk.text);
+	}
+	return res;
+}
+
+void Document::analyse(){
+	std::shared_ptr<const ChunkAnalysis> prev;
+	uint64_t signature = 0;
+	myAnalysed = 0;
+	for (Chunk& chunk : myChunks){
+		uint64_t input = Hasher(chunk.textHash).add(signature).done();
+		if (chunk.analysis == nullptr || chunk.analysis->input != input){
+			chunk.analysis = analyseChunk(chunk, input, prev);
+			myAnalysed++;
+		}
+		prev = chunk.analysis;
+		signature = prev->signature;
+	}
+}
+
+//Parse the chunk as a program of its own. The parser
+// reports syntax errors to std::cout as well as to Report,
+// so std::cout is kept out of it.
+static ProgramNode * parseChunk(const std::string& text,
+	std::vector<Diagnostic>& diags){
+	DiagBuffer errs;
+	DiagBuffer * prevErrs = Report::redirect(&errs);
+	std::ostringstream discard;
+	std::streambuf * prevOut = std::cout.rdbuf(discard.rdbuf());
+	std::istringstream input(text);
+	ProgramNode * root = nullptr;
+	size_t line = 1;
+	size_t col = 1;
+	try {
+		Scanner scanner(&input);
+		Parser parser(scanner, &root);
+		if (parser.parse() != 0){
+			delete root;
+			root = nullptr;
+		}
+		line = scanner.getLine();
+		col = scanner.getCol();
+	} catch (...) {
+		std::cout.rdbuf(prevOut);
+		Report::redirect(prevErrs);
+		throw;
+	}
+	std::cout.rdbuf(prevOut);
+	Report::redirect(prevErrs);
+
+	for (Diagnostic diag : errs.diagnostics()){
+		//A syntax error is put where the parser gave up
+		if (!diag.located){
+			diag.located = true;
+			diag.line = line;
+			diag.col = col;
+		}
+		diags.push_back(diag);
+	}
+	return root;
+}
+
+std::shared_ptr<const ChunkAnalysis> Document::analyseChunk(
+	const Chunk& chunk, uint64_t input,
+	std::shared_ptr<const ChunkAnalysis> prev){
+	auto res = std::make_shared<ChunkAnalysis>();
+	res->input = input;
+	res->prev = prev;
+	res->ast = nullptr;
+	res->symbols = nullptr;
+	res->types = nullptr;
+	res->scope = prev != nullptr ? prev->scope
+		: Prelude::scope().enterScope();
+	res->signature = prev != nullptr ? prev->signature : 0;
+
+	try {
+		res->ast = parseChunk(chunk.text, res->diags);
+		if (res->ast == nullptr){ return res; }
+		res->symbols = new SymbolTable(res->scope);
+		res->types = TypeAnalysis::blank(res->ast);
+		DiagBuffer errs;
+		DiagBuffer * prevErrs = Report::redirect(&errs);
+		try {
+			res->ast->fusedAnalysis(res->symbols, res->types);
+		} catch (InternalError * e) {
+			res->failure = e->msg();
+			delete e;
+		} catch (ToDoError * e) {
+			res->failure = e->msg();
+			delete e;
+		}
+		Report::redirect(prevErrs);
+		res->diags.insert(res->diags.end(), errs.diagnostics().begin(),
+			errs.diagnostics().end());
+	} catch (InternalError * e) {
+		res->failure = e->msg();
+		delete e;
+	} catch (ToDoError * e) {
+		res->failure = e->msg();
+		delete e;
+	}
+	if (res->symbols == nullptr){ return res; }
+
+	//The scope after the last declaration, or, if the
+	// analysis stopped early, after the last one it got to
+	size_t declCount = res->ast->getGlobals()->size();
+	size_t snapshots = res->symbols->snapshotCount();
+	if (snapshots > 0){
+		res->scope = res->symbols->getSnapshot(
+			std::min(declCount, snapshots - 1));
+	}
+	Hasher signature(res->signature);
+	for (DeclNode * decl : *res->ast->getGlobals()){
+		const std::string& name = decl->ID()->getName();
+		signature.add(name);
+		SemSymbol * symbol = res->scope.lookup(name);
+		if (symbol == nullptr || symbol->getDataType() == nullptr){
+			continue;
+		}
+		signature.add(symbol->getKind());
+		signature.add(symbol->getDataType()->getString());
+	}
+	res->signature = signature.done();
+	return res;
+}
+
+std::vector<Diagnostic> Document::diagnostics() const {
+	std::vector<Diagnostic> res;
+	size_t line = 0;
+	for (const Chunk& chunk : myChunks){
+		if (chunk.analysis != nullptr){
+			for (Diagnostic diag : chunk.analysis->diags){
+				//Line 0 is no line at all, wherever the chunk is
+				if (diag.line != 0){ diag.line += line; }
+				res.push_back(diag);
+			}
+		}
+		line += chunk.lines;
+	}
+	return res;
+}
+
+std::vector<std::string> Document::failures() const {
+	std::vector<std::string> res;
+	for (const Chunk& chunk : myChunks){
+		if (chunk.analysis != nullptr && !chunk.analysis->failure.empty()){
+			res.push_back(chunk.analysis->failure);
+		}
+	}
+	return res;
+}
+
+}
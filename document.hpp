@@ -0,0 +1,97 @@
+#ifndef HOLEYC_DOCUMENT_HPP
+#define HOLEYC_DOCUMENT_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "errors.hpp"
+#include "symbol_table.hpp"
+
+namespace holeyc{
+
+class ProgramNode;
+class TypeAnalysis;
+
+//The analysis of one chunk of a document, against the
+// global scope left by the chunks before it. It owns the
+// chunk's AST and symbols. The AST points at symbols of
+// the analyses it was checked against, so each analysis
+// keeps the one before it alive.
+struct ChunkAnalysis{
+	~ChunkAnalysis();
+	//What the analysis depends on: the chunk's text and
+	// the signature of the globals before it
+	uint64_t input;
+	std::shared_ptr<const ChunkAnalysis> prev;
+	ProgramNode * ast;
+	SymbolTable * symbols;
+	TypeAnalysis * types;
+	//The global scope after the chunk, and the signature of
+	// its globals (the names, kinds and types declared so
+	// far, in order)
+	PersistentScopeTable scope;
+	uint64_t signature;
+	//Lines are relative to the chunk's first line
+	std::vector<Diagnostic> diags;
+	//Set if the analysis was cut short by an internal error
+	std::string failure;
+};
+
+//A source file held open for editing. The text is kept as a
+// list of chunks, each a run of whole lines holding complete
+// top-level declarations, and each parsed on its own. An
+// edit rescans only the chunks it touches, and analysing the
+// document redoes only the chunks whose text or preceding
+// globals have changed since their last analysis.
+class Document{
+public:
+	Document(const std::string& text){ replace(text); }
+	//Replace the whole text
+	void replace(const std::string& text);
+	//Replace the text from (startLine, startCol) up to
+	// (endLine, endCol). Lines and columns count from 0;
+	// columns are byte offsets into the line, and positions
+	// past the end of a line or of the text are clamped.
+	void edit(size_t startLine, size_t startCol,
+		size_t endLine, size_t endCol, const std::string& text);
+	std::string text() const;
+	//The text of each chunk, in order
+	std::vector<std::string> chunkTexts() const;
+
+	//Bring every chunk's analysis up to date
+	void analyse();
+	//Every diagnostic of the last analysis, with lines and
+	// columns counted from 1 in the whole text
+	std::vector<Diagnostic> diagnostics() const;
+	//Internal errors of the last analysis
+	std::vector<std::string> failures() const;
+
+	//What the last edit and analysis had to redo
+	size_t chunkCount() const { return myChunks.size(); }
+	size_t rescanned() const { return myRescanned; }
+	size_t analysed() const { return myAnalysed; }
+private:
+	struct Chunk{
+		std::string text;
+		size_t lines;
+		uint64_t textHash;
+		std::shared_ptr<const ChunkAnalysis> analysis;
+	};
+	//Split text, which starts at a chunk boundary, into
+	// chunks. Returns false if the text ends inside a
+	// declaration, i.e. the next chunk must be joined to it.
+	static bool split(const std::string& text, std::vector<Chunk>& out);
+	static Chunk makeChunk(const std::string& text);
+	static std::shared_ptr<const ChunkAnalysis> analyseChunk(
+		const Chunk& chunk, uint64_t input,
+		std::shared_ptr<const ChunkAnalysis> prev);
+
+	std::vector<Chunk> myChunks;
+	size_t myRescanned = 0;
+	size_t myAnalysed = 0;
+};
+
+}
+
+#endif
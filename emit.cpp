@@ -0,0 +1,141 @@
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <memory>
+#include <vector>
+#include <streambuf>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ast.hpp"
+#include "errors.hpp"
+#include "emit.hpp"
+#include "parallel.hpp"
+
+namespace holeyc{
+
+//Rough number of output bytes per source line, used to size
+// each declaration's buffer up front
+static const size_t BYTES_PER_LINE = 48;
+
+//A stream buffer that appends into a growable array. Unlike
+// a stringstream, the storage is sized once up front and
+// handed to writev as-is.
+class DeclBuffer : public std::streambuf{
+public:
+	DeclBuffer(size_t reserve) : myData(reserve < 64 ? 64 : reserve){
+		setp(myData.data(), myData.data() + myData.size());
+	}
+	const char * data() const { return pbase(); }
+	size_t size() const { return static_cast<size_t>(pptr() - pbase()); }
+protected:
+	int_type overflow(int_type ch) override{
+		if (traits_type::eq_int_type(ch, traits_type::eof())){
+			return traits_type::not_eof(ch);
+		}
+		grow(1);
+		*pptr() = traits_type::to_char_type(ch);
+		pbump(1);
+		return ch;
+	}
+	std::streamsize xsputn(const char * str, std::streamsize count) override{
+		size_t len = static_cast<size_t>(count);
+		if (static_cast<size_t>(epptr() - pptr()) < len){
+			grow(len);
+		}
+		memcpy(pptr(), str, len);
+		pbump(static_cast<int>(count));
+		return count;
+	}
+private:
+	void grow(size_t atLeast){
+		size_t used = size();
+		size_t capacity = myData.size() * 2;
+		while (capacity < used + atLeast){ capacity *= 2; }
+		myData.resize(capacity);
+		setp(myData.data(), myData.data() + myData.size());
+		pbump(static_cast<int>(used));
+	}
+	std::vector<char> myData;
+};
+
+static void writeAll(int fd, std::vector<struct iovec>& iov){
+	size_t first = 0;
+	while (first < iov.size()){
+		size_t batch = iov.size() - first;
+		if (batch > IOV_MAX){ batch = IOV_MAX; }
+		ssize_t written = writev(fd, &iov[first], static_cast<int>(batch));
+		if (written < 0 && errno == EINTR){ continue; }
+		if (written < 0){
+			throw new InternalError("Failed to write unparse output");
+		}
+		//Skip past fully-written buffers, then trim a 
+		// partially-written one
+		size_t left = static_cast<size_t>(written);
+		while (first < iov.size() && left >= iov[first].iov_len){
+			left -= iov[first].iov_len;
+			first++;
+		}
+		if (left > 0){
+			iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + left;
+			iov[first].iov_len -= left;
+		}
+	}
+}
+
+//Closes the output file however the write ends
+class OutputFile{
+public:
+	OutputFile(int fd) : myFd(fd){ }
+	~OutputFile(){
+		if (myFd != STDOUT_FILENO){ close(myFd); }
+	}
+	int fd() const { return myFd; }
+private:
+	int myFd;
+};
+
+void UnparseEmitter::emit(ProgramNode * ast, const char * outPath){
+	std::vector<DeclNode *> decls(ast->getGlobals()->begin(), 
+		ast->getGlobals()->end());
+	std::vector<std::unique_ptr<DeclBuffer>> buffers(decls.size());
+
+	Parallel::forEach(decls.size(), [&](size_t i){
+		//Guess the output size from the declaration's span
+		// of source lines
+		size_t lines = 1;
+		if (i + 1 < decls.size() 
+		    && decls[i + 1]->line() > decls[i]->line()){
+			lines += decls[i + 1]->line() - decls[i]->line();
+		}
+		buffers[i].reset(new DeclBuffer(lines * BYTES_PER_LINE));
+		std::ostream out(buffers[i].get());
+		decls[i]->unparse(out, 0);
+	});
+
+	std::vector<struct iovec> iov;
+	for (const auto& buffer : buffers){
+		if (buffer->size() == 0){ continue; }
+		struct iovec vec;
+		vec.iov_base = const_cast<char *>(buffer->data());
+		vec.iov_len = buffer->size();
+		iov.push_back(vec);
+	}
+
+	int fd = STDOUT_FILENO;
+	if (strcmp(outPath, "--") == 0){
+		std::cout << std::flush;
+	} else {
+		fd = open(outPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0){
+			std::string msg = "Bad output file ";
+			msg += outPath;
+			throw new InternalError(msg.c_str());
+		}
+	}
+	OutputFile out(fd);
+	writeAll(out.fd(), iov);
+}
+
+} //End namespace holeyc
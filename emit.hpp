@@ -0,0 +1,22 @@
+#ifndef HOLEYC_EMIT_HPP
+#define HOLEYC_EMIT_HPP
+
+#include "ast.hpp"
+
+namespace holeyc{
+
+//Writes the unparsed form of a program (for -u and -n). 
+// Each top-level declaration is formatted into its own 
+// preallocated buffer, declarations are formatted in 
+// parallel (see Parallel), and the buffers are then written
+// in order with a single writev. The output is byte-for-byte
+// what ProgramNode::unparse produces.
+class UnparseEmitter{
+public:
+	//outPath "--" means standard output
+	static void emit(ProgramNode * ast, const char * outPath);
+};
+
+}
+
+#endif
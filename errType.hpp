@@ -8,96 +8,96 @@ namespace holeyc{
 class TypeErr {
 public:
 static void writeFn(size_t line, size_t col){
-	Report::fatal(line, col, "Attempt to write a function");
+	Report::fatal(line, col, DiagCode::WRITE_FN, "Attempt to write a function");
 }
 static void writePtr(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::WRITE_PTR, 
 	  "Attempt to write a raw pointer");
 }
 static void writeVoid(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::WRITE_VOID, 
 	  "Attempt to write void");
 }
 static void readFn(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::READ_FN, 
 	  "Attempt to read a function");
 }
 static void readPtr(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::READ_PTR, 
 	  "Attempt to read an array variable");
 }
 static void callNonFn(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::CALL_NON_FN, 
 	  "Attempt to call a non-function");
 }
 static void badArgCount(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::BAD_ARG_COUNT, 
 	  "Function call with wrong number of args");
 }
 static void badArgType(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::BAD_ARG_TYPE, 
 	  "Type of actual does not match type of formal");
 }
 static bool missRetValue(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::MISSING_RET, 
 	  "Missing return value");
 	return false;
 }
 static bool extraRetValue(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::EXTRA_RET, 
 	  "Return with a value in void function");
 	return false;
 }
 static void badRetValue(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::BAD_RET, 
 	  "Bad return value");
 }
 static void badMath(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::BAD_MATH, 
 	  "Arithmetic operator applied to non-numeric operand");
 }
 static void badRelation(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::BAD_REL_OPD, 
 	  "Relational operator applied to non-numeric operand");
 }
 static void badLogic(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::BAD_LOGIC_OPD, 
 	  "Logical operator applied to non-bool operand");
 }
 static void badIf(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::BAD_IF_COND, 
 	  "Non-bool expression used as an if condition");
 }
 static void badWhile(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::BAD_WHILE_COND, 
 	  "Non-bool expression used as a while condition");
 }
 static void mismatch(size_t line, size_t col){
-	Report::fatal(line, col, "Type mismatch");
+	Report::fatal(line, col, DiagCode::TYPE_MISMATCH, "Type mismatch");
 }
 static void voidEq(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::VOID_EQ, 
 		"Equality operator applied" " to void functions");
 }
 static void fnEq(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::FN_EQ, 
 		"Equality operator applied to functions");
 }
 static void arrEq(size_t line, size_t col){
-	Report::fatal(line, col, 
+	Report::fatal(line, col, DiagCode::ARR_EQ, 
 		"Equality operator applied to arrays");
 }
 static void fnAssign(size_t line, size_t col){
-	Report::fatal(line, col, "Function assignment");
+	Report::fatal(line, col, DiagCode::FN_ASSIGN, "Function assignment");
 }
 static void arrAssign(size_t line, size_t col){
-	Report::fatal(line, col, "Array variable assignment");
+	Report::fatal(line, col, DiagCode::ARR_ASSIGN, "Array variable assignment");
 }
 static void badDeref(size_t line, size_t col){
-	Report::fatal(line, col, "Invalid operand for dereference");
+	Report::fatal(line, col, DiagCode::BAD_DEREF, "Invalid operand for dereference");
 }
 static void badVoid(size_t line, size_t col){
-	Report::fatal(line, col, "Invalid type in declaration");
+	Report::fatal(line, col, DiagCode::BAD_VAR_TYPE, "Invalid type in declaration");
 }
 
 };
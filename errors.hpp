@@ -6,7 +6,12 @@
 #define CODELOC __FILE__ ":" EXPAND1(__LINE__) " - "
 #define TODO(x) throw new ToDoError(CODELOC #x);
 
+#include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace holeyc{
 
@@ -26,40 +31,324 @@ private:
 	const char * myMsg;
 };
 
+//A stable code for every kind of diagnostic, reported with
+// it in the JSON output (--diagnostics-format=json). Codes
+// are never renumbered or reused; the hundreds digit gives
+// the phase that reports it.
+enum class DiagCode : uint16_t {
+	//Scanning
+	ILLEGAL_CHAR = 101,
+	CHAR_EMPTY_ESC = 102,
+	CHAR_EMPTY = 103,
+	CHAR_BAD_ESC = 104,
+	STR_BAD_ESC = 105,
+	STR_UNTERM = 106,
+	STR_UNTERM_BAD_ESC = 107,
+	INT_TOO_LARGE = 108,
+	SCAN_WARNING = 109,
+	SCAN_ERROR = 110,
+	//Parsing
+	SYNTAX_ERROR = 201,
+	//Name analysis
+	UNDECLARED_ID = 301,
+	BAD_VAR_TYPE = 302,
+	MULTI_DECL = 303,
+	//Type analysis
+	TEST_ERROR = 401,
+	BAD_ARG_TYPE = 402,
+	OUTPUT_FN = 403,
+	WRITE_FN = 404,
+	WRITE_PTR = 405,
+	WRITE_VOID = 406,
+	READ_FN = 407,
+	READ_PTR = 408,
+	BAD_MATH_OPD = 409,
+	BAD_MATH_OPR = 410,
+	BAD_MATH = 411,
+	BAD_REL_OPD = 412,
+	BAD_LOGIC_OPD = 413,
+	BAD_EQ_OPD = 414,
+	BAD_EQ_OPR = 415,
+	BAD_INDEX = 416,
+	BAD_PTR_BASE = 417,
+	BAD_ARG_COUNT = 418,
+	CALL_NON_FN = 419,
+	BAD_ASSIGN_OPR = 420,
+	BAD_ASSIGN_OPD = 421,
+	MISSING_RET = 422,
+	EXTRA_RET = 423,
+	BAD_RET = 424,
+	BAD_WHILE_COND = 425,
+	BAD_IF_COND = 426,
+	FN_DEREF = 427,
+	TYPE_MISMATCH = 428,
+	VOID_EQ = 429,
+	FN_EQ = 430,
+	ARR_EQ = 431,
+	FN_ASSIGN = 432,
+	ARR_ASSIGN = 433,
+	BAD_DEREF = 434,
+};
+
+enum class DiagFormat : uint8_t { TEXT, JSON };
+
+//A diagnostic as reported: what, where, how severe, and the 
+// message. The text is only put together when the 
+// diagnostic is written out.
+struct Diagnostic{
+	enum Severity : uint8_t { FATAL, WARN };
+	Severity severity;
+	DiagCode code;
+	//Diagnostics without a position (a syntax error) are
+	// written as just the message
+	bool located;
+	size_t line;
+	size_t col;
+	//A message that lives as long as the program (a string
+	// literal), or nullptr if the message is in text
+	const char * msg;
+	std::string text;
+
+	const char * message() const { 
+		return msg != nullptr ? msg : text.c_str(); 
+	}
+	const char * phase() const {
+		switch (static_cast<unsigned>(code) / 100){
+			case 1: return "scan";
+			case 2: return "parse";
+			case 3: return "name";
+			default: return "type";
+		}
+	}
+	void writeText(std::string& out) const {
+		if (located){
+			out += severity == FATAL ? "FATAL [" : "*WARNING* [";
+			out += std::to_string(line);
+			out += ",";
+			out += std::to_string(col);
+			out += "]: ";
+		}
+		out += message();
+		out += "\n";
+	}
+	void writeJSON(std::string& out) const {
+		out += "{\"phase\":\"";
+		out += phase();
+		out += "\",\"code\":\"E";
+		out += std::to_string(static_cast<unsigned>(code));
+		out += severity == FATAL ? "\",\"severity\":\"error\"" 
+			: "\",\"severity\":\"warning\"";
+		out += ",\"line\":";
+		out += std::to_string(line);
+		out += ",\"col\":";
+		out += std::to_string(col);
+		out += ",\"message\":";
+		writeJSONString(out, message());
+		out += "}\n";
+	}
+	static void writeJSONString(std::string& out, const char * str){
+		static const char hex[] = "0123456789abcdef";
+		out += '"';
+		for (const char * c = str; *c != '\0'; c++){
+			unsigned char ch = static_cast<unsigned char>(*c);
+			if (ch == '"' || ch == '\\'){
+				out += '\\';
+				out += *c;
+			} else if (ch < 0x20){
+				out += "\\u00";
+				out += hex[ch >> 4];
+				out += hex[ch & 0xf];
+			} else {
+				out += *c;
+			}
+		}
+		out += '"';
+	}
+};
+
+//Diagnostics waiting to be written out, in the order they
+// were reported
+class DiagBuffer{
+public:
+	void add(Diagnostic::Severity severity, DiagCode code, 
+		bool located, size_t l, size_t c, const char * msg){
+		myDiags.push_back(Diagnostic{severity, code, located, 
+			l, c, msg, std::string()});
+	}
+	void add(Diagnostic::Severity severity, DiagCode code, 
+		bool located, size_t l, size_t c, const std::string& msg){
+		myDiags.push_back(Diagnostic{severity, code, located, 
+			l, c, nullptr, msg});
+	}
+	void add(const Diagnostic& diag){ myDiags.push_back(diag); }
+	//Move all of other's diagnostics after this buffer's
+	void append(DiagBuffer& other){
+		if (myDiags.empty()){
+			myDiags.swap(other.myDiags);
+			return;
+		}
+		myDiags.insert(myDiags.end(), 
+			std::make_move_iterator(other.myDiags.begin()),
+			std::make_move_iterator(other.myDiags.end()));
+		other.myDiags.clear();
+	}
+	bool empty() const { return myDiags.empty(); }
+	void clear(){ myDiags.clear(); }
+	const std::vector<Diagnostic>& diagnostics() const { return myDiags; }
+	//Format every diagnostic and write them all to out at 
+	// once, then empty the buffer. Counts what was written
+	// into errors and warnings.
+	void flush(std::ostream& out, DiagFormat format,
+		size_t& errors, size_t& warnings){
+		if (myDiags.empty()){ return; }
+		std::string text;
+		for (const Diagnostic& diag : myDiags){
+			if (format == DiagFormat::JSON){
+				diag.writeJSON(text);
+			} else {
+				diag.writeText(text);
+			}
+			if (diag.severity == Diagnostic::FATAL){ 
+				errors++; 
+			} else {
+				warnings++;
+			}
+		}
+		out.write(text.data(), static_cast<std::streamsize>(text.size()));
+		out.flush();
+		myDiags.clear();
+	}
+private:
+	std::vector<Diagnostic> myDiags;
+};
+
+//Diagnostics are not written as they are reported: each 
+// thread collects them in a buffer, and they go to 
+// std::cerr in one write when the thread flushes (or 
+// exits). Anything else written to std::cerr must go 
+// through status() to keep the output in order.
 class Report{
 public:
+	//Send the calling thread's diagnostics to another 
+	// buffer, e.g. to keep those of one declaration of a 
+	// parallel pass apart. Returns the previous buffer.
+	static DiagBuffer * redirect(DiagBuffer * to){
+		DiagBuffer * prev = current();
+		current() = to;
+		return prev;
+	}
+	//The buffer the calling thread's diagnostics go to
+	static DiagBuffer& buffer(){ return *current(); }
+	//Write out the calling thread's diagnostics
+	static void flush(){ write(*current()); }
+
+	static void setFormat(DiagFormat format){ state().format = format; }
+
+	//Write out the diagnostics so far, then a message about
+	// the compilation as a whole. As JSON, the message is 
+	// kept for the summary instead.
+	static void status(const std::string& msg){
+		flush();
+		State& s = state();
+		std::lock_guard<std::mutex> guard(s.lock);
+		if (s.format == DiagFormat::TEXT){
+			std::cerr << msg;
+			return;
+		}
+		if (!s.status.empty()){ s.status += " "; }
+		s.status += msg.substr(0, msg.find_last_not_of('\n') + 1);
+	}
+	//Write out the diagnostics so far and, as JSON, a 
+	// summary record of the whole compilation
+	static void finish(int exitCode){
+		flush();
+		State& s = state();
+		std::lock_guard<std::mutex> guard(s.lock);
+		if (s.format == DiagFormat::TEXT){ return; }
+		std::string out = "{\"summary\":true,\"errors\":";
+		out += std::to_string(s.errors);
+		out += ",\"warnings\":";
+		out += std::to_string(s.warnings);
+		out += ",\"status\":";
+		Diagnostic::writeJSONString(out, s.status.c_str());
+		out += ",\"exit\":";
+		out += std::to_string(exitCode);
+		out += "}\n";
+		std::cerr << out << std::flush;
+	}
+
+	//msg must be a string literal: it is not copied
 	static void fatal(
 		size_t l, 
 		size_t c, 
+		DiagCode code,
 		const char * msg
 	){
-		std::cerr << "FATAL [" << l << "," << c << "]: " 
-		<< msg  << std::endl;
+		current()->add(Diagnostic::FATAL, code, true, l, c, msg);
 	}
 
 	static void fatal(
 		size_t l, 
 		size_t c, 
+		DiagCode code,
 		const std::string msg
 	){
-		fatal(l,c,msg.c_str());
+		current()->add(Diagnostic::FATAL, code, true, l, c, msg);
+	}
+
+	//A fatal error with no position; msg must be a string
+	// literal
+	static void fatal(DiagCode code, const char * msg){
+		current()->add(Diagnostic::FATAL, code, false, 0, 0, msg);
 	}
 
+	//msg must be a string literal: it is not copied
 	static void warn(
 		size_t l,
 		size_t c,
+		DiagCode code,
 		const char * msg
 	){
-		std::cerr << "*WARNING* [" << l << "," << c << "]: " 
-		<< msg  << std::endl;
+		current()->add(Diagnostic::WARN, code, true, l, c, msg);
 	}
 
 	static void warn(
 		size_t l,
 		size_t c,
+		DiagCode code,
 		const std::string msg
 	){
-		warn(l,c,msg.c_str());
+		current()->add(Diagnostic::WARN, code, true, l, c, msg);
+	}
+private:
+	//What every thread shares: the output format and the
+	// totals for the summary
+	struct State{
+		std::mutex lock;
+		DiagFormat format = DiagFormat::TEXT;
+		size_t errors = 0;
+		size_t warnings = 0;
+		std::string status;
+	};
+	static State& state(){
+		static State s;
+		return s;
+	}
+	static void write(DiagBuffer& diags){
+		State& s = state();
+		std::lock_guard<std::mutex> guard(s.lock);
+		diags.flush(std::cerr, s.format, s.errors, s.warnings);
+	}
+	//Each thread's own buffer, written out when the 
+	// thread ends
+	struct ThreadBuffer{
+		DiagBuffer diags;
+		~ThreadBuffer(){ write(diags); }
+	};
+	static DiagBuffer *& current(){
+		static thread_local ThreadBuffer own;
+		static thread_local DiagBuffer * to = &own.diags;
+		return to;
 	}
 };
 
@@ -0,0 +1,268 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+#include "ast.hpp"
+#include "fn_cache.hpp"
+#include "hash.hpp"
+#include "symbol_table.hpp"
+
+namespace holeyc{
+
+const char FnCache::MAGIC[8] = {'H','O','L','E','Y','F','N','C'};
+
+static bool readFile(const std::string& path, std::string& out){
+	std::ifstream in(path, std::ios::binary);
+	if (!in.good()){ return false; }
+	std::ostringstream data;
+	data << in.rdbuf();
+	out = data.str();
+	return true;
+}
+
+FnCache::FnCache(const char * path, ProgramNode * ast)
+: mySidecar(std::string(path) + ".fncache"){
+	std::string source;
+	if (!readFile(path, source)){ return; }
+
+	//Where each line starts, to turn positions into offsets
+	std::vector<size_t> lineStarts(1, 0);
+	for (size_t i = 0; i < source.size(); i++){
+		if (source[i] == '\n'){ lineStarts.push_back(i + 1); }
+	}
+	auto offset = [&](const ASTNode * node){
+		if (node->line() == 0 || node->line() > lineStarts.size()){
+			return source.size();
+		}
+		size_t res = lineStarts[node->line() - 1] + node->col() - 1;
+		return res < source.size() ? res : source.size();
+	};
+
+	std::list<DeclNode *> * globals = ast->getGlobals();
+	for (auto decl = globals->begin(); decl != globals->end(); ++decl){
+		if (dynamic_cast<FnDeclNode *>(*decl) == nullptr){
+			myKeys.push_back(0);
+			continue;
+		}
+		auto next = std::next(decl);
+		size_t start = offset(*decl);
+		size_t end = next == globals->end() ? source.size()
+			: offset(*next);
+		if (end < start){ end = start; }
+		uint64_t key = Hasher().add((*decl)->col())
+			.add(source.data() + start, end - start).done();
+		myKeys.push_back(key == 0 ? 1 : key);
+	}
+
+	std::string sidecar;
+	if (readFile(mySidecar, sidecar) && !load(sidecar)){
+		myLoaded.clear();
+	}
+}
+
+uint64_t FnCache::resolve(const std::vector<std::string>& deps,
+	SymbolTable * symTab){
+	Hasher hash;
+	for (const std::string& name : deps){
+		SemSymbol * symbol = symTab->find(name);
+		hash.add(name);
+		if (symbol == nullptr || symbol->getDataType() == nullptr){
+			hash.add("?");
+			continue;
+		}
+		hash.add(SemSymbol::kindToString(symbol->getKind()));
+		hash.add(symbol->getDataType()->getString());
+	}
+	return hash.done();
+}
+
+const FnResult * FnCache::find(size_t index, SymbolTable * symTab){
+	uint64_t key = myKeys[index];
+	auto found = myLoaded.find(key);
+	if (found == myLoaded.end()){ return nullptr; }
+	if (resolve(found->second.deps, symTab) != found->second.depsHash){
+		return nullptr;
+	}
+	FnResult& kept = myKept[key];
+	kept = found->second;
+	return &kept;
+}
+
+void FnCache::store(size_t index, size_t fnLine, FnResult result,
+	SymbolTable * symTab){
+	std::unordered_set<std::string> seen;
+	std::vector<std::string> deps;
+	for (std::string& name : result.deps){
+		if (seen.insert(name).second){ deps.push_back(std::move(name)); }
+	}
+	result.deps = std::move(deps);
+	result.depsHash = resolve(result.deps, symTab);
+	for (Diagnostic& diag : result.nameDiags){ diag.line -= fnLine; }
+	for (Diagnostic& diag : result.typeDiags){ diag.line -= fnLine; }
+	myKept[myKeys[index]] = std::move(result);
+}
+
+void FnCache::replay(const std::vector<Diagnostic>& diags,
+	size_t fnLine, DiagBuffer& to){
+	for (Diagnostic diag : diags){
+		diag.line += fnLine;
+		to.add(diag);
+	}
+}
+
+//The sidecar is the magic and version, then the results:
+// a count, then per result its key, dependencies,
+// dependency hash, name verdict and both diagnostic lists.
+// Numbers are LEB128, strings a length and then the bytes.
+static void putNum(std::string& out, uint64_t val){
+	while (val >= 0x80){
+		out.push_back(static_cast<char>((val & 0x7f) | 0x80));
+		val >>= 7;
+	}
+	out.push_back(static_cast<char>(val));
+}
+
+static void putStr(std::string& out, const std::string& str){
+	putNum(out, str.size());
+	out += str;
+}
+
+static void putDiags(std::string& out, const std::vector<Diagnostic>& diags){
+	putNum(out, diags.size());
+	for (const Diagnostic& diag : diags){
+		putNum(out, diag.severity);
+		putNum(out, static_cast<uint64_t>(diag.code));
+		putNum(out, diag.located ? 1 : 0);
+		putNum(out, diag.line);
+		putNum(out, diag.col);
+		putStr(out, diag.message());
+	}
+}
+
+void FnCache::save(){
+	//In source order, so that the same program always
+	// gives the same sidecar
+	std::vector<uint64_t> keys;
+	std::unordered_set<uint64_t> seen;
+	for (uint64_t key : myKeys){
+		if (myKept.count(key) != 0 && seen.insert(key).second){
+			keys.push_back(key);
+		}
+	}
+
+	std::string out(MAGIC, sizeof(MAGIC));
+	putNum(out, VERSION);
+	putNum(out, keys.size());
+	for (uint64_t key : keys){
+		const FnResult& result = myKept[key];
+		putNum(out, key);
+		putNum(out, result.deps.size());
+		for (const std::string& dep : result.deps){ putStr(out, dep); }
+		putNum(out, result.depsHash);
+		putNum(out, result.namesOK ? 1 : 0);
+		putDiags(out, result.nameDiags);
+		putDiags(out, result.typeDiags);
+	}
+
+	//Written aside and renamed into place, so that a
+	// reader never sees half a sidecar
+	std::string temp = mySidecar + ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		file.write(out.data(), static_cast<std::streamsize>(out.size()));
+		if (!file.good()){
+			file.close();
+			std::remove(temp.c_str());
+			return;
+		}
+	}
+	if (std::rename(temp.c_str(), mySidecar.c_str()) != 0){
+		std::remove(temp.c_str());
+	}
+}
+
+//Reads a sidecar, failing on anything out of bounds
+class SidecarReader{
+public:
+	SidecarReader(const std::string& data) : myData(data), myPos(0){ }
+	bool num(uint64_t& val){
+		val = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7){
+			if (myPos >= myData.size()){ return false; }
+			uint8_t b = static_cast<uint8_t>(myData[myPos++]);
+			val |= static_cast<uint64_t>(b & 0x7f) << shift;
+			if ((b & 0x80) == 0){ return true; }
+		}
+		return false;
+	}
+	bool size(size_t& val){
+		uint64_t wide;
+		if (!num(wide) || wide > myData.size()){ return false; }
+		val = static_cast<size_t>(wide);
+		return true;
+	}
+	bool str(std::string& val){
+		size_t len;
+		if (!size(len) || len > myData.size() - myPos){ return false; }
+		val.assign(myData, myPos, len);
+		myPos += len;
+		return true;
+	}
+	bool diags(std::vector<Diagnostic>& out){
+		size_t count;
+		if (!size(count)){ return false; }
+		for (size_t i = 0; i < count; i++){
+			uint64_t severity, code, located, line, col;
+			std::string msg;
+			if (!num(severity) || !num(code) || !num(located)
+				|| !num(line) || !num(col) || !str(msg)
+				|| severity > Diagnostic::WARN || code > UINT16_MAX){
+				return false;
+			}
+			out.push_back(Diagnostic{
+				static_cast<Diagnostic::Severity>(severity),
+				static_cast<DiagCode>(code), located != 0,
+				static_cast<size_t>(line), static_cast<size_t>(col),
+				nullptr, msg});
+		}
+		return true;
+	}
+	bool done() const { return myPos == myData.size(); }
+private:
+	const std::string& myData;
+	size_t myPos;
+};
+
+bool FnCache::load(const std::string& data){
+	if (data.size() < sizeof(MAGIC)
+		|| data.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0){
+		return false;
+	}
+	std::string rest = data.substr(sizeof(MAGIC));
+	SidecarReader in(rest);
+	uint64_t version;
+	size_t count;
+	if (!in.num(version) || version != VERSION || !in.size(count)){
+		return false;
+	}
+	for (size_t i = 0; i < count; i++){
+		uint64_t key, namesOK;
+		size_t depCount;
+		FnResult result;
+		if (!in.num(key) || !in.size(depCount)){ return false; }
+		result.deps.resize(depCount);
+		for (std::string& dep : result.deps){
+			if (!in.str(dep)){ return false; }
+		}
+		if (!in.num(result.depsHash) || !in.num(namesOK)
+			|| !in.diags(result.nameDiags) || !in.diags(result.typeDiags)){
+			return false;
+		}
+		result.namesOK = namesOK != 0;
+		myLoaded[key] = std::move(result);
+	}
+	return in.done();
+}
+
+}
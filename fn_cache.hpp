@@ -0,0 +1,80 @@
+#ifndef HOLEYC_FN_CACHE_HPP
+#define HOLEYC_FN_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "errors.hpp"
+
+namespace holeyc{
+
+class ProgramNode;
+class SymbolTable;
+
+//What analysing the body of one function found. Lines of
+// the diagnostics are relative to the function's first line.
+struct FnResult{
+	//The globals the body looks up (in order of first
+	// lookup), and a hash of what each one resolved to
+	std::vector<std::string> deps;
+	uint64_t depsHash;
+	bool namesOK;
+	std::vector<Diagnostic> nameDiags;
+	std::vector<Diagnostic> typeDiags;
+};
+
+//The results of the functions of one source file, kept in
+// a sidecar file next to it (<file>.fncache) between
+// compilations. A function is known by a hash of its source
+// text, from its first token up to the next declaration, and
+// of the column it starts at: moving a function up or down
+// keeps its key, and its diagnostics are replayed at its new
+// line. A result is only replayed if the globals its body
+// looks up still resolve to symbols of the same kinds and
+// types. Functions whose analysis threw are never kept.
+class FnCache{
+public:
+	//Key the functions of ast, which was parsed from the
+	// source file at path, and load its sidecar. A missing,
+	// stale or unreadable sidecar is ignored.
+	FnCache(const char * path, ProgramNode * ast);
+	//Is the index'th global a function with a key?
+	bool covers(size_t index) const {
+		return index < myKeys.size() && myKeys[index] != 0;
+	}
+	//The result kept for the index'th global, if its
+	// dependencies resolve the same in symTab as they did
+	const FnResult * find(size_t index, SymbolTable * symTab);
+	//Keep result for the index'th global. Its diagnostics
+	// have absolute lines, and deps may repeat names; they
+	// are resolved in symTab.
+	void store(size_t index, size_t fnLine, FnResult result,
+		SymbolTable * symTab);
+	//Report a kept result's diagnostics, at the function's
+	// current line
+	static void replay(const std::vector<Diagnostic>& diags,
+		size_t fnLine, DiagBuffer& to);
+	//Write the sidecar, holding the results of this
+	// compilation's functions only. Failing to write it
+	// is not an error.
+	void save();
+private:
+	static const char MAGIC[8];
+	static const uint32_t VERSION = 2;
+
+	static uint64_t resolve(const std::vector<std::string>& deps,
+		SymbolTable * symTab);
+	bool load(const std::string& data);
+
+	std::string mySidecar;
+	//Per global: its key, or 0 if it is not a function
+	std::vector<uint64_t> myKeys;
+	std::unordered_map<uint64_t, FnResult> myLoaded;
+	std::unordered_map<uint64_t, FnResult> myKept;
+};
+
+}
+
+#endif
@@ -0,0 +1,361 @@
+#include <cstdint>
+
+#include "ast.hpp"
+#include "errors.hpp"
+#include "type_analysis.hpp"
+#include "types.hpp"
+
+namespace holeyc{
+
+//Constant folding runs on the checked tree, just before it
+// is lowered. Operations on literals are done here instead
+// of at run time, identities such as x * 1 and true && x
+// are simplified, and if and while statements whose
+// condition folds to a constant are replaced by the code
+// that would run. Folded nodes get types as they are made,
+// since lowering asks for them. Every node folding visits
+// may have its subtree changed, so each one forgets its
+// cached structural hash.
+
+//Fold exp, freeing it if something takes its place
+static ExpNode * foldExp(ExpNode * exp, TypeAnalysis * ta){
+	ExpNode * res = exp->fold(ta);
+	if (res != exp){ delete exp; }
+	return res;
+}
+
+//Fold each statement of a list, splicing in what it becomes
+static void foldList(std::list<StmtNode *> * stmts, TypeAnalysis * ta){
+	auto it = stmts->begin();
+	while (it != stmts->end()){
+		std::list<StmtNode *> replacement;
+		if ((*it)->fold(ta, replacement)){
+			++it;
+			continue;
+		}
+		delete *it;
+		stmts->splice(it, replacement);
+		it = stmts->erase(it);
+	}
+}
+
+static bool intValue(const ExpNode * exp, int32_t& val){
+	auto lit = dynamic_cast<const IntLitNode *>(exp);
+	if (lit == nullptr){ return false; }
+	val = lit->getNum();
+	return true;
+}
+
+static bool boolValue(const ExpNode * exp, bool& val){
+	if (dynamic_cast<const TrueNode *>(exp) != nullptr){
+		val = true;
+		return true;
+	}
+	if (dynamic_cast<const FalseNode *>(exp) != nullptr){
+		val = false;
+		return true;
+	}
+	return false;
+}
+
+static bool charValue(const ExpNode * exp, int32_t& val){
+	auto lit = dynamic_cast<const CharLitNode *>(exp);
+	if (lit == nullptr){ return false; }
+	val = lit->getVal();
+	return true;
+}
+
+//An int literal in place of at, or at itself if the value
+// doesn't fit in one. Lowered ints are 64 bits wide, so a
+// result outside 32 bits is left to be computed at run time
+// rather than wrapped here to something the program would
+// not print.
+static ExpNode * makeInt(ExpNode * at, int64_t val, TypeAnalysis * ta){
+	if (val < INT32_MIN || val > INT32_MAX){ return at; }
+	ExpNode * res = new IntLitNode(at->line(), at->col(),
+		static_cast<int32_t>(val));
+	ta->nodeType(res, BasicType::produce(INT));
+	return res;
+}
+
+static ExpNode * makeBool(const ExpNode * at, bool val, TypeAnalysis * ta){
+	ExpNode * res;
+	if (val){
+		res = new TrueNode(at->line(), at->col());
+	} else {
+		res = new FalseNode(at->line(), at->col());
+	}
+	ta->nodeType(res, BasicType::produce(BOOL));
+	return res;
+}
+
+static bool compare(OpKind op, int64_t lhs, int64_t rhs){
+	switch (op){
+	case EQUALS_OP: return lhs == rhs;
+	case NOT_EQUALS_OP: return lhs != rhs;
+	case LESS_OP: return lhs < rhs;
+	case LESS_EQ_OP: return lhs <= rhs;
+	case GREATER_OP: return lhs > rhs;
+	case GREATER_EQ_OP: return lhs >= rhs;
+	default: break;
+	}
+	throw new InternalError("Not a comparison");
+}
+
+static bool isComparison(OpKind op){
+	return op == EQUALS_OP || op == NOT_EQUALS_OP || op == LESS_OP
+		|| op == LESS_EQ_OP || op == GREATER_OP || op == GREATER_EQ_OP;
+}
+
+void ProgramNode::fold(TypeAnalysis * ta){
+	rehash();
+	for (auto global : *myGlobals){
+		std::list<StmtNode *> replacement;
+		global->fold(ta, replacement);
+	}
+}
+
+bool FnDeclNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	foldList(myBody, ta);
+	return true;
+}
+
+bool AssignStmtNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	myExp->fold(ta);
+	return true;
+}
+
+bool FromConsoleStmtNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	myDst->fold(ta);
+	return true;
+}
+
+bool ToConsoleStmtNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	mySrc = foldExp(mySrc, ta);
+	return true;
+}
+
+bool PostDecStmtNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	myLVal->fold(ta);
+	return true;
+}
+
+bool PostIncStmtNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	myLVal->fold(ta);
+	return true;
+}
+
+bool IfStmtNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	myCond = foldExp(myCond, ta);
+	foldList(myBody, ta);
+	bool cond;
+	if (!boolValue(myCond, cond)){ return true; }
+	if (cond){ replacement.splice(replacement.end(), *myBody); }
+	return false;
+}
+
+bool IfElseStmtNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	myCond = foldExp(myCond, ta);
+	foldList(myBodyTrue, ta);
+	foldList(myBodyFalse, ta);
+	bool cond;
+	if (!boolValue(myCond, cond)){ return true; }
+	replacement.splice(replacement.end(), cond ? *myBodyTrue : *myBodyFalse);
+	return false;
+}
+
+//A loop that always runs is kept; one that never runs goes
+bool WhileStmtNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	myCond = foldExp(myCond, ta);
+	foldList(myBody, ta);
+	bool cond;
+	return !boolValue(myCond, cond) || cond;
+}
+
+bool ReturnStmtNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	if (myExp != nullptr){ myExp = foldExp(myExp, ta); }
+	return true;
+}
+
+bool CallStmtNode::fold(TypeAnalysis * ta,
+  std::list<StmtNode *>& replacement){
+	rehash();
+	myCallExp->fold(ta);
+	return true;
+}
+
+ExpNode * IndexNode::fold(TypeAnalysis * ta){
+	rehash();
+	myOffset = foldExp(myOffset, ta);
+	return this;
+}
+
+//A load may trap
+bool IndexNode::hasEffects() const{
+	return true;
+}
+
+bool DerefNode::hasEffects() const{
+	return true;
+}
+
+ExpNode * CallExpNode::fold(TypeAnalysis * ta){
+	rehash();
+	for (auto& arg : *myArgs){ arg = foldExp(arg, ta); }
+	return this;
+}
+
+bool CallExpNode::hasEffects() const{
+	return true;
+}
+
+ExpNode * AssignExpNode::fold(TypeAnalysis * ta){
+	rehash();
+	myDst->fold(ta);
+	mySrc = foldExp(mySrc, ta);
+	return this;
+}
+
+bool AssignExpNode::hasEffects() const{
+	return true;
+}
+
+ExpNode * BinaryExpNode::fold(TypeAnalysis * ta){
+	rehash();
+	myExp1 = foldExp(myExp1, ta);
+	myExp2 = foldExp(myExp2, ta);
+	OpKind op = getOp();
+	//Let go of a child so it can take this node's place
+	auto keep = [&](ExpNode *& child){
+		ExpNode * res = child;
+		child = nullptr;
+		return res;
+	};
+
+	int32_t lhs, rhs;
+	bool lInt = intValue(myExp1, lhs);
+	bool rInt = intValue(myExp2, rhs);
+	if (lInt && rInt){
+		switch (op){
+		case PLUS_OP: return makeInt(this, int64_t(lhs) + rhs, ta);
+		case MINUS_OP: return makeInt(this, int64_t(lhs) - rhs, ta);
+		case TIMES_OP: return makeInt(this, int64_t(lhs) * rhs, ta);
+		case DIVIDE_OP:
+			//Dividing by zero is left to happen at run time
+			if (rhs == 0){ return this; }
+			return makeInt(this, int64_t(lhs) / rhs, ta);
+		default:
+			if (isComparison(op)){
+				return makeBool(this, compare(op, lhs, rhs), ta);
+			}
+			return this;
+		}
+	}
+	int32_t lChar, rChar;
+	if (charValue(myExp1, lChar) && charValue(myExp2, rChar)
+	  && isComparison(op)){
+		return makeBool(this, compare(op, lChar, rChar), ta);
+	}
+	bool lBool, rBool;
+	bool lIsBool = boolValue(myExp1, lBool);
+	bool rIsBool = boolValue(myExp2, rBool);
+	if (lIsBool && rIsBool && (op == EQUALS_OP || op == NOT_EQUALS_OP)){
+		return makeBool(this, compare(op, lBool, rBool), ta);
+	}
+
+	switch (op){
+	case PLUS_OP:
+		if (lInt && lhs == 0){ return keep(myExp2); }
+		if (rInt && rhs == 0){ return keep(myExp1); }
+		break;
+	case MINUS_OP:
+		if (rInt && rhs == 0){ return keep(myExp1); }
+		break;
+	case TIMES_OP:
+		if (lInt && lhs == 1){ return keep(myExp2); }
+		if (rInt && rhs == 1){ return keep(myExp1); }
+		if ((lInt && lhs == 0 && !myExp2->hasEffects())
+		  || (rInt && rhs == 0 && !myExp1->hasEffects())){
+			return makeInt(this, 0, ta);
+		}
+		break;
+	case DIVIDE_OP:
+		if (rInt && rhs == 1){ return keep(myExp1); }
+		break;
+	//The right side of && and || only runs if the left side
+	// doesn't decide the result, so a constant on the left
+	// can drop it; one on the right can only drop the left
+	// side if that has no effects
+	case AND_OP:
+		if (lIsBool){ return lBool ? keep(myExp2) : keep(myExp1); }
+		if (rIsBool && rBool){ return keep(myExp1); }
+		if (rIsBool && !myExp1->hasEffects()){ return keep(myExp2); }
+		break;
+	case OR_OP:
+		if (lIsBool){ return lBool ? keep(myExp1) : keep(myExp2); }
+		if (rIsBool && !rBool){ return keep(myExp1); }
+		if (rIsBool && !myExp1->hasEffects()){ return keep(myExp2); }
+		break;
+	default:
+		break;
+	}
+	return this;
+}
+
+//A division traps unless its divisor is a literal other than
+// 0, and -1 (which overflows dividing the least int)
+bool BinaryExpNode::hasEffects() const{
+	int32_t divisor;
+	if (getOp() == DIVIDE_OP
+	  && (!intValue(myExp2, divisor) || divisor == 0 || divisor == -1)){
+		return true;
+	}
+	return myExp1->hasEffects() || myExp2->hasEffects();
+}
+
+ExpNode * UnaryExpNode::fold(TypeAnalysis * ta){
+	rehash();
+	myExp = foldExp(myExp, ta);
+	int32_t num;
+	bool val;
+	if (getOp() == NEG_OP && intValue(myExp, num)){
+		return makeInt(this, -int64_t(num), ta);
+	}
+	if (getOp() == NOT_OP && boolValue(myExp, val)){
+		return makeBool(this, !val, ta);
+	}
+	//-(-x) and !(!x) are x
+	auto inner = dynamic_cast<UnaryExpNode *>(myExp);
+	if (inner != nullptr && inner->getOp() == getOp()){
+		ExpNode * res = inner->myExp;
+		inner->myExp = nullptr;
+		return res;
+	}
+	return this;
+}
+
+bool UnaryExpNode::hasEffects() const{
+	return myExp->hasEffects();
+}
+
+}
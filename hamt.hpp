@@ -0,0 +1,175 @@
+#ifndef HOLEYC_HAMT_HPP
+#define HOLEYC_HAMT_HPP
+
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hash.hpp"
+
+namespace holeyc{
+
+//An immutable map from strings to values, stored as a hash
+// array mapped trie. Each trie node consumes BITS bits of the
+// key's hash and keeps only the children that exist, indexed
+// through a bitmap. insert never changes a map: it copies the
+// O(log n) nodes on the path to the key and shares the rest,
+// so every earlier version of the map stays valid and copying
+// a map is just copying a pointer.
+template <typename V>
+class PersistentMap{
+public:
+	PersistentMap() : myRoot(nullptr), mySize(0){ }
+
+	size_t size() const { return mySize; }
+
+	//Returns nullptr if the key is not in the map
+	const V * find(const std::string& key) const {
+		size_t hash = hashOf(key);
+		const Node * node = myRoot.get();
+		size_t shift = 0;
+		while (node != nullptr){
+			if (shift >= HASH_BITS){
+				for (const Entry& entry : node->entries){
+					if (entry.leaf->key == key){
+						return &entry.leaf->val;
+					}
+				}
+				return nullptr;
+			}
+			uint32_t bit = bitFor(hash, shift);
+			if ((node->bitmap & bit) == 0){ return nullptr; }
+			const Entry& entry = node->entries[slotFor(node->bitmap, bit)];
+			if (entry.leaf != nullptr){
+				if (entry.leaf->key == key){ return &entry.leaf->val; }
+				return nullptr;
+			}
+			node = entry.child.get();
+			shift += BITS;
+		}
+		return nullptr;
+	}
+
+	//A new version of the map with key bound to val
+	PersistentMap insert(const std::string& key, const V& val) const {
+		LeafPtr leaf = std::make_shared<const Leaf>(
+			Leaf{hashOf(key), key, val});
+		bool added = false;
+		NodePtr root = insert(myRoot, 0, leaf, added);
+		return PersistentMap(root, mySize + (added ? 1 : 0));
+	}
+
+	//Call f(key, val) for every binding, in no particular order
+	template <typename F>
+	void forEach(F f) const { forEach(myRoot.get(), f); }
+
+private:
+	static size_t hashOf(const std::string& key){
+		return static_cast<size_t>(Hasher().add(key).done());
+	}
+	static const size_t BITS = 5;
+	static const size_t HASH_BITS = sizeof(size_t) * 8;
+
+	struct Leaf{
+		size_t hash;
+		std::string key;
+		V val;
+	};
+	struct Node;
+	using LeafPtr = std::shared_ptr<const Leaf>;
+	using NodePtr = std::shared_ptr<const Node>;
+	//Exactly one of child and leaf is set
+	struct Entry{
+		NodePtr child;
+		LeafPtr leaf;
+	};
+	//Below HASH_BITS, entries are indexed through bitmap.
+	// Past the last bit of the hash, a node just lists the
+	// leaves whose hashes collide.
+	struct Node{
+		uint32_t bitmap;
+		std::vector<Entry> entries;
+	};
+
+	PersistentMap(NodePtr root, size_t size)
+	: myRoot(root), mySize(size){ }
+
+	static uint32_t bitFor(size_t hash, size_t shift){
+		return uint32_t(1) << ((hash >> shift) & ((1u << BITS) - 1));
+	}
+	static size_t slotFor(uint32_t bitmap, uint32_t bit){
+		return std::bitset<32>(bitmap & (bit - 1)).count();
+	}
+
+	static NodePtr insert(const NodePtr& node, size_t shift,
+		const LeafPtr& leaf, bool& added){
+		if (node == nullptr){
+			added = true;
+			Node fresh{0, {Entry{nullptr, leaf}}};
+			if (shift < HASH_BITS){
+				fresh.bitmap = bitFor(leaf->hash, shift);
+			}
+			return std::make_shared<const Node>(fresh);
+		}
+
+		Node copy = *node;
+		if (shift >= HASH_BITS){
+			for (Entry& entry : copy.entries){
+				if (entry.leaf->key == leaf->key){
+					entry.leaf = leaf;
+					return std::make_shared<const Node>(copy);
+				}
+			}
+			added = true;
+			copy.entries.push_back(Entry{nullptr, leaf});
+			return std::make_shared<const Node>(copy);
+		}
+
+		uint32_t bit = bitFor(leaf->hash, shift);
+		size_t slot = slotFor(copy.bitmap, bit);
+		if ((copy.bitmap & bit) == 0){
+			added = true;
+			copy.bitmap |= bit;
+			copy.entries.insert(copy.entries.begin()
+				+ static_cast<long>(slot), Entry{nullptr, leaf});
+			return std::make_shared<const Node>(copy);
+		}
+
+		Entry& entry = copy.entries[slot];
+		if (entry.child != nullptr){
+			entry.child = insert(entry.child, shift + BITS, leaf, added);
+		} else if (entry.leaf->key == leaf->key){
+			entry.leaf = leaf;
+		} else {
+			//Push the existing leaf down a level, then add
+			// the new one beside (or below) it
+			NodePtr sub = insert(nullptr, shift + BITS, entry.leaf, added);
+			entry.child = insert(sub, shift + BITS, leaf, added);
+			entry.leaf = nullptr;
+			added = true;
+		}
+		return std::make_shared<const Node>(copy);
+	}
+
+	template <typename F>
+	static void forEach(const Node * node, F& f){
+		if (node == nullptr){ return; }
+		for (const Entry& entry : node->entries){
+			if (entry.leaf != nullptr){
+				f(entry.leaf->key, entry.leaf->val);
+			} else {
+				forEach(entry.child.get(), f);
+			}
+		}
+	}
+
+	NodePtr myRoot;
+	size_t mySize;
+};
+
+}
+
+#endif
@@ -0,0 +1,319 @@
+#include <list>
+
+#include "ast.hpp"
+#include "hash.hpp"
+#include "serialize.hpp"
+
+namespace holeyc{
+
+//Builds the structural hash of a single node out of its kind, 
+// its own fields, and the (cached) hashes of its children. 
+// Only values that are stable across runs and machines are
+// mixed in, so hashes can be compared between compilations.
+class StructHasher{
+public:
+	StructHasher(NodeKind kind) : myHash(kind){ }
+	StructHasher& add(uint64_t val){
+		myHash.add(val);
+		return *this;
+	}
+	StructHasher& add(const std::string& str){
+		myHash.add(str);
+		return *this;
+	}
+	StructHasher& add(ASTNode * child){
+		if (child == nullptr){ return add(NONE_NODE); }
+		return add(child->structHash());
+	}
+	template <typename T>
+	StructHasher& add(const std::list<T *> * elts){
+		add(elts->size());
+		for (T * elt : *elts){
+			add(static_cast<ASTNode *>(elt));
+		}
+		return *this;
+	}
+	uint64_t done() const { return myHash.done(); }
+private:
+	Hasher myHash;
+};
+
+uint64_t ProgramNode::computeHash(){
+	return StructHasher(PROGRAM_NODE).add(myGlobals).done();
+}
+
+uint64_t IDNode::computeHash(){
+	return StructHasher(ID_NODE)
+		.add(name)
+		.done();
+}
+
+uint64_t RefNode::computeHash(){
+	return StructHasher(REF_NODE)
+		.add(myID)
+		.done();
+}
+
+uint64_t DerefNode::computeHash(){
+	return StructHasher(DEREF_NODE)
+		.add(myID)
+		.done();
+}
+
+uint64_t IndexNode::computeHash(){
+	return StructHasher(INDEX_NODE)
+		.add(myBase)
+		.add(myOffset)
+		.done();
+}
+
+uint64_t IntTypeNode::computeHash(){
+	return StructHasher(INT_TYPE_NODE)
+		.add(isPtr ? 1u : 0u)
+		.done();
+}
+
+uint64_t BoolTypeNode::computeHash(){
+	return StructHasher(BOOL_TYPE_NODE)
+		.add(isPtr ? 1u : 0u)
+		.done();
+}
+
+uint64_t CharTypeNode::computeHash(){
+	return StructHasher(CHAR_TYPE_NODE)
+		.add(isPtr ? 1u : 0u)
+		.done();
+}
+
+uint64_t VoidTypeNode::computeHash(){
+	return StructHasher(VOID_TYPE_NODE).done();
+}
+
+uint64_t VarDeclNode::computeHash(){
+	return StructHasher(VAR_DECL_NODE)
+		.add(myType)
+		.add(myID)
+		.done();
+}
+
+uint64_t FormalDeclNode::computeHash(){
+	return StructHasher(FORMAL_DECL_NODE)
+		.add(getTypeNode())
+		.add(ID())
+		.done();
+}
+
+uint64_t FnDeclNode::computeHash(){
+	return StructHasher(FN_DECL_NODE)
+		.add(myRetType)
+		.add(myID)
+		.add(myFormals)
+		.add(myBody)
+		.done();
+}
+
+uint64_t AssignStmtNode::computeHash(){
+	return StructHasher(ASSIGN_STMT_NODE)
+		.add(myExp)
+		.done();
+}
+
+uint64_t FromConsoleStmtNode::computeHash(){
+	return StructHasher(FROM_CONSOLE_STMT_NODE)
+		.add(myDst)
+		.done();
+}
+
+uint64_t ToConsoleStmtNode::computeHash(){
+	return StructHasher(TO_CONSOLE_STMT_NODE)
+		.add(mySrc)
+		.done();
+}
+
+uint64_t PostDecStmtNode::computeHash(){
+	return StructHasher(POST_DEC_STMT_NODE)
+		.add(myLVal)
+		.done();
+}
+
+uint64_t PostIncStmtNode::computeHash(){
+	return StructHasher(POST_INC_STMT_NODE)
+		.add(myLVal)
+		.done();
+}
+
+uint64_t IfStmtNode::computeHash(){
+	return StructHasher(IF_STMT_NODE)
+		.add(myCond)
+		.add(myBody)
+		.done();
+}
+
+uint64_t IfElseStmtNode::computeHash(){
+	return StructHasher(IF_ELSE_STMT_NODE)
+		.add(myCond)
+		.add(myBodyTrue)
+		.add(myBodyFalse)
+		.done();
+}
+
+uint64_t WhileStmtNode::computeHash(){
+	return StructHasher(WHILE_STMT_NODE)
+		.add(myCond)
+		.add(myBody)
+		.done();
+}
+
+uint64_t ReturnStmtNode::computeHash(){
+	return StructHasher(RETURN_STMT_NODE)
+		.add(myExp)
+		.done();
+}
+
+uint64_t CallStmtNode::computeHash(){
+	return StructHasher(CALL_STMT_NODE)
+		.add(myCallExp)
+		.done();
+}
+
+uint64_t CallExpNode::computeHash(){
+	return StructHasher(CALL_EXP_NODE)
+		.add(myID)
+		.add(myArgs)
+		.done();
+}
+
+uint64_t PlusNode::computeHash(){
+	return StructHasher(PLUS_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t MinusNode::computeHash(){
+	return StructHasher(MINUS_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t TimesNode::computeHash(){
+	return StructHasher(TIMES_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t DivideNode::computeHash(){
+	return StructHasher(DIVIDE_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t AndNode::computeHash(){
+	return StructHasher(AND_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t OrNode::computeHash(){
+	return StructHasher(OR_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t EqualsNode::computeHash(){
+	return StructHasher(EQUALS_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t NotEqualsNode::computeHash(){
+	return StructHasher(NOT_EQUALS_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t LessNode::computeHash(){
+	return StructHasher(LESS_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t LessEqNode::computeHash(){
+	return StructHasher(LESS_EQ_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t GreaterNode::computeHash(){
+	return StructHasher(GREATER_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t GreaterEqNode::computeHash(){
+	return StructHasher(GREATER_EQ_NODE)
+		.add(myExp1)
+		.add(myExp2)
+		.done();
+}
+
+uint64_t NegNode::computeHash(){
+	return StructHasher(NEG_NODE)
+		.add(myExp)
+		.done();
+}
+
+uint64_t NotNode::computeHash(){
+	return StructHasher(NOT_NODE)
+		.add(myExp)
+		.done();
+}
+
+uint64_t AssignExpNode::computeHash(){
+	return StructHasher(ASSIGN_EXP_NODE)
+		.add(myDst)
+		.add(mySrc)
+		.done();
+}
+
+uint64_t IntLitNode::computeHash(){
+	return StructHasher(INT_LIT_NODE)
+		.add(static_cast<uint64_t>(myNum))
+		.done();
+}
+
+uint64_t StrLitNode::computeHash(){
+	return StructHasher(STR_LIT_NODE)
+		.add(myStr)
+		.done();
+}
+
+uint64_t CharLitNode::computeHash(){
+	return StructHasher(CHAR_LIT_NODE)
+		.add(static_cast<unsigned char>(myVal))
+		.done();
+}
+
+uint64_t NullPtrNode::computeHash(){
+	return StructHasher(NULL_PTR_NODE).done();
+}
+
+uint64_t TrueNode::computeHash(){
+	return StructHasher(TRUE_NODE).done();
+}
+
+uint64_t FalseNode::computeHash(){
+	return StructHasher(FALSE_NODE).done();
+}
+
+} //End namespace holeyc
@@ -0,0 +1,53 @@
+#ifndef HOLEYC_HASH_HPP
+#define HOLEYC_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace holeyc{
+
+//A 64-bit hash of a sequence of numbers and strings, for
+// every hash in the compiler. Only the values added go into
+// it (std::hash of a string is implementation-defined), so
+// hashes can be kept in files and compared between runs.
+class Hasher{
+public:
+	Hasher(uint64_t seed = 0) : myState(mix(SEED + seed)){ }
+	Hasher& add(uint64_t val){
+		myState = mix(myState ^ (val + GOLDEN 
+			+ (myState << 6) + (myState >> 2)));
+		return *this;
+	}
+	Hasher& add(const char * data, size_t len){
+		//FNV-1a over the bytes, after the length, so that
+		// consecutive strings can't run together
+		uint64_t fnv = 0xcbf29ce484222325ull;
+		for (size_t i = 0; i < len; i++){
+			fnv ^= static_cast<unsigned char>(data[i]);
+			fnv *= 0x100000001b3ull;
+		}
+		return add(len).add(fnv);
+	}
+	Hasher& add(const std::string& str){
+		return add(str.data(), str.size());
+	}
+	uint64_t done() const { return myState; }
+private:
+	static const uint64_t SEED = 0x5bd1e9955bd1e995ull;
+	static const uint64_t GOLDEN = 0x9e3779b97f4a7c15ull;
+	//The splitmix64 finalizer
+	static uint64_t mix(uint64_t val){
+		val ^= val >> 30;
+		val *= 0xbf58476d1ce4e5b9ull;
+		val ^= val >> 27;
+		val *= 0x94d049bb133111ebull;
+		val ^= val >> 31;
+		return val;
+	}
+	uint64_t myState;
+};
+
+}
+
+#endif
@@ -145,6 +145,19 @@
 %type <transCallExp>    callExp
 %type <transActuals>    actualsList
 
+/* Frees what has been built of the tree when the parser
+ * gives up on a syntax error. The tokens belong to the 
+ * scanner, and the program to the caller.
+ */
+%destructor { delete $$; } <transDecl> <transVarDecl> <transFormal>
+%destructor { delete $$; } <transType> <transLVal> <transID> <transFn>
+%destructor { delete $$; } <transStmt> <transExp> <transAssignExp>
+%destructor { delete $$; } <transCallExp>
+%destructor { for (auto elt : *$$){ delete elt; } delete $$; } <transDeclList>
+%destructor { for (auto elt : *$$){ delete elt; } delete $$; } <transFormals>
+%destructor { for (auto elt : *$$){ delete elt; } delete $$; } <transStmts>
+%destructor { for (auto elt : *$$){ delete elt; } delete $$; } <transActuals>
+
 /* NOTE: Make sure to add precedence and associativity 
  * declarations
  */
@@ -453,5 +466,5 @@ id		: ID
 
 void holeyc::Parser::error(const std::string& msg){
 	std::cout << msg << std::endl;
-	std::cerr << "syntax error" << std::endl;
+	Report::fatal(DiagCode::SYNTAX_ERROR, "syntax error");
 }
@@ -0,0 +1,258 @@
+#include <cmath>
+#include <cstdio>
+
+#include "errors.hpp"
+#include "json.hpp"
+
+namespace holeyc{
+
+//Recursive descent over the text; every read function
+// returns false at the first thing that is not JSON
+class JSONReader{
+public:
+	JSONReader(const std::string& text) : myText(text), myPos(0){ }
+	bool document(JSONValue& out){
+		return value(out, 0) && (space(), myPos == myText.size());
+	}
+private:
+	//Deeper nesting than any message needs, and shallow
+	// enough not to run out of stack
+	static const size_t MAX_DEPTH = 512;
+
+	void space(){
+		while (myPos < myText.size()){
+			char ch = myText[myPos];
+			if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r'){
+				return;
+			}
+			myPos++;
+		}
+	}
+	bool eat(char ch){
+		space();
+		if (myPos < myText.size() && myText[myPos] == ch){
+			myPos++;
+			return true;
+		}
+		return false;
+	}
+	bool word(const char * w){
+		size_t len = std::char_traits<char>::length(w);
+		if (myText.compare(myPos, len, w) != 0){ return false; }
+		myPos += len;
+		return true;
+	}
+	bool value(JSONValue& out, size_t depth){
+		if (depth > MAX_DEPTH){ return false; }
+		space();
+		if (myPos >= myText.size()){ return false; }
+		switch (myText[myPos]){
+		case 'n': out = JSONValue(); return word("null");
+		case 't': out = JSONValue(true); return word("true");
+		case 'f': out = JSONValue(false); return word("false");
+		case '"': out = JSONValue(std::string()); return string(out.myStr);
+		case '[': return array(out, depth);
+		case '{': return object(out, depth);
+		default: return number(out);
+		}
+	}
+	bool array(JSONValue& out, size_t depth){
+		out = JSONValue::array();
+		myPos++;
+		if (eat(']')){ return true; }
+		do {
+			out.myItems.emplace_back();
+			if (!value(out.myItems.back(), depth + 1)){ return false; }
+		} while (eat(','));
+		return eat(']');
+	}
+	bool object(JSONValue& out, size_t depth){
+		out = JSONValue::object();
+		myPos++;
+		if (eat('}')){ return true; }
+		do {
+			std::string key;
+			space();
+			if (myPos >= myText.size() || myText[myPos] != '"'){
+				return false;
+			}
+			if (!string(key) || !eat(':')){ return false; }
+			JSONValue val;
+			if (!value(val, depth + 1)){ return false; }
+			out.set(key, val);
+		} while (eat(','));
+		return eat('}');
+	}
+	bool number(JSONValue& out){
+		size_t start = myPos;
+		if (myText[myPos] == '-'){ myPos++; }
+		size_t digits = myPos;
+		while (myPos < myText.size() && (isDigit(myText[myPos])
+			|| myText[myPos] == '.' || myText[myPos] == 'e'
+			|| myText[myPos] == 'E' || myText[myPos] == '+'
+			|| myText[myPos] == '-')){
+			myPos++;
+		}
+		if (myPos == digits || !isDigit(myText[digits])){ return false; }
+		std::string num = myText.substr(start, myPos - start);
+		char * end = nullptr;
+		double val = std::strtod(num.c_str(), &end);
+		if (end != num.c_str() + num.size()){ return false; }
+		out = JSONValue(val);
+		return true;
+	}
+	bool hex4(unsigned& out){
+		if (myPos + 4 > myText.size()){ return false; }
+		out = 0;
+		for (size_t i = 0; i < 4; i++){
+			char ch = myText[myPos++];
+			unsigned digit;
+			if (ch >= '0' && ch <= '9'){
+				digit = static_cast<unsigned>(ch - '0');
+			} else if (ch >= 'a' && ch <= 'f'){
+				digit = static_cast<unsigned>(ch - 'a' + 10);
+			} else if (ch >= 'A' && ch <= 'F'){
+				digit = static_cast<unsigned>(ch - 'A' + 10);
+			} else {
+				return false;
+			}
+			out = out * 16 + digit;
+		}
+		return true;
+	}
+	static void utf8(std::string& out, unsigned cp){
+		if (cp < 0x80){
+			out += static_cast<char>(cp);
+		} else if (cp < 0x800){
+			out += static_cast<char>(0xc0 | (cp >> 6));
+			out += static_cast<char>(0x80 | (cp & 0x3f));
+		} else if (cp < 0x10000){
+			out += static_cast<char>(0xe0 | (cp >> 12));
+			out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+			out += static_cast<char>(0x80 | (cp & 0x3f));
+		} else {
+			out += static_cast<char>(0xf0 | (cp >> 18));
+			out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+			out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+			out += static_cast<char>(0x80 | (cp & 0x3f));
+		}
+	}
+	bool string(std::string& out){
+		myPos++;
+		while (myPos < myText.size()){
+			char ch = myText[myPos++];
+			if (ch == '"'){ return true; }
+			if (static_cast<unsigned char>(ch) < 0x20){ return false; }
+			if (ch != '\\'){
+				out += ch;
+				continue;
+			}
+			if (myPos >= myText.size()){ return false; }
+			char esc = myText[myPos++];
+			switch (esc){
+			case '"': case '\\': case '/': out += esc; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u': {
+				unsigned cp;
+				if (!hex4(cp)){ return false; }
+				//A surrogate pair encodes one code point
+				if (cp >= 0xd800 && cp < 0xdc00 && word("\\u")){
+					unsigned low;
+					if (!hex4(low) || low < 0xdc00 || low >= 0xe000){
+						return false;
+					}
+					cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+				}
+				utf8(out, cp);
+				break;
+			}
+			default: return false;
+			}
+		}
+		return false;
+	}
+	static bool isDigit(char ch){ return ch >= '0' && ch <= '9'; }
+
+	const std::string& myText;
+	size_t myPos;
+};
+
+bool JSONValue::parse(const std::string& text, JSONValue& out){
+	JSONReader reader(text);
+	return reader.document(out);
+}
+
+void JSONValue::write(std::string& out) const {
+	switch (myKind){
+	case NUL: out += "null"; return;
+	case BOOL: out += myBool ? "true" : "false"; return;
+	case NUMBER: {
+		if (std::isfinite(myNum) && myNum == std::floor(myNum)
+			&& std::fabs(myNum) < 1e15){
+			out += std::to_string(static_cast<long long>(myNum));
+			return;
+		}
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "%.17g",
+			std::isfinite(myNum) ? myNum : 0.0);
+		out += buf;
+		return;
+	}
+	case STRING:
+		Diagnostic::writeJSONString(out, myStr.c_str());
+		return;
+	case ARRAY:
+		out += '[';
+		for (size_t i = 0; i < myItems.size(); i++){
+			if (i > 0){ out += ','; }
+			myItems[i].write(out);
+		}
+		out += ']';
+		return;
+	case OBJECT:
+		out += '{';
+		for (size_t i = 0; i < myMembers.size(); i++){
+			if (i > 0){ out += ','; }
+			Diagnostic::writeJSONString(out, myMembers[i].first.c_str());
+			out += ':';
+			myMembers[i].second.write(out);
+		}
+		out += '}';
+		return;
+	}
+}
+
+size_t JSONValue::asSize() const {
+	if (myKind != NUMBER || !(myNum >= 0) || myNum > 1e15){ return 0; }
+	return static_cast<size_t>(myNum);
+}
+
+const JSONValue& JSONValue::get(const std::string& key) const {
+	static const JSONValue none;
+	for (const Member& member : myMembers){
+		if (member.first == key){ return member.second; }
+	}
+	return none;
+}
+
+JSONValue& JSONValue::set(const std::string& key, const JSONValue& val){
+	for (Member& member : myMembers){
+		if (member.first == key){
+			member.second = val;
+			return *this;
+		}
+	}
+	myMembers.push_back(Member(key, val));
+	return *this;
+}
+
+JSONValue& JSONValue::push(const JSONValue& val){
+	myItems.push_back(val);
+	return *this;
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef HOLEYC_JSON_HPP
+#define HOLEYC_JSON_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace holeyc{
+
+//A JSON value, as read and written by the language server.
+// Numbers are kept as doubles; objects keep their members in
+// the order they were read or set.
+class JSONValue{
+public:
+	enum Kind : uint8_t { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+	using Member = std::pair<std::string, JSONValue>;
+
+	JSONValue() : myKind(NUL), myBool(false), myNum(0){ }
+	JSONValue(bool val) : myKind(BOOL), myBool(val), myNum(0){ }
+	JSONValue(int val) : JSONValue(static_cast<double>(val)){ }
+	JSONValue(size_t val) : JSONValue(static_cast<double>(val)){ }
+	JSONValue(double val) : myKind(NUMBER), myBool(false), myNum(val){ }
+	JSONValue(const char * val) : JSONValue(std::string(val)){ }
+	JSONValue(const std::string& val)
+	: myKind(STRING), myBool(false), myNum(0), myStr(val){ }
+	static JSONValue array(){ return JSONValue(ARRAY); }
+	static JSONValue object(){ return JSONValue(OBJECT); }
+
+	//Read a whole JSON text into out. Returns false (leaving
+	// out unspecified) if text is not valid JSON.
+	static bool parse(const std::string& text, JSONValue& out);
+	void write(std::string& out) const;
+
+	Kind kind() const { return myKind; }
+	bool isNull() const { return myKind == NUL; }
+	bool asBool() const { return myKind == BOOL && myBool; }
+	double asNumber() const { return myKind == NUMBER ? myNum : 0; }
+	//Non-negative integers, e.g. positions; anything else is 0
+	size_t asSize() const;
+	const std::string& asString() const { return myStr; }
+
+	//The member called key, or null if there is none (or
+	// this is not an object)
+	const JSONValue& get(const std::string& key) const;
+	//Elements of an array
+	const std::vector<JSONValue>& items() const { return myItems; }
+
+	//Set a member of an object, replacing any of that name
+	JSONValue& set(const std::string& key, const JSONValue& val);
+	//Add an element to an array
+	JSONValue& push(const JSONValue& val);
+private:
+	JSONValue(Kind kind) : myKind(kind), myBool(false), myNum(0){ }
+	Kind myKind;
+	bool myBool;
+	double myNum;
+	std::string myStr;
+	std::vector<JSONValue> myItems;
+	std::vector<Member> myMembers;
+
+	friend class JSONReader;
+};
+
+}
+
+#endif
@@ -0,0 +1,275 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "lsp.hpp"
+#include "symbol_table.hpp"
+#include "types.hpp"
+
+namespace holeyc{
+
+//JSON-RPC error codes
+static const int PARSE_ERROR = -32700;
+static const int INVALID_REQUEST = -32600;
+static const int METHOD_NOT_FOUND = -32601;
+
+int LanguageServer::run(){
+	std::string body;
+	while (!myExit && read(body)){
+		JSONValue msg;
+		if (!JSONValue::parse(body, msg) || msg.kind() != JSONValue::OBJECT){
+			replyError(JSONValue(), PARSE_ERROR, "Parse error");
+			continue;
+		}
+		handle(msg);
+	}
+	return myShutdown ? 0 : 1;
+}
+
+bool LanguageServer::read(std::string& body){
+	//Headers, each ending in \r\n, then an empty line. Only
+	// Content-Length matters.
+	size_t length = 0;
+	bool haveLength = false;
+	std::string header;
+	while (std::getline(myIn, header)){
+		if (!header.empty() && header.back() == '\r'){
+			header.pop_back();
+		}
+		if (header.empty()){
+			if (haveLength){ break; }
+			continue;
+		}
+		const char * name = "Content-Length:";
+		size_t nameLen = std::char_traits<char>::length(name);
+		if (header.compare(0, nameLen, name) == 0){
+			length = std::strtoul(header.c_str() + nameLen, nullptr, 10);
+			haveLength = true;
+		}
+	}
+	if (!haveLength || !myIn){ return false; }
+	body.assign(length, '\0');
+	myIn.read(&body[0], static_cast<std::streamsize>(length));
+	return static_cast<size_t>(myIn.gcount()) == length;
+}
+
+void LanguageServer::send(const JSONValue& msg){
+	std::string body;
+	msg.write(body);
+	myOut << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+	myOut.flush();
+}
+
+void LanguageServer::reply(const JSONValue& id, const JSONValue& result){
+	send(JSONValue::object().set("jsonrpc", "2.0").set("id", id)
+		.set("result", result));
+}
+
+void LanguageServer::replyError(const JSONValue& id, int code,
+	const char * msg){
+	send(JSONValue::object().set("jsonrpc", "2.0").set("id", id)
+		.set("error", JSONValue::object().set("code", code)
+			.set("message", msg)));
+}
+
+void LanguageServer::notify(const char * method, const JSONValue& params){
+	send(JSONValue::object().set("jsonrpc", "2.0").set("method", method)
+		.set("params", params));
+}
+
+void LanguageServer::log(const std::string& msg){
+	//Type 4 is a log message, rather than one to show
+	notify("window/logMessage", JSONValue::object().set("type", 4)
+		.set("message", msg));
+}
+
+void LanguageServer::handle(const JSONValue& msg){
+	const std::string& method = msg.get("method").asString();
+	const JSONValue& id = msg.get("id");
+	const JSONValue& params = msg.get("params");
+	bool isRequest = !id.isNull();
+
+	if (method == "exit"){
+		myExit = true;
+		return;
+	}
+	if (myShutdown){
+		if (isRequest){
+			replyError(id, INVALID_REQUEST, "Server is shut down");
+		}
+		return;
+	}
+	if (method == "initialize"){
+		JSONValue sync = JSONValue::object()
+			.set("openClose", true)
+			//Incremental: changes come as edits to ranges
+			.set("change", 2);
+		JSONValue capabilities = JSONValue::object()
+			.set("positionEncoding", "utf-8")
+			.set("textDocumentSync", sync)
+			.set("hoverProvider", true)
+			.set("definitionProvider", true);
+		reply(id, JSONValue::object().set("capabilities", capabilities)
+			.set("serverInfo", JSONValue::object().set("name", "holeycc")));
+	} else if (method == "shutdown"){
+		myShutdown = true;
+		reply(id, JSONValue());
+	} else if (method == "textDocument/didOpen"){
+		open(params);
+	} else if (method == "textDocument/didChange"){
+		change(params);
+	} else if (method == "textDocument/didClose"){
+		close(params);
+	} else if (method == "textDocument/hover"){
+		hover(id, params);
+	} else if (method == "textDocument/definition"){
+		definition(id, params);
+	} else if (isRequest){
+		replyError(id, METHOD_NOT_FOUND, "Method not found");
+	}
+	//Other notifications (initialized, $/cancelRequest,
+	// didSave, ...) need nothing done
+}
+
+void LanguageServer::open(const JSONValue& params){
+	const JSONValue& item = params.get("textDocument");
+	const std::string& uri = item.get("uri").asString();
+	auto start = std::chrono::steady_clock::now();
+	std::unique_ptr<Document>& doc = myDocs[uri];
+	doc.reset(new Document(item.get("text").asString()));
+	publish(uri, *doc, item.get("version"));
+	std::chrono::duration<double, std::milli> took =
+		std::chrono::steady_clock::now() - start;
+	char msg[128];
+	std::snprintf(msg, sizeof(msg), "opened in %.3f ms (%zu chunks)",
+		took.count(), doc->chunkCount());
+	log(uri + ": " + msg);
+}
+
+void LanguageServer::change(const JSONValue& params){
+	const JSONValue& item = params.get("textDocument");
+	const std::string& uri = item.get("uri").asString();
+	auto found = myDocs.find(uri);
+	if (found == myDocs.end()){ return; }
+	Document& doc = *found->second;
+
+	auto start = std::chrono::steady_clock::now();
+	size_t rescanned = 0;
+	for (const JSONValue& change : params.get("contentChanges").items()){
+		const JSONValue& range = change.get("range");
+		const std::string& text = change.get("text").asString();
+		if (range.isNull()){
+			doc.replace(text);
+		} else {
+			const JSONValue& from = range.get("start");
+			const JSONValue& to = range.get("end");
+			doc.edit(from.get("line").asSize(),
+				from.get("character").asSize(),
+				to.get("line").asSize(), to.get("character").asSize(),
+				text);
+		}
+		rescanned += doc.rescanned();
+	}
+	publish(uri, doc, item.get("version"));
+	std::chrono::duration<double, std::milli> took =
+		std::chrono::steady_clock::now() - start;
+	char msg[160];
+	std::snprintf(msg, sizeof(msg), "edit analysed in %.3f ms"
+		" (%zu chunks: %zu rescanned, %zu reanalysed)",
+		took.count(), doc.chunkCount(), rescanned, doc.analysed());
+	log(uri + ": " + msg);
+}
+
+void LanguageServer::close(const JSONValue& params){
+	const std::string& uri = params.get("textDocument").get("uri").asString();
+	myDocs.erase(uri);
+	myQueries.erase(uri);
+	//Clear what the client shows for the file
+	notify("textDocument/publishDiagnostics", JSONValue::object()
+		.set("uri", uri).set("diagnostics", JSONValue::array()));
+}
+
+bool LanguageServer::symbolAt(const JSONValue& params, SymbolInfo& out,
+	const DataType *& type){
+	type = nullptr;
+	const std::string& uri = params.get("textDocument").get("uri").asString();
+	auto doc = myDocs.find(uri);
+	if (doc == myDocs.end()){ return false; }
+	std::unique_ptr<QueryEngine>& engine = myQueries[uri];
+	if (engine == nullptr){ engine.reset(new QueryEngine()); }
+	//Only the chunks an edit touched are scanned again
+	engine->setText(doc->second->chunkTexts());
+
+	//The protocol counts from 0, we count from 1
+	const JSONValue& pos = params.get("position");
+	size_t line = pos.get("line").asSize() + 1;
+	size_t col = pos.get("character").asSize() + 1;
+	if (engine->symbolAt(line, col, out)){ return true; }
+	type = engine->typeAt(line, col);
+	return false;
+}
+
+void LanguageServer::hover(const JSONValue& id, const JSONValue& params){
+	SymbolInfo info;
+	const DataType * type;
+	std::string text;
+	if (symbolAt(params, info, type)){
+		text = info.symbol->getName() + ": "
+			+ info.symbol->getDataType()->getString() + " ("
+			+ SemSymbol::kindToString(info.symbol->getKind()) + ")";
+	} else if (type != nullptr){
+		text = type->getString();
+	} else {
+		reply(id, JSONValue());
+		return;
+	}
+	reply(id, JSONValue::object().set("contents", JSONValue::object()
+		.set("kind", "plaintext").set("value", text)));
+}
+
+void LanguageServer::definition(const JSONValue& id,
+	const JSONValue& params){
+	SymbolInfo info;
+	const DataType * type;
+	//The prelude has no place in the document
+	if (!symbolAt(params, info, type) || info.line == 0){
+		reply(id, JSONValue());
+		return;
+	}
+	JSONValue at = JSONValue::object().set("line", info.line - 1)
+		.set("character", info.col - 1);
+	reply(id, JSONValue::object()
+		.set("uri", params.get("textDocument").get("uri"))
+		.set("range", JSONValue::object().set("start", at).set("end", at)));
+}
+
+void LanguageServer::publish(const std::string& uri, Document& doc,
+	const JSONValue& version){
+	doc.analyse();
+	JSONValue diags = JSONValue::array();
+	for (const Diagnostic& diag : doc.diagnostics()){
+		//Ours count from 1, the protocol's from 0
+		size_t line = diag.line > 0 ? diag.line - 1 : 0;
+		size_t col = diag.col > 0 ? diag.col - 1 : 0;
+		JSONValue range = JSONValue::object()
+			.set("start", JSONValue::object().set("line", line)
+				.set("character", col))
+			.set("end", JSONValue::object().set("line", line)
+				.set("character", col + 1));
+		diags.push(JSONValue::object().set("range", range)
+			.set("severity", diag.severity == Diagnostic::FATAL ? 1 : 2)
+			.set("code", "E" + std::to_string(
+				static_cast<unsigned>(diag.code)))
+			.set("source", "holeycc")
+			.set("message", diag.message()));
+	}
+	JSONValue params = JSONValue::object().set("uri", uri)
+		.set("diagnostics", diags);
+	if (!version.isNull()){ params.set("version", version); }
+	notify("textDocument/publishDiagnostics", params);
+	for (const std::string& failure : doc.failures()){
+		log(uri + ": InternalError: " + failure);
+	}
+}
+
+}
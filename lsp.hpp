@@ -0,0 +1,62 @@
+#ifndef HOLEYC_LSP_HPP
+#define HOLEYC_LSP_HPP
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "document.hpp"
+#include "json.hpp"
+#include "query.hpp"
+
+namespace holeyc{
+
+//A language server speaking JSON-RPC over a pair of streams
+// (holeycc --lsp uses stdin and stdout). It keeps every open
+// document analysed, and after each change publishes the
+// document's diagnostics, logging how long the update took
+// and how much of the document it had to redo. Hover and
+// go-to-definition are answered by a query engine per
+// document, given the document's chunks on demand.
+class LanguageServer{
+public:
+	LanguageServer(std::istream& in, std::ostream& out)
+	: myIn(in), myOut(out){ }
+	//Serve until the client says to exit or closes the
+	// input. Returns the exit code: 0 only if the client
+	// shut the server down first.
+	int run();
+private:
+	//Read one message body; false at the end of the input
+	bool read(std::string& body);
+	void send(const JSONValue& msg);
+	void handle(const JSONValue& msg);
+	void reply(const JSONValue& id, const JSONValue& result);
+	void replyError(const JSONValue& id, int code, const char * msg);
+	void notify(const char * method, const JSONValue& params);
+	void log(const std::string& msg);
+
+	void open(const JSONValue& params);
+	void change(const JSONValue& params);
+	void close(const JSONValue& params);
+	//The symbol at a request's position, if any
+	bool symbolAt(const JSONValue& params, SymbolInfo& out,
+		const DataType *& type);
+	void hover(const JSONValue& id, const JSONValue& params);
+	void definition(const JSONValue& id, const JSONValue& params);
+	//Analyse the document and send its diagnostics
+	void publish(const std::string& uri, Document& doc,
+		const JSONValue& version);
+
+	std::istream& myIn;
+	std::ostream& myOut;
+	std::map<std::string, std::unique_ptr<Document>> myDocs;
+	std::map<std::string, std::unique_ptr<QueryEngine>> myQueries;
+	bool myShutdown = false;
+	bool myExit = false;
+};
+
+}
+
+#endif
@@ -1,4 +1,7 @@
 #include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
 #include <string.h>
 
 #include "errors.hpp"
@@ -6,16 +9,61 @@
 #include "ast.hpp"
 #include "name_analysis.hpp"
 #include "type_analysis.hpp"
+#include "serialize.hpp"
+#include "emit.hpp"
+#include "parallel.hpp"
+#include "lsp.hpp"
+#include "fn_cache.hpp"
+#include "query.hpp"
+#include "symbol_index.hpp"
+#include "3ac.hpp"
 
 using namespace holeyc;
 
+//Set when the input file is a serialized AST rather than
+// source code. Passes then load the tree from the image
+// instead of scanning and parsing.
+static holeyc::ASTReader * astImage = nullptr;
+
+//The source path, if type checking should keep the results
+// of its functions in a sidecar for the next compilation
+static const char * incrementalPath = nullptr;
+
+//Diagnostics are buffered, so every exit after the options
+// are read goes through here to write them out
+static int finish(int exitCode){
+	holeyc::Report::finish(exitCode);
+	return exitCode;
+}
+
 static void usageAndDie(){
 	std::cerr << "Usage: holeycc <infile> <options>\n"
+	<< "       holeycc --lsp: Serve the language server protocol\n"
+	<< "   on stdin and stdout\n"
+	<< "       holeycc --merge-index <outFile> <indexFile>...:\n"
+	<< "   Merge symbol indexes into <outFile>\n"
+	<< "       holeycc --find <indexFile> <name>...: Look up\n"
+	<< "   global symbols in a symbol index\n"
 	<< " [-t <tokensFile>]: Output tokens to <tokensFile>\n"
 	<< " [-p]: Parse the input to check syntax\n"
+	<< " [-b <astFile>]: Output the serialized AST to <astFile>\n"
 	<< " [-u <unparseFile>]: Unparse to <unparseFile>\n"
 	<< " [-n <nameFile]: Output name analysis to <namesFile>\n"
 	<< " [-c]: Do type checking\n"
+	<< " [-a <3acFile>]: Output three-address code to <3acFile>\n"
+	<< " [-s <ssaFile>]: Output three-address code in SSA form\n"
+	<< "   to <ssaFile>\n"
+	<< " [-j <jobs>]: Use up to <jobs> threads (default 1)\n"
+	<< " [--diagnostics-format=<text|json>]: Report diagnostics\n"
+	<< "   as text (the default) or as one JSON record per line\n"
+	<< " [--incremental]: With -c, keep each function's results\n"
+	<< "   in <infile>.fncache and reuse them next time\n"
+	<< " [-x <indexFile>]: Output an index of the global symbols\n"
+	<< "   to <indexFile>\n"
+	<< " [-q <query>]: Answer a query about <infile> (repeatable):\n"
+	<< "   diagnostics, diagnostics:<fn>, type:<line>:<col>,\n"
+	<< "   symbol:<line>:<col>, decl:<name> or stats. <infile>\n"
+	<< "   must be source code, not an AST image\n"
 	<< "\n"
 	;
 	std::cout << std::flush;
@@ -24,6 +72,9 @@ static void usageAndDie(){
 }
 
 static void doTokenization(std::ifstream * input, const char * outPath){
+	if (astImage != nullptr){
+		throw new holeyc::InternalError("Cannot tokenize an AST image");
+	}
 	holeyc::Scanner scanner(input);
 	if (strcmp(outPath, "--") == 0){
 		scanner.outputTokens(std::cout);
@@ -42,6 +93,9 @@ static holeyc::ProgramNode * syntacticAnalysis(std::ifstream * input){
 	if (input == nullptr){
 		return nullptr;
 	}
+	if (astImage != nullptr){
+		return astImage->program();
+	}
 
 	holeyc::ProgramNode * root = nullptr;
 
@@ -60,24 +114,14 @@ static holeyc::ProgramNode * syntacticAnalysis(std::ifstream * input){
 	return root;
 }
 
-static void outputAST(ASTNode * ast, const char * outPath){
-	if (strcmp(outPath, "--") == 0){
-		ast->unparse(std::cout, 0);
-	} else {
-		std::ofstream outStream(outPath);
-		if (!outStream.good()){
-			std::string msg = "Bad output file ";
-			msg += outPath;
-			throw new holeyc::InternalError(msg.c_str());
-		}
-		ast->unparse(outStream, 0);
-	}
+static void outputAST(ProgramNode * ast, const char * outPath){
+	holeyc::UnparseEmitter::emit(ast, outPath);
 }
 
 static bool doUnparsing(std::ifstream * input, const char * outPath){
 	holeyc::ProgramNode * ast = syntacticAnalysis(input);
 	if (ast == nullptr){ 
-		std::cerr << "No AST built\n";
+		holeyc::Report::status("No AST built\n");
 		return false;
 	}
 	if (input == nullptr){ 
@@ -85,6 +129,21 @@ static bool doUnparsing(std::ifstream * input, const char * outPath){
 	}
 
 	outputAST(ast, outPath);
+	delete ast;
+	return true;
+}
+
+static bool doSerialization(std::ifstream * input, const char * outPath){
+	holeyc::ProgramNode * ast = syntacticAnalysis(input);
+	if (ast == nullptr){ 
+		holeyc::Report::status("No AST built\n");
+		return false;
+	}
+
+	holeyc::ASTWriter writer;
+	ast->serialize(&writer);
+	writer.write(outPath);
+	delete ast;
 	return true;
 }
 
@@ -95,15 +154,267 @@ static holeyc::NameAnalysis * doNameAnalysis(std::ifstream * input){
 	return holeyc::NameAnalysis::build(ast);
 }
 
-static holeyc::TypeAnalysis * doTypeAnalysis(std::ifstream * input){
+static holeyc::TypeAnalysis * doTypeAnalysis(std::ifstream * input,
+	bool useCache = true){
+	//Serially, name and type analysis share one walk. With
+	// several jobs, each runs as its own parallel pass. The
+	// sidecar is only kept by the serial walk.
+	if (useCache && incrementalPath != nullptr && astImage == nullptr){
+		holeyc::ProgramNode * ast = syntacticAnalysis(input);
+		if (ast == nullptr){ return nullptr; }
+		holeyc::FnCache cache(incrementalPath, ast);
+		holeyc::TypeAnalysis * ta = nullptr;
+		try {
+			ta = holeyc::TypeAnalysis::buildFused(ast, &cache);
+		} catch (...) {
+			cache.save();
+			throw;
+		}
+		cache.save();
+		return ta;
+	}
+	if (holeyc::Parallel::jobs() <= 1){
+		holeyc::ProgramNode * ast = syntacticAnalysis(input);
+		if (ast == nullptr){ return nullptr; }
+		return holeyc::TypeAnalysis::buildFused(ast);
+	}
 	holeyc::NameAnalysis * nameAnalysis = doNameAnalysis(input);
 	if (nameAnalysis == nullptr){ return nullptr; }
 
 	return holeyc::TypeAnalysis::build(nameAnalysis);
 }
 
+//Fold constants, lower to 3AC and put it in SSA form, which
+// is where later passes work, then (unless ssa) convert it
+// back
+static bool doLowering(std::ifstream * input, const char * outPath,
+	bool ssa){
+	//Functions replayed from the sidecar don't record the
+	// types of their nodes, which lowering needs
+	holeyc::TypeAnalysis * ta = doTypeAnalysis(input, false);
+	if (ta == nullptr){
+		holeyc::Report::status("Type Analysis Failed\n");
+		return false;
+	}
+	holeyc::IRProgram * prog = nullptr;
+	try {
+		ta->ast->fold(ta);
+		prog = ta->ast->to3AC(ta);
+		prog->toSSA();
+		if (!ssa){ prog->fromSSA(); }
+		if (strcmp(outPath, "--") == 0){
+			prog->toString(std::cout);
+		} else {
+			std::ofstream outStream(outPath);
+			if (!outStream.good()){
+				std::string msg = "Bad output file ";
+				msg += outPath;
+				throw new holeyc::InternalError(msg.c_str());
+			}
+			prog->toString(outStream);
+		}
+	} catch (...) {
+		delete prog;
+		delete ta;
+		throw;
+	}
+	delete prog;
+	delete ta;
+	return true;
+}
+
+//Parse "<line>:<col>" from the rest of a query
+static bool position(const std::string& query, size_t from,
+	size_t& line, size_t& col){
+	size_t colon = query.find(':', from);
+	if (colon == std::string::npos){ return false; }
+	line = strtoul(query.c_str() + from, nullptr, 10);
+	col = strtoul(query.c_str() + colon + 1, nullptr, 10);
+	return line != 0 && col != 0;
+}
+
+//Answer each query in turn from one engine, so that later
+// ones reuse what earlier ones computed. Returns false if
+// the diagnostics asked for say the program is bad. The
+// engine works from the text of the file, so an AST image
+// can't be queried.
+static bool doQueries(const char * path,
+	const std::vector<const char *>& queries){
+	if (astImage != nullptr){
+		throw new holeyc::InternalError(
+			"Cannot query an AST image; query its source instead");
+	}
+	std::ifstream in(path, std::ios::binary);
+	std::ostringstream text;
+	text << in.rdbuf();
+	holeyc::QueryEngine engine;
+	engine.setText(text.str());
+
+	bool res = true;
+	for (const char * queryStr : queries){
+		std::string query(queryStr);
+		size_t line, col;
+		if (query == "diagnostics"){
+			const holeyc::ProgramDiagnostics& diags = engine.diagnostics();
+			for (const holeyc::Diagnostic& diag : diags.diags){
+				holeyc::Report::buffer().add(diag);
+			}
+			if (!diags.failure.empty()){
+				holeyc::Report::status(diags.failure);
+				res = false;
+			} else if (!diags.passed){
+				holeyc::Report::status("Type Analysis Failed\n");
+				res = false;
+			}
+		} else if (query.compare(0, 12, "diagnostics:") == 0){
+			std::vector<holeyc::Diagnostic> diags;
+			std::string failure;
+			if (!engine.fnDiagnostics(query.substr(12), diags, failure)){
+				std::cout << "?\n";
+				continue;
+			}
+			for (const holeyc::Diagnostic& diag : diags){
+				holeyc::Report::buffer().add(diag);
+			}
+			holeyc::Report::flush();
+			if (!failure.empty()){ holeyc::Report::status(failure); }
+		} else if (query.compare(0, 5, "type:") == 0
+			&& position(query, 5, line, col)){
+			const holeyc::DataType * type = engine.typeAt(line, col);
+			std::cout << (type == nullptr ? "?" : type->getString()) << "\n";
+		} else if (query.compare(0, 7, "symbol:") == 0
+			&& position(query, 7, line, col)){
+			holeyc::SymbolInfo info;
+			if (!engine.symbolAt(line, col, info)){
+				std::cout << "?\n";
+				continue;
+			}
+			std::cout << info.symbol->getName() << " "
+				<< holeyc::SemSymbol::kindToString(info.symbol->getKind())
+				<< " " << info.symbol->getDataType()->getString();
+			if (info.line == 0){
+				std::cout << " prelude\n";
+			} else {
+				std::cout << " [" << info.line << "," << info.col << "]\n";
+			}
+		} else if (query.compare(0, 5, "decl:") == 0){
+			holeyc::DeclNode * decl = engine.declaration(query.substr(5));
+			if (decl == nullptr){
+				std::cout << "?\n";
+				continue;
+			}
+			decl->unparse(std::cout, 0);
+		} else if (query == "stats"){
+			std::cout << engine.computed() << " computed, "
+				<< engine.reused() << " reused\n";
+		} else {
+			std::cerr << "Unknown query " << query << "\n";
+			usageAndDie();
+		}
+	}
+	return res;
+}
+
+//The globals of an AST image, as QueryEngine::globals finds
+// them in source: the first declaration of each name that
+// binds a symbol. Declarations are decoded one at a time.
+static void imageGlobals(const char * path,
+	std::vector<holeyc::IndexedSymbol>& symbols){
+	std::set<std::string> bound;
+	for (size_t i = 0; i < astImage->declCount(); i++){
+		std::unique_ptr<holeyc::DeclNode> decl(astImage->decl(i));
+		std::unique_ptr<holeyc::SemSymbol> symbol(
+			holeyc::QueryEngine::signature(decl.get()));
+		if (symbol == nullptr || !bound.insert(symbol->getName()).second){
+			continue;
+		}
+		symbols.push_back(holeyc::IndexedSymbol{symbol->getName(),
+			symbol->getKind(), symbol->getDataType()->getString(),
+			path, decl->ID()->line(), decl->ID()->col()});
+	}
+}
+
+static void doIndexing(const char * path, const char * outPath){
+	std::vector<holeyc::IndexedSymbol> symbols;
+	if (astImage != nullptr){
+		imageGlobals(path, symbols);
+	} else {
+		std::ifstream in(path, std::ios::binary);
+		std::ostringstream text;
+		text << in.rdbuf();
+		holeyc::QueryEngine engine;
+		engine.setText(text.str());
+		for (const holeyc::SymbolInfo& global : engine.globals()){
+			holeyc::SemSymbol * symbol = global.symbol;
+			symbols.push_back(holeyc::IndexedSymbol{symbol->getName(),
+				symbol->getKind(), symbol->getDataType()->getString(),
+				path, global.line, global.col});
+		}
+	}
+	holeyc::SymbolIndexWriter writer;
+	writer.addFile(path, symbols);
+	writer.write(outPath);
+}
+
+//holeycc --merge-index <out> <index>...: a file in more
+// than one index takes its symbols from the last
+static int doMergeIndex(int argc, char * argv[]){
+	if (argc < 3){ usageAndDie(); }
+	holeyc::SymbolIndexWriter writer;
+	for (int i = 3; i < argc; i++){
+		holeyc::SymbolIndex * index = holeyc::SymbolIndex::open(argv[i]);
+		try {
+			index->addTo(writer);
+		} catch (...) {
+			delete index;
+			throw;
+		}
+		delete index;
+	}
+	writer.write(argv[2]);
+	return 0;
+}
+
+//holeycc --find <index> <name>...: one line per declaration,
+// like a diagnostic. Fails if some name is not found.
+static int doFind(int argc, char * argv[]){
+	if (argc < 4){ usageAndDie(); }
+	std::unique_ptr<holeyc::SymbolIndex> index(
+		holeyc::SymbolIndex::open(argv[2]));
+	int res = 0;
+	for (int i = 3; i < argc; i++){
+		size_t first, count;
+		if (!index->find(argv[i], first, count)){
+			res = 1;
+			continue;
+		}
+		for (size_t j = first; j < first + count; j++){
+			holeyc::IndexedSymbol symbol = index->symbol(j);
+			std::cout << symbol.file << ":" << symbol.line << ":"
+				<< symbol.col << ": " << symbol.name << " "
+				<< holeyc::SemSymbol::kindToString(symbol.kind) << " "
+				<< symbol.type << "\n";
+		}
+	}
+	return res;
+}
+
 int main(int argc, char * argv[]){
 	if (argc <= 1){ usageAndDie(); }
+	if (strcmp(argv[1], "--lsp") == 0){
+		holeyc::LanguageServer server(std::cin, std::cout);
+		return server.run();
+	}
+	bool merge = strcmp(argv[1], "--merge-index") == 0;
+	if (merge || strcmp(argv[1], "--find") == 0){
+		try {
+			return merge ? doMergeIndex(argc, argv) : doFind(argc, argv);
+		} catch (holeyc::InternalError * e){
+			holeyc::Report::status(std::string("InternalError: ") 
+				+ e->msg() + "\n");
+			return finish(1);
+		}
+	}
 	std::ifstream * input = new std::ifstream(argv[1]);
 	if (input == NULL){ usageAndDie(); }
 	if (!input->good()){
@@ -117,15 +428,30 @@ int main(int argc, char * argv[]){
 					   // syntactic analysis
 	const char * unparseFile = NULL;   // Output file if 
 	                                   // unparsing
+	const char * astFile = NULL;	   // Output file if 
+					   // serializing the AST
 	const char * nameFile = NULL;	   // Output file if doing
 					   // name analysis
 	bool useful = false; // Check whether the command is 
                          // a no-op
 	bool checkTypes = false;	   // Flag set if doing 
 					   // syntactic analysis
+	std::vector<const char *> queries; // Queries to answer
+	const char * indexFile = nullptr;  // Output file if 
+	                                   // indexing symbols
+	const char * irFile = nullptr;     // Output file if 
+	                                   // lowering to 3AC
+	bool ssa = false;                  // Whether to output
+	                                   // it in SSA form
 	for (int i = 1; i < argc; i++){
 		if (argv[i][0] == '-'){
-			if (argv[i][1] == 't'){
+			if (strcmp(argv[i], "--diagnostics-format=text") == 0){
+				holeyc::Report::setFormat(holeyc::DiagFormat::TEXT);
+			} else if (strcmp(argv[i], "--diagnostics-format=json") == 0){
+				holeyc::Report::setFormat(holeyc::DiagFormat::JSON);
+			} else if (strcmp(argv[i], "--incremental") == 0){
+				incrementalPath = argv[1];
+			} else if (argv[i][1] == 't'){
 				i++;
 				if (i >= argc){ usageAndDie(); }
 				tokensFile = argv[i];
@@ -134,6 +460,11 @@ int main(int argc, char * argv[]){
 				i++;
 				checkParse = true;
 				useful = true;
+			} else if (argv[i][1] == 'b'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				astFile = argv[i];
+				useful = true;
 			} else if (argv[i][1] == 'u'){
 				i++;
 				if (i >= argc){ usageAndDie(); }
@@ -144,6 +475,35 @@ int main(int argc, char * argv[]){
 				if (i >= argc){ usageAndDie(); }
 				nameFile = argv[i];
 				useful = true;
+			} else if (argv[i][1] == 'j'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				int jobs = atoi(argv[i]);
+				if (jobs <= 0){ usageAndDie(); }
+				holeyc::Parallel::setJobs(
+				  static_cast<unsigned>(jobs));
+			} else if (argv[i][1] == 'x'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				indexFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'a'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				irFile = argv[i];
+				ssa = false;
+				useful = true;
+			} else if (argv[i][1] == 's'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				irFile = argv[i];
+				ssa = true;
+				useful = true;
+			} else if (argv[i][1] == 'q'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				queries.push_back(argv[i]);
+				useful = true;
 			} else if (argv[i][1] == 'c'){
 				i++;
 				checkTypes = true;
@@ -163,41 +523,65 @@ int main(int argc, char * argv[]){
 
 
 	try {
+		if (holeyc::ASTReader::isImage(argv[1])){
+			astImage = holeyc::ASTReader::open(argv[1]);
+		}
 		if (tokensFile != nullptr){
 			doTokenization(input, tokensFile);
 		}
 		if (checkParse){
-			if (!syntacticAnalysis(input)){
-				std::cerr << "Parse failed";
+			//Opening an image only checks its header, so an
+			// image is decoded in full to check its nodes
+			holeyc::ProgramNode * ast = syntacticAnalysis(input);
+			if (ast == nullptr){
+				holeyc::Report::status("Parse failed");
 			}
+			delete ast;
+		}
+		if (astFile != nullptr){
+			doSerialization(input, astFile);
 		}
 		if (unparseFile != nullptr){
 			doUnparsing(input, unparseFile);
 		}
+		if (indexFile != nullptr){
+			doIndexing(argv[1], indexFile);
+		}
+		if (!queries.empty() && !doQueries(argv[1], queries)){
+			return finish(1);
+		}
 		if (nameFile){
 			holeyc::NameAnalysis * na;
 			na = doNameAnalysis(input); 
 			if (na != nullptr){
 				outputAST(na->ast, nameFile);
-				return 0;
+				delete na;
+				return finish(0);
 			}
-			std::cerr << "Name Analysis Failed\n";
-			return 1;
+			holeyc::Report::status("Name Analysis Failed\n");
+			return finish(1);
+		}
+		if (irFile != nullptr){
+			return finish(doLowering(input, irFile, ssa) ? 0 : 1);
 		}
 		if (checkTypes){
-			if (doTypeAnalysis(input) != nullptr){
-				return 0;
+			holeyc::TypeAnalysis * ta = doTypeAnalysis(input);
+			if (ta != nullptr){
+				delete ta;
+				return finish(0);
 			}
-			std::cerr << "Type Analysis Failed\n";
-			return 1;
+			holeyc::Report::status("Type Analysis Failed\n");
+			return finish(1);
 		}
 	} catch (holeyc::ToDoError * e){
-		std::cerr << "ToDoError: " << e->msg() << "\n";
-		return 1;
+		holeyc::Report::status(std::string("ToDoError: ") 
+			+ e->msg() + "\n");
+		return finish(1);
 	} catch (holeyc::InternalError * e){
-		std::cerr << "InternalError: " << e->msg() << "\n";
-		return 1;
+		holeyc::Report::status(std::string("InternalError: ") 
+			+ e->msg() + "\n");
+		return finish(1);
 	}
 
-	return 0;
+	return finish(0);
 }
@@ -2,21 +2,84 @@
 #include "symbol_table.hpp"
 #include "errName.hpp"
 #include "types.hpp"
+#include "parallel.hpp"
+#include <vector>
 
 namespace holeyc{
 
 bool ProgramNode::nameAnalysis(SymbolTable * symTab){
+	if (Parallel::jobs() > 1 && myGlobals->size() > 1){
+		return nameAnalysisParallel(symTab);
+	}
 	//Enter the global scope
 	symTab->enterScope();
 	bool res = true;
 	for (auto decl : *myGlobals){
+		symTab->takeSnapshot();
 		res = decl->nameAnalysis(symTab) && res;
 	}
+	symTab->takeSnapshot();
 	//Leave the global scope
 	symTab->leaveScope();
 	return res;
 }
 
+//Function bodies only read the global scope, so once a 
+// serial pre-pass has bound every global variable and 
+// function signature, the bodies can be analysed 
+// concurrently. Each body gets its own table over the 
+// snapshot of the global scope taken just after its own
+// declaration, so it only sees the globals bound by it and
+// the declarations before it. Diagnostics are 
+// buffered per declaration and written in the order the 
+// serial pass would have produced them.
+bool ProgramNode::nameAnalysisParallel(SymbolTable * symTab){
+	std::vector<DeclNode *> decls(myGlobals->begin(), myGlobals->end());
+	size_t count = decls.size();
+	std::vector<DiagBuffer> declErrs(count);
+	std::vector<DiagBuffer> bodyErrs(count);
+	//Not vector<bool>, whose elements share bytes
+	std::vector<char> declOK(count);
+	std::vector<char> bodyOK(count);
+	std::vector<SymbolTable *> bodyTabs(count, nullptr);
+
+	symTab->enterScope();
+	DiagBuffer * errs = Report::redirect(nullptr);
+	for (size_t i = 0; i < count; i++){
+		symTab->takeSnapshot();
+		Report::redirect(&declErrs[i]);
+		declOK[i] = decls[i]->nameAnalysisDecl(symTab);
+	}
+	symTab->takeSnapshot();
+	Report::redirect(errs);
+
+	try {
+		Parallel::forEach(count, [&](size_t i){
+			const PersistentScopeTable& globals = symTab->getSnapshot(i + 1);
+			bodyTabs[i] = new SymbolTable(globals.enterScope());
+			DiagBuffer * prev = Report::redirect(&bodyErrs[i]);
+			bodyOK[i] = decls[i]->nameAnalysisBody(bodyTabs[i]);
+			Report::redirect(prev);
+		});
+	} catch (...) {
+		for (SymbolTable * bodyTab : bodyTabs){ delete bodyTab; }
+		throw;
+	}
+
+	bool res = true;
+	for (size_t i = 0; i < count; i++){
+		errs->append(declErrs[i]);
+		errs->append(bodyErrs[i]);
+		res = declOK[i] && bodyOK[i] && res;
+		//The AST points at the body's symbols, so they must
+		// live as long as the main table
+		symTab->adopt(bodyTabs[i]);
+		delete bodyTabs[i];
+	}
+	symTab->leaveScope();
+	return res;
+}
+
 bool AssignStmtNode::nameAnalysis(SymbolTable * symTab){
 	return myExp->nameAnalysis(symTab);
 }
@@ -77,7 +140,7 @@ bool WhileStmtNode::nameAnalysis(SymbolTable * symTab){
 
 bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 	DataType * dataType = getTypeNode()->getType();
-	std::string varName = ID()->getName();
+	const std::string& varName = ID()->getName();
 
 	bool validType = dataType->validVarType();
 	if (!validType){
@@ -92,48 +155,66 @@ bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 	if (!validType || !validName){ 
 		return false; 
 	} else {
-		symTab->insert(new VarSymbol(varName, dataType));
+		VarSymbol * symbol = new VarSymbol(varName, dataType);
+		symTab->insert(symbol);
+		ID()->attachSymbol(symbol);
 		return true;
 	}
 }
 
 bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
-	std::string fnName = this->ID()->getName();
+	bool validDecl = nameAnalysisDecl(symTab);
+	bool validBody = nameAnalysisBody(symTab);
+	return validDecl && validBody;
+}
 
-	bool validRet = myRetType->nameAnalysis(symTab);
+bool FnDeclNode::nameAnalysisDecl(SymbolTable * symTab){
+	const std::string& fnName = this->ID()->getName();
 
-	// hold onto the scope of the function.
-	ScopeTable * atFnScope = symTab->getCurrentScope();
-	//Enter a new scope for "within" this function.
-	ScopeTable * inFnScope = symTab->enterScope();
+	bool validRet = myRetType->nameAnalysis(symTab);
 
 	/*Note that we check for a clash of the function 
 	  name in it's declared scope (e.g. a global
 	  scope for a global function)
 	*/
 	bool validName = true;
-	if (atFnScope->clash(fnName)){
+	if (symTab->clash(fnName)){
 		NameErr::multiDecl(ID()->line(), ID()->col()); 
 		validName = false;
 	}
 
-	bool validFormals = true;
-	std::list<const DataType *> * formalTypes = 
-		new std::list<const DataType *>();
+	std::vector<const DataType *> formalTypes;
+	formalTypes.reserve(myFormals->size());
 	for (auto formal : *(this->myFormals)){
-		validFormals = formal->nameAnalysis(symTab) && validFormals;
 		TypeNode * typeNode = formal->getTypeNode();
 		const DataType * formalType = typeNode->getType();
-		formalTypes->push_back(formalType);
+		formalTypes.push_back(formalType);
 	}
 
-
+	//The function's (interned) type is built once, here, and
+	// carried by its symbol; type analysis reads it back 
+	// through the ID rather than rebuilding it.
 	const DataType * retType = this->getRetTypeNode()->getType();
-	FnType * dataType = new FnType(formalTypes, retType);
+	FnType * dataType = FnType::produce(formalTypes, retType);
 	//Make sure the fnSymbol is in the symbol table before 
-	// analyzing the body, to allow for recursive calls
+	// analyzing the body, to allow for recursive calls.
+	// This happens before entering the function's own
+	// scope, so the symbol lands in the declaring scope.
 	if (validName){
-		atFnScope->addFn(fnName, dataType);
+		FnSymbol * fnSymbol = new FnSymbol(fnName, dataType);
+		symTab->insert(fnSymbol);
+		ID()->attachSymbol(fnSymbol);
+	}
+	return validRet && validName;
+}
+
+bool FnDeclNode::nameAnalysisBody(SymbolTable * symTab){
+	//Enter a new scope for "within" this function.
+	symTab->enterScope();
+
+	bool validFormals = true;
+	for (auto formal : *(this->myFormals)){
+		validFormals = formal->nameAnalysis(symTab) && validFormals;
 	}
 
 	bool validBody = true;
@@ -142,7 +223,7 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 	}
 
 	symTab->leaveScope();
-	return (validRet && validFormals && validName && validBody);
+	return validFormals && validBody;
 }
 
 bool RefNode::nameAnalysis(SymbolTable * symTab){
@@ -230,7 +311,7 @@ bool FalseNode::nameAnalysis(SymbolTable * symTab){
 }
 
 bool IDNode::nameAnalysis(SymbolTable* symTab){
-	std::string myName = this->getName();
+	const std::string& myName = this->getName();
 	SemSymbol * sym = symTab->find(myName);
 	if (sym == nullptr){
 		return NameErr::undeclID(line(), col());
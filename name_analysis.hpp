@@ -3,26 +3,80 @@
 
 #include "ast.hpp"
 #include "symbol_table.hpp"
+#include "prelude.hpp"
 
 namespace holeyc{
 
 class NameAnalysis{
 public:
-	static NameAnalysis * build(ProgramNode * astIn){
-		NameAnalysis * nameAnalysis = new NameAnalysis;
-		SymbolTable * symTab = new SymbolTable();
-		bool res = astIn->nameAnalysis(symTab);
-		delete symTab;
-		if (!res){ return nullptr; }
-
-		nameAnalysis->ast = astIn;
+	//Takes ownership of the AST: if the analysis fails (or
+	// throws), the tree is freed along with the analysis.
+	// Unless told otherwise, the program's globals are nested
+	// inside the shared prelude scope.
+	static NameAnalysis * build(ProgramNode * astIn, 
+		bool usePrelude = true){
+		NameAnalysis * nameAnalysis = create(astIn, usePrelude);
+		bool res;
+		try {
+			res = astIn->nameAnalysis(nameAnalysis->symTab);
+		} catch (...) {
+			delete nameAnalysis;
+			throw;
+		}
+		if (!res){ 
+			delete nameAnalysis;
+			return nullptr; 
+		}
 		return nameAnalysis;
 	}
+	//Name analysis that hands each declaration to typeAnalysis
+	// as soon as its names are bound (see 
+	// TypeAnalysis::buildFused). Returns the analysis even if
+	// it failed, for the caller to clean up; if it throws, the
+	// analysis and the tree are freed here.
+	static NameAnalysis * buildFused(ProgramNode * astIn, 
+		TypeAnalysis * typeAnalysis, bool& passed, 
+		FnCache * cache){
+		NameAnalysis * nameAnalysis = create(astIn, true);
+		try {
+			passed = astIn->fusedAnalysis(nameAnalysis->symTab, 
+				typeAnalysis, cache);
+		} catch (...) {
+			delete nameAnalysis;
+			throw;
+		}
+		return nameAnalysis;
+	}
+	//The symbol table is kept alive (rather than deleted
+	// after the pass) because the IDNodes of the AST point
+	// at its symbols.
+	~NameAnalysis(){
+		delete ast;
+		delete symTab;
+	}
+	//The global scope as it stood after the last 
+	// declaration
+	const PersistentScopeTable& globalScope() const {
+		return symTab->getSnapshot(ast->getGlobals()->size());
+	}
 	ProgramNode * ast;
 
 private:
 	NameAnalysis(){
 	}
+	static NameAnalysis * create(ProgramNode * astIn, 
+		bool usePrelude){
+		NameAnalysis * nameAnalysis = new NameAnalysis;
+		nameAnalysis->ast = astIn;
+		if (usePrelude){
+			nameAnalysis->symTab = new SymbolTable(
+				Prelude::scope().enterScope());
+		} else {
+			nameAnalysis->symTab = new SymbolTable();
+		}
+		return nameAnalysis;
+	}
+	SymbolTable * symTab;
 };
 
 }
@@ -0,0 +1,139 @@
+#ifndef HOLEYC_OPERATORS_HPP
+#define HOLEYC_OPERATORS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace holeyc{
+
+//Every operator of an expression node. Unary operators
+// come last.
+enum OpKind : uint8_t {
+	PLUS_OP, MINUS_OP, TIMES_OP, DIVIDE_OP,
+	AND_OP, OR_OP,
+	EQUALS_OP, NOT_EQUALS_OP,
+	LESS_OP, LESS_EQ_OP, GREATER_OP, GREATER_EQ_OP,
+	NEG_OP, NOT_OP,
+	OP_KIND_COUNT
+};
+
+//What the operator rules can tell apart about an operand's
+// type: its kind, and for basic types which one it is
+enum OpdClass : uint8_t {
+	ERROR_OPD, INT_OPD, VOID_OPD, BOOL_OPD, CHAR_OPD, PTR_OPD, FN_OPD,
+	OPD_CLASS_COUNT
+};
+
+//The diagnostics an operator can report about an operand
+enum OpDiag : uint8_t {
+	NO_DIAG, MATH_OPD_DIAG, MATH_OPR_DIAG, LOGIC_OPD_DIAG,
+	REL_OPD_DIAG, EQ_OPD_DIAG, EQ_OPR_DIAG
+};
+
+//A diagnostic, and whether it is reported at the right
+// operand rather than the left (or only) one
+struct OpCheck {
+	OpDiag diag;
+	bool atRight;
+};
+
+//The outcome of applying an operator: the class of the
+// result (ERROR_OPD if the operation is ill-typed) and up to
+// two diagnostics, reported in order
+struct OpRule {
+	OpdClass result;
+	OpCheck first;
+	OpCheck second;
+};
+
+namespace op_rules{
+
+constexpr OpCheck none(){ return OpCheck{NO_DIAG, false}; }
+constexpr OpCheck left(OpDiag diag){ return OpCheck{diag, false}; }
+constexpr OpCheck right(OpDiag diag){ return OpCheck{diag, true}; }
+
+constexpr OpRule ok(OpdClass result){
+	return OpRule{result, none(), none()};
+}
+constexpr OpRule bad(OpCheck first, OpCheck second = none()){
+	return OpRule{ERROR_OPD, first, second};
+}
+
+constexpr bool isScalar(OpdClass c){
+	return c == INT_OPD || c == BOOL_OPD || c == CHAR_OPD;
+}
+
+//Operands of class want, producing result. A bad right
+// operand is reported as rightDiag; a bad left one as
+// leftDiag, followed by otherDiag at the right operand
+// unless that one is of class otherOk.
+constexpr OpRule typed(OpdClass want, OpdClass result,
+	OpdClass l, OpdClass r, OpDiag leftDiag, OpDiag rightDiag,
+	OpdClass otherOk, OpDiag otherDiag){
+	return l != want ? bad(left(leftDiag),
+			r == otherOk ? none() : right(otherDiag))
+		: r != want ? bad(right(rightDiag))
+		: ok(result);
+}
+
+//The rule for op with operands of class l and r (r is
+// ignored for unary operators). same says whether the two
+// operand types are identical, which only matters for
+// pointers and functions: every other class is one type.
+constexpr OpRule rule(OpKind op, OpdClass l, OpdClass r, bool same){
+	return op == PLUS_OP || op == MINUS_OP
+		|| op == TIMES_OP || op == DIVIDE_OP
+		? typed(INT_OPD, INT_OPD, l, r,
+			MATH_OPR_DIAG, MATH_OPR_DIAG, INT_OPD, MATH_OPR_DIAG)
+	: op == AND_OP || op == OR_OP
+		? typed(BOOL_OPD, BOOL_OPD, l, r,
+			REL_OPD_DIAG, LOGIC_OPD_DIAG, BOOL_OPD, LOGIC_OPD_DIAG)
+	: op == LESS_OP || op == LESS_EQ_OP
+		|| op == GREATER_OP || op == GREATER_EQ_OP
+		? typed(INT_OPD, BOOL_OPD, l, r,
+			REL_OPD_DIAG, REL_OPD_DIAG, BOOL_OPD, LOGIC_OPD_DIAG)
+	: op == EQUALS_OP || op == NOT_EQUALS_OP
+		? (l == ERROR_OPD || r == ERROR_OPD ? bad(none())
+			: l != r || !same ? bad(right(EQ_OPR_DIAG))
+			: isScalar(l) ? ok(BOOL_OPD)
+			: bad(left(EQ_OPD_DIAG)))
+	: op == NEG_OP
+		? (l == INT_OPD ? ok(INT_OPD) : bad(left(MATH_OPD_DIAG)))
+	: op == NOT_OP
+		? (l == BOOL_OPD ? ok(BOOL_OPD) : bad(left(LOGIC_OPD_DIAG)))
+	: bad(none());
+}
+
+}
+
+//Every operator rule, indexed by operator, operand classes
+// and whether the operand types are identical. A constexpr
+// instance is built at compile time, so checking an operator
+// is a single load.
+class OpRuleTable {
+public:
+	constexpr OpRuleTable() : myRules() {
+		for (size_t op = 0; op < OP_KIND_COUNT; op++){
+			for (size_t l = 0; l < OPD_CLASS_COUNT; l++){
+				for (size_t r = 0; r < OPD_CLASS_COUNT; r++){
+					for (size_t same = 0; same < 2; same++){
+						myRules[op][l][r][same] = op_rules::rule(
+							static_cast<OpKind>(op),
+							static_cast<OpdClass>(l),
+							static_cast<OpdClass>(r), same == 1);
+					}
+				}
+			}
+		}
+	}
+	constexpr const OpRule& get(OpKind op, OpdClass l, OpdClass r,
+		bool same) const {
+		return myRules[op][l][r][same ? 1 : 0];
+	}
+private:
+	OpRule myRules[OP_KIND_COUNT][OPD_CLASS_COUNT][OPD_CLASS_COUNT][2];
+};
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+// Times the dataflow analyses on one generated function with
+// tens of thousands of basic blocks: a long run of if-else
+// statements with && conditions and of while loops with ||
+// conditions, over a handful of locals, and then puts it in
+// SSA form and back. Parsing and checking are done once and
+// not timed.
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "scanner.hpp"
+#include "ast.hpp"
+#include "name_analysis.hpp"
+#include "type_analysis.hpp"
+#include "3ac.hpp"
+#include "cfg.hpp"
+#include "dataflow.hpp"
+
+static const size_t SECTIONS = 2500;
+static const size_t ROUNDS = 5;
+
+static std::string program(){
+	std::ostringstream src;
+	src << "int g;\n"
+	    << "void f(int a, int b){\n"
+	    << "\tint x;\n\tint y;\n\tint z;\n\tbool p;\n"
+	    << "\tx = a;\n\ty = b;\n\tz = 0;\n\tp = a < b;\n";
+	for (size_t s = 0; s < SECTIONS; s++){
+		src << "\tif (x < y && p){\n"
+		    << "\t\tx = x + y * " << (s % 7 + 1) << ";\n"
+		    << "\t} else {\n"
+		    << "\t\ty = y - x;\n\t\tg = a + b;\n"
+		    << "\t}\n"
+		    << "\twhile (y > x || !p){\n"
+		    << "\t\ty = y - 1;\n\t\tp = x == y;\n"
+		    << "\t}\n"
+		    << "\tz = a + b;\n";
+	}
+	src << "\tTOCONSOLE z;\n}\n";
+	return src.str();
+}
+
+template <typename F>
+static double time(F f){
+	auto start = std::chrono::steady_clock::now();
+	f();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void report(const char * name, double best, size_t universe,
+	size_t visits){
+	std::cout << name << ": best " << best << "ms (" << universe
+		<< " facts, " << visits << " block visits)\n";
+}
+
+int main(){
+	std::string source = program();
+	std::istringstream input(source);
+	holeyc::ProgramNode * root = nullptr;
+	{
+		holeyc::Scanner scanner(&input);
+		holeyc::Parser parser(scanner, &root);
+		if (parser.parse() != 0){ return 1; }
+	}
+	holeyc::NameAnalysis * na = holeyc::NameAnalysis::build(root);
+	if (na == nullptr){ return 1; }
+	holeyc::TypeAnalysis * ta = holeyc::TypeAnalysis::build(na);
+	if (ta == nullptr){ return 1; }
+	holeyc::IRProgram * prog = ta->ast->to3AC(ta);
+	const holeyc::Procedure * proc = prog->getProcs()[0].get();
+
+	double bestCFG = 0, bestLive = 0, bestReach = 0, bestAvail = 0;
+	double bestToSSA = 0, bestFromSSA = 0;
+	size_t blocks = 0, vars = 0, versions = 0;
+	size_t liveFacts = 0, reachFacts = 0, availFacts = 0;
+	size_t liveVisits = 0, reachVisits = 0, availVisits = 0;
+	for (size_t r = 0; r < ROUNDS; r++){
+		holeyc::CFG * cfg = nullptr;
+		double ms = time([&]{ cfg = new holeyc::CFG(proc); });
+		if (r == 0 || ms < bestCFG){ bestCFG = ms; }
+		holeyc::Variables variables(*cfg);
+		blocks = cfg->size();
+		vars = variables.size();
+
+		ms = time([&]{
+			holeyc::Liveness live(*cfg, variables);
+			liveFacts = live.universe();
+			liveVisits = live.visits();
+		});
+		if (r == 0 || ms < bestLive){ bestLive = ms; }
+		ms = time([&]{
+			holeyc::ReachingDefs reach(*cfg, variables);
+			reachFacts = reach.universe();
+			reachVisits = reach.visits();
+		});
+		if (r == 0 || ms < bestReach){ bestReach = ms; }
+		ms = time([&]{
+			holeyc::AvailableExprs avail(*cfg, variables);
+			availFacts = avail.universe();
+			availVisits = avail.visits();
+		});
+		if (r == 0 || ms < bestAvail){ bestAvail = ms; }
+		delete cfg;
+
+		//SSA rewrites the procedure, so each round needs a
+		// fresh copy
+		holeyc::IRProgram * fresh = ta->ast->to3AC(ta);
+		holeyc::Procedure * target = fresh->getProcs()[0].get();
+		ms = time([&]{ target->toSSA(); });
+		if (r == 0 || ms < bestToSSA){ bestToSSA = ms; }
+		versions = target->getVersions().size();
+		ms = time([&]{ target->fromSSA(); });
+		if (r == 0 || ms < bestFromSSA){ bestFromSSA = ms; }
+		delete fresh;
+	}
+
+	std::cout << proc->getQuads().size() << " quads in " << blocks
+		<< " blocks, " << vars << " tracked variables\n"
+		<< "CFG: best " << bestCFG << "ms\n";
+	report("Liveness", bestLive, liveFacts, liveVisits);
+	report("Reaching definitions", bestReach, reachFacts, reachVisits);
+	report("Available expressions", bestAvail, availFacts, availVisits);
+	std::cout << "Into SSA: best " << bestToSSA << "ms (" << versions
+		<< " versions)\n"
+		<< "Out of SSA: best " << bestFromSSA << "ms\n";
+	delete prog;
+	delete ta;
+	return 0;
+}
@@ -0,0 +1,133 @@
+// Checks that folding doesn't change what a program does: each
+// program is lowered with and without folding, both are run by
+// a small 3AC interpreter, and they must write the same values
+// (or both trap). Overflowing ints and divisions that trap are
+// the cases folding could get wrong.
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "scanner.hpp"
+#include "3ac.hpp"
+#include "ast.hpp"
+#include "name_analysis.hpp"
+#include "type_analysis.hpp"
+
+using namespace holeyc;
+
+//What running a program did: the values it wrote, then
+// "trap" if it trapped
+static std::string run(const Procedure * proc){
+	std::map<const Opd *, int64_t> vals;
+	auto value = [&](const Opd * opd) -> int64_t {
+		if (opd->isConst()){ return std::stoll(opd->toString()); }
+		return vals[opd];
+	};
+	std::map<const Label *, size_t> at;
+	const auto& quads = proc->getQuads();
+	for (size_t i = 0; i < quads.size(); i++){
+		if (quads[i]->getLabel() != nullptr){ at[quads[i]->getLabel()] = i; }
+	}
+	std::ostringstream out;
+	size_t pc = 0;
+	while (pc < quads.size()){
+		const Quad * quad = quads[pc++].get();
+		if (auto assign = dynamic_cast<const AssignQuad *>(quad)){
+			vals[assign->getDst()] = value(assign->getSrc());
+		} else if (auto bin = dynamic_cast<const BinOpQuad *>(quad)){
+			//Wrapping at 64 bits, as the target's registers do
+			uint64_t a = static_cast<uint64_t>(value(bin->getSrc1()));
+			uint64_t b = static_cast<uint64_t>(value(bin->getSrc2()));
+			int64_t sa = value(bin->getSrc1());
+			int64_t sb = value(bin->getSrc2());
+			int64_t res = 0;
+			switch (bin->getOp()){
+			case PLUS_OP: res = static_cast<int64_t>(a + b); break;
+			case MINUS_OP: res = static_cast<int64_t>(a - b); break;
+			case TIMES_OP: res = static_cast<int64_t>(a * b); break;
+			case DIVIDE_OP:
+				if (sb == 0 || (sb == -1 && sa == INT64_MIN)){
+					return out.str() + "trap\n";
+				}
+				res = sa / sb;
+				break;
+			case AND_OP: res = sa && sb; break;
+			case OR_OP: res = sa || sb; break;
+			case EQUALS_OP: res = sa == sb; break;
+			case NOT_EQUALS_OP: res = sa != sb; break;
+			case LESS_OP: res = sa < sb; break;
+			case LESS_EQ_OP: res = sa <= sb; break;
+			case GREATER_OP: res = sa > sb; break;
+			case GREATER_EQ_OP: res = sa >= sb; break;
+			default: return out.str() + "bad operator\n";
+			}
+			vals[bin->getDst()] = res;
+		} else if (auto un = dynamic_cast<const UnaryOpQuad *>(quad)){
+			int64_t src = value(un->getSrc());
+			vals[un->getDst()] = un->getOp() == NEG_OP
+				? static_cast<int64_t>(0 - static_cast<uint64_t>(src))
+				: !src;
+		} else if (auto write = dynamic_cast<const WriteQuad *>(quad)){
+			out << value(write->getSrc()) << "\n";
+		} else if (auto jmpIf = dynamic_cast<const JmpIfQuad *>(quad)){
+			if (value(jmpIf->getCnd()) == 0){ pc = at[jmpIf->getTarget()]; }
+		} else if (auto jmp = dynamic_cast<const JmpQuad *>(quad)){
+			pc = at[jmp->getTarget()];
+		}
+	}
+	return out.str();
+}
+
+//What main does, lowered with or without folding
+static std::string lowerAndRun(const std::string& source, bool fold){
+	std::istringstream input(source);
+	ProgramNode * root = nullptr;
+	{
+		Scanner scanner(&input);
+		Parser parser(scanner, &root);
+		if (parser.parse() != 0){ return "does not parse\n"; }
+	}
+	NameAnalysis * na = NameAnalysis::build(root);
+	if (na == nullptr){ return "fails name analysis\n"; }
+	TypeAnalysis * ta = TypeAnalysis::build(na);
+	if (ta == nullptr){ return "fails type analysis\n"; }
+	if (fold){ ta->ast->fold(ta); }
+	IRProgram * prog = ta->ast->to3AC(ta);
+	std::string res = run(prog->getProcs().back().get());
+	delete prog;
+	delete ta;
+	return res;
+}
+
+static int failures = 0;
+
+static void check(const std::string& body, const std::string& expected){
+	std::string source = "void main(){\n\tint x;\n\tx = 0;\n" + body + "}\n";
+	std::string plain = lowerAndRun(source, false);
+	std::string folded = lowerAndRun(source, true);
+	if (plain != expected || folded != expected){
+		std::cout << "FAIL:\n" << body << "unfolded:\n" << plain
+			<< "folded:\n" << folded << "expected:\n" << expected;
+		failures++;
+	}
+}
+
+int main(){
+	check("\tx = 2147483647;\n\tTOCONSOLE x + 1;\n"
+		"\tTOCONSOLE 2147483647 + 1;\n",
+		"2147483648\n2147483648\n");
+	check("\tTOCONSOLE 2147483647 * 2147483647 - 1;\n",
+		"4611686014132420608\n");
+	check("\tTOCONSOLE -(-2147483647 - 1);\n", "2147483648\n");
+	check("\tTOCONSOLE 7 / 2 * 0 + 14 / 7;\n", "2\n");
+	check("\tTOCONSOLE (7 != 14 / -(0)) || true;\n", "trap\n");
+	check("\tTOCONSOLE (14 / x) * 0;\n", "trap\n");
+	check("\tTOCONSOLE true && 14 / x == 1;\n", "trap\n");
+
+	if (failures != 0){ return 1; }
+	std::cout << "Folding keeps run-time behaviour\n";
+	return 0;
+}
@@ -0,0 +1,85 @@
+// Checks structural hashes: a function hashes the same
+// wherever it is in the file and however it is laid out,
+// changing a name, literal or operator changes its hash, and
+// a tree folded after it was hashed hashes like the folded
+// source would.
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "scanner.hpp"
+#include "ast.hpp"
+#include "name_analysis.hpp"
+#include "type_analysis.hpp"
+
+static holeyc::TypeAnalysis * check(const std::string& source){
+	std::istringstream input(source);
+	holeyc::ProgramNode * root = nullptr;
+	{
+		holeyc::Scanner scanner(&input);
+		holeyc::Parser parser(scanner, &root);
+		if (parser.parse() != 0){ return nullptr; }
+	}
+	holeyc::NameAnalysis * na = holeyc::NameAnalysis::build(root);
+	if (na == nullptr){ return nullptr; }
+	return holeyc::TypeAnalysis::build(na);
+}
+
+//The hash of the last declaration of source
+static uint64_t lastHash(const std::string& source, bool fold = false){
+	holeyc::TypeAnalysis * ta = check(source);
+	if (ta == nullptr){
+		std::cout << "FAIL: does not check:\n" << source;
+		exit(1);
+	}
+	uint64_t res = ta->ast->getGlobals()->back()->structHash();
+	if (fold){
+		//Hashed before folding, as a cache would have
+		ta->ast->fold(ta);
+		res = ta->ast->getGlobals()->back()->structHash();
+	}
+	delete ta;
+	return res;
+}
+
+static int failures = 0;
+
+static void expect(bool same, const char * what,
+	uint64_t a, uint64_t b){
+	if ((a == b) != same){
+		std::cout << "FAIL: " << what << "\n";
+		failures++;
+	}
+}
+
+int main(){
+	const std::string fn =
+		"int f(int a){ int b; b = a * 2; return b + 1; }\n";
+	uint64_t base = lastHash(fn);
+
+	expect(true, "moved down", base, lastHash("int x;\n\n\n" + fn));
+	expect(true, "laid out differently", base, lastHash(
+		"int f(int a){\n\tint b;\n\tb = a * 2; # doubled\n"
+		"\treturn b + 1;\n}\n"));
+	expect(false, "literal changed", base, lastHash(
+		"int f(int a){ int b; b = a * 3; return b + 1; }\n"));
+	expect(false, "operator changed", base, lastHash(
+		"int f(int a){ int b; b = a / 2; return b + 1; }\n"));
+	expect(false, "local renamed", base, lastHash(
+		"int f(int a){ int c; c = a * 2; return c + 1; }\n"));
+	expect(false, "function renamed", base, lastHash(
+		"int g(int a){ int b; b = a * 2; return b + 1; }\n"));
+
+	expect(true, "folded", lastHash(
+		"int f(int a){ int b; b = a * 2; return b + 3; }\n"), lastHash(
+		"int f(int a){ int b; b = a * (1 + 1); return b + (1 + 2); }\n",
+		true));
+	expect(true, "branch folded away", lastHash(
+		"void f(){ TOCONSOLE 1; }\n"), lastHash(
+		"void f(){ if (true){ TOCONSOLE 1; } }\n", true));
+
+	if (failures != 0){ return 1; }
+	std::cout << "Structural hashes OK\n";
+	return 0;
+}
@@ -0,0 +1,68 @@
+#!/bin/sh
+# Checks AST images: unparsing, checking and lowering an image
+# written with -b must give what they give for its source, -q
+# must refuse an image, and -p must reject an image that is
+# cut short or whose nodes are damaged.
+HOLEYCC=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+TESTS=$(pwd)
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+FAILED=0
+
+for SRC in "$TESTS"/*.holeyc; do
+	NAME=$(basename "$SRC" .holeyc)
+	#Only inputs that scan and parse cleanly are compared: an
+	# image does not keep the errors of its source
+	"$HOLEYCC" "$SRC" -b "$DIR/$NAME.ast" 2> "$DIR/src.out"
+	[ -s "$DIR/src.out" ] && continue
+	for MODE in u c a; do
+		: > "$DIR/src.out"
+		: > "$DIR/img.out"
+		if [ $MODE = c ]; then
+			"$HOLEYCC" "$SRC" -c 2> "$DIR/src.out"
+			SRC_EXIT=$?
+			"$HOLEYCC" "$DIR/$NAME.ast" -c 2> "$DIR/img.out"
+			IMG_EXIT=$?
+		else
+			"$HOLEYCC" "$SRC" -$MODE "$DIR/src.out" > /dev/null 2>&1
+			SRC_EXIT=$?
+			"$HOLEYCC" "$DIR/$NAME.ast" -$MODE "$DIR/img.out" \
+				> /dev/null 2>&1
+			IMG_EXIT=$?
+		fi
+		if [ $SRC_EXIT != $IMG_EXIT ] \
+			|| ! diff "$DIR/src.out" "$DIR/img.out" > /dev/null; then
+			echo "FAIL: -$MODE of $NAME differs for its image"
+			FAILED=1
+		fi
+	done
+done
+
+IMAGE="$DIR/lowering.ast"
+if ! "$HOLEYCC" "$IMAGE" -p; then
+	echo "FAIL: -p rejected a sound image"
+	FAILED=1
+fi
+SIZE=$(wc -c < "$IMAGE")
+#Shorter than the magic, a file is read as source
+for LEN in 8 20 36 $((SIZE / 2)) $((SIZE - 1)); do
+	head -c "$LEN" "$IMAGE" > "$DIR/cut.ast"
+	if "$HOLEYCC" "$DIR/cut.ast" -p > /dev/null 2>&1; then
+		echo "FAIL: image cut to $LEN bytes was accepted"
+		FAILED=1
+	fi
+done
+#Queries need the source text
+if "$HOLEYCC" "$IMAGE" -q diagnostics > /dev/null 2>&1; then
+	echo "FAIL: -q answered about an AST image"
+	FAILED=1
+fi
+#The header is intact, but the first node has no valid kind
+cp "$IMAGE" "$DIR/bad.ast"
+printf '\377' | dd of="$DIR/bad.ast" bs=1 seek=36 conv=notrunc 2> /dev/null
+if "$HOLEYCC" "$DIR/bad.ast" -p > /dev/null 2>&1; then
+	echo "FAIL: image with a damaged node was accepted by -p"
+	FAILED=1
+fi
+
+exit $FAILED
@@ -0,0 +1,55 @@
+#!/bin/sh
+# Checks --incremental -c across edits: each compilation must
+# report what a compilation without the sidecar reports, a
+# function must be checked again when a global it uses
+# changes type, and a function that only moved must have its
+# diagnostics replayed at its new lines.
+HOLEYCC=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR" || exit 1
+FAILED=0
+
+#Compile prog.holeyc incrementally, and check its diagnostics
+# against the expected ones and against a full compilation
+check(){
+	"$HOLEYCC" prog.holeyc --incremental -c 2> got.err
+	cp prog.holeyc plain.holeyc
+	"$HOLEYCC" plain.holeyc -c 2> plain.err
+	printf "$2" > expected.err
+	if ! diff got.err expected.err || ! diff got.err plain.err; then
+		echo "FAIL: $1"
+		FAILED=1
+	fi
+}
+
+printf 'int g;\nvoid f(){\n\tg = 1;\n}\nvoid h(){\n\tbool b;\n\tb = 3;\n}\n' \
+	> prog.holeyc
+check "first compilation" \
+	'FATAL [7,6]: Invalid assignment operation\nType Analysis Failed\n'
+if [ ! -s prog.holeyc.fncache ]; then
+	echo "FAIL: no sidecar written"
+	FAILED=1
+fi
+check "unchanged" \
+	'FATAL [7,6]: Invalid assignment operation\nType Analysis Failed\n'
+
+#f depends on g's type, h does not
+printf 'bool g;\nvoid f(){\n\tg = 1;\n}\nvoid h(){\n\tbool b;\n\tb = 3;\n}\n' \
+	> prog.holeyc
+check "global changed type" \
+	'FATAL [3,6]: Invalid assignment operation\nFATAL [7,6]: Invalid assignment operation\nType Analysis Failed\n'
+
+#h moves down three lines
+printf 'bool g;\nvoid f(){\n\tg = 1;\n}\n\n\n\nvoid h(){\n\tbool b;\n\tb = 3;\n}\n' \
+	> prog.holeyc
+check "function moved" \
+	'FATAL [3,6]: Invalid assignment operation\nFATAL [10,6]: Invalid assignment operation\nType Analysis Failed\n'
+
+#Fixing g fixes f; h keeps its error
+printf 'int g;\nvoid f(){\n\tg = 1;\n}\n\n\n\nvoid h(){\n\tbool b;\n\tb = 3;\n}\n' \
+	> prog.holeyc
+check "global changed back" \
+	'FATAL [10,6]: Invalid assignment operation\nType Analysis Failed\n'
+
+exit $FAILED
@@ -0,0 +1,58 @@
+#!/bin/sh
+# Checks symbol indexes: two test inputs are indexed and the
+# indexes merged, what --find answers from the merged index
+# must be index.find.expected, an AST image must index as its
+# source does, and an index cut short anywhere must be
+# rejected rather than read.
+HOLEYCC=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+TESTS=$(pwd)
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR" || exit 1
+FAILED=0
+
+#Index files are named as given, so index from here
+cp "$TESTS/query.holeyc" "$TESTS/shadowing.holeyc" .
+if ! "$HOLEYCC" query.holeyc -x query.index \
+	|| ! "$HOLEYCC" shadowing.holeyc -x shadowing.index \
+	|| ! "$HOLEYCC" --merge-index all.index query.index shadowing.index; then
+	echo "FAIL: could not build the indexes"
+	exit 1
+fi
+
+"$HOLEYCC" --find all.index g twice a f main > found.out
+if ! diff found.out "$TESTS/index.find.expected"; then
+	echo "FAIL: --find"
+	FAILED=1
+fi
+if "$HOLEYCC" --find all.index nothing > /dev/null; then
+	echo "FAIL: found a name that is not declared"
+	FAILED=1
+fi
+
+#Only the file the symbols are in may differ
+if ! "$HOLEYCC" shadowing.holeyc -b shadowing.ast \
+	|| ! "$HOLEYCC" shadowing.ast -x image.index; then
+	echo "FAIL: could not index an AST image"
+	FAILED=1
+fi
+"$HOLEYCC" --find shadowing.index a f g > source.out
+"$HOLEYCC" --find image.index a f g | sed 's/^shadowing.ast:/shadowing.holeyc:/' \
+	> image.out
+if ! diff source.out image.out; then
+	echo "FAIL: the index of an AST image differs from its source's"
+	FAILED=1
+fi
+
+SIZE=$(wc -c < all.index)
+for LEN in 0 8 40 $((SIZE / 2)) $((SIZE - 1)); do
+	head -c "$LEN" all.index > cut.index
+	if "$HOLEYCC" --find cut.index g > /dev/null 2>&1 \
+		|| "$HOLEYCC" --merge-index merged.index cut.index \
+		> /dev/null 2>&1; then
+		echo "FAIL: index cut to $LEN bytes was accepted"
+		FAILED=1
+	fi
+done
+
+exit $FAILED
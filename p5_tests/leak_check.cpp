@@ -0,0 +1,149 @@
+// Compiles the given inputs over and over in a single process
+// and fails if the resident set size keeps growing, i.e. if
+// any part of a compilation (tokens, AST, symbols, types) is
+// not reclaimed when the compilation is freed. Each round
+// also loads an AST image of an input with one byte of its
+// nodes damaged, so that loading mostly fails partway through
+// a node and must free what it had read, and compiles an
+// input whose analysis throws, which must free the analyses
+// and the tree on the way out.
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+
+#include "scanner.hpp"
+#include "ast.hpp"
+#include "name_analysis.hpp"
+#include "type_analysis.hpp"
+#include "serialize.hpp"
+
+static const size_t ROUNDS = 10000;
+static const size_t WARMUP = 1000;
+static const size_t SLACK_KB = 256;
+static const char * IMAGE_PATH = "leak_check.ast";
+//Type analysis of string literals is not written yet, so it
+// throws a ToDoError
+static const char * THROWING =
+	"int g;\nvoid main(){\n\tg = 1;\n\tTOCONSOLE \"g\";\n}\n";
+
+static size_t residentKB(){
+	std::ifstream statm("/proc/self/statm");
+	size_t pages = 0;
+	size_t resident = 0;
+	statm >> pages >> resident;
+	return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+static holeyc::ProgramNode * parse(const std::string& source){
+	std::istringstream input(source);
+	holeyc::ProgramNode * root = nullptr;
+	holeyc::Scanner scanner(&input);
+	holeyc::Parser parser(scanner, &root);
+	if (parser.parse() != 0){ return nullptr; }
+	return root;
+}
+
+//Compile the source through separate passes and through the
+// fused one, as main does for different -j
+static void compile(const std::string& source){
+	holeyc::ProgramNode * root = parse(source);
+	if (root == nullptr){ return; }
+	try {
+		holeyc::NameAnalysis * na = holeyc::NameAnalysis::build(root);
+		if (na == nullptr){ return; }
+		delete holeyc::TypeAnalysis::build(na);
+	} catch (holeyc::ToDoError * e){
+		delete e;
+	} catch (holeyc::InternalError * e){
+		delete e;
+	}
+
+	root = parse(source);
+	try {
+		delete holeyc::TypeAnalysis::buildFused(root);
+	} catch (holeyc::ToDoError * e){
+		delete e;
+	} catch (holeyc::InternalError * e){
+		delete e;
+	}
+}
+
+//Every image of the inputs that parse with one byte after
+// the header overwritten
+static std::vector<std::string> damagedImages(
+	const std::vector<std::string>& sources){
+	std::vector<std::string> images;
+	for (const std::string& source : sources){
+		holeyc::ProgramNode * root = parse(source);
+		if (root == nullptr){ continue; }
+		holeyc::ASTWriter writer;
+		root->serialize(&writer);
+		delete root;
+		writer.write(IMAGE_PATH);
+		std::ifstream in(IMAGE_PATH, std::ios::binary);
+		std::stringstream contents;
+		contents << in.rdbuf();
+		std::string image = contents.str();
+		size_t start = holeyc::ASTImage::HEADER_SIZE;
+		for (size_t i = start; i < image.size(); i++){
+			std::string damaged = image;
+			damaged[i] = '\xff';
+			images.push_back(damaged);
+		}
+	}
+	return images;
+}
+
+static void load(const std::string& image){
+	{
+		std::ofstream out(IMAGE_PATH, std::ios::binary);
+		out << image;
+	}
+	holeyc::ASTReader * reader = nullptr;
+	try {
+		reader = holeyc::ASTReader::open(IMAGE_PATH);
+		delete reader->program();
+	} catch (holeyc::InternalError * e){
+		delete e;
+	}
+	delete reader;
+}
+
+int main(int argc, char * argv[]){
+	std::vector<std::string> sources;
+	for (int i = 1; i < argc; i++){
+		std::ifstream in(argv[i]);
+		std::stringstream contents;
+		contents << in.rdbuf();
+		sources.push_back(contents.str());
+	}
+	if (sources.empty()){
+		std::cout << "usage: leak_check <file.holeyc>...\n";
+		return 1;
+	}
+	sources.push_back(THROWING);
+
+	std::vector<std::string> images = damagedImages(sources);
+
+	size_t baseline = 0;
+	for (size_t i = 0; i < ROUNDS; i++){
+		compile(sources[i % sources.size()]);
+		if (!images.empty()){ load(images[i % images.size()]); }
+		//Diagnostics are kept until they are flushed
+		holeyc::Report::flush();
+		if (i + 1 == WARMUP){ baseline = residentKB(); }
+	}
+	size_t final = residentKB();
+	std::remove(IMAGE_PATH);
+	std::cout << "RSS after " << WARMUP << " compiles: " 
+		<< baseline << "KB, after " << ROUNDS << ": " 
+		<< final << "KB\n";
+	if (final > baseline + SLACK_KB){
+		std::cout << "FAIL: memory grew across compilations\n";
+		return 1;
+	}
+	return 0;
+}
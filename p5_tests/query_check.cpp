@@ -0,0 +1,103 @@
+// Checks that the query engine reuses what an edit left
+// alone: after each edit the answers must be those of the new
+// text, and the number of queries computed again and reused
+// must be as expected.
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "query.hpp"
+
+static int failures = 0;
+static size_t computed = 0;
+static size_t reused = 0;
+
+//Check how many queries were computed and reused since the
+// last check
+static void expect(holeyc::QueryEngine& engine, const char * what,
+	size_t moreComputed, size_t moreReused){
+	size_t c = engine.computed() - computed;
+	size_t r = engine.reused() - reused;
+	computed = engine.computed();
+	reused = engine.reused();
+	if (c != moreComputed || r != moreReused){
+		std::cout << "FAIL: " << what << ": " << c << " computed, "
+			<< r << " reused, expected " << moreComputed
+			<< " computed, " << moreReused << " reused\n";
+		failures++;
+	}
+}
+
+//Check the lines the diagnostics of the whole file are at
+static void expectLines(holeyc::QueryEngine& engine, const char * what,
+	const std::vector<size_t>& lines){
+	std::vector<size_t> got;
+	for (const holeyc::Diagnostic& diag : engine.diagnostics().diags){
+		got.push_back(diag.line);
+	}
+	if (got != lines){
+		std::cout << "FAIL: " << what << ": wrong diagnostics\n";
+		failures++;
+	}
+	//Asked again at once, nothing is computed or verified
+	computed = engine.computed();
+	reused = engine.reused();
+}
+
+int main(){
+	const std::string head = "int g;\n\n";
+	const std::string twice = "int twice(int a){\n\treturn a * 2;\n}\n\n";
+	holeyc::QueryEngine engine;
+	std::vector<holeyc::Diagnostic> diags;
+	std::string failure;
+
+	engine.setText(head + twice
+		+ "void main(){\n\tint x;\n\tx = twice(g);\n}\n");
+	engine.fnDiagnostics("twice", diags, failure);
+	expect(engine, "first function", 17, 0);
+	engine.diagnostics();
+	expect(engine, "whole file", 11, 0);
+	expectLines(engine, "whole file", {});
+
+	//Setting the same text again changes nothing
+	engine.setText(head + twice
+		+ "void main(){\n\tint x;\n\tx = twice(g);\n}\n");
+	engine.diagnostics();
+	expect(engine, "same text", 0, 0);
+
+	//An edit to main leaves the analysis of twice in place
+	engine.setText(head + twice
+		+ "void main(){\n\tint x;\n\tx = true;\n}\n");
+	engine.fnDiagnostics("twice", diags, failure);
+	expect(engine, "main edited, twice", 10, 7);
+	engine.diagnostics();
+	expect(engine, "main edited, whole file", 5, 4);
+	expectLines(engine, "main edited", {9});
+
+	//Moving main down reuses its analysis, at its new lines
+	engine.setText(head + "\n\n" + twice
+		+ "void main(){\n\tint x;\n\tx = true;\n}\n");
+	engine.fnDiagnostics("twice", diags, failure);
+	expect(engine, "moved, twice", 8, 9);
+	engine.diagnostics();
+	expect(engine, "moved, whole file", 3, 6);
+	expectLines(engine, "moved", {11});
+
+	//Given in chunks, only the chunk that changed is scanned
+	// again
+	std::vector<std::string> chunks = {head + "\n\n", twice,
+		"void main(){\n\tint x;\n\tx = 1;\n}\n"};
+	engine.setText(chunks);
+	engine.diagnostics();
+	expect(engine, "split into chunks", 13, 15);
+	expectLines(engine, "split into chunks", {});
+	chunks[2] = "void main(){\n\tint x;\n\tx = false;\n}\n";
+	engine.setText(chunks);
+	engine.diagnostics();
+	expect(engine, "last chunk edited", 11, 17);
+	expectLines(engine, "last chunk edited", {11});
+
+	if (failures != 0){ return 1; }
+	std::cout << "Query reuse OK\n";
+	return 0;
+}
@@ -0,0 +1,94 @@
+// Times type analysis of a generated, expression-heavy 
+// program: many functions whose bodies are long chains of
+// arithmetic, relational and logical operators. Parsing and
+// name analysis are redone every round but not timed. Also
+// times the type queries an operator check makes on its 
+// operands, on their own.
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "scanner.hpp"
+#include "ast.hpp"
+#include "name_analysis.hpp"
+#include "type_analysis.hpp"
+
+static const size_t FUNCTIONS = 200;
+static const size_t STATEMENTS = 50;
+static const size_t ROUNDS = 20;
+
+static const size_t QUERIES = 20000000;
+
+//The shape of a binary operator check: test both operands
+// for errors, then for the operand type the operator needs
+static void queries(){
+	const holeyc::DataType * types[] = {
+		holeyc::BasicType::INT(), holeyc::BasicType::BOOL(),
+		holeyc::PtrType::produce(holeyc::BasicType::INT(), 1),
+		holeyc::ErrorType::produce(), holeyc::BasicType::CHAR(),
+	};
+	volatile size_t sink = 0;
+	auto start = std::chrono::steady_clock::now();
+	size_t hits = 0;
+	for (size_t i = 0; i < QUERIES; i++){
+		const holeyc::DataType * l = types[i % 5];
+		const holeyc::DataType * r = types[(i / 5) % 5];
+		if (l->asError() || r->asError()){ continue; }
+		if ((l->isInt() && r->isInt()) || (l->isBool() && r->isBool())
+		    || (l->isPtr() && r->validVarType())){
+			hits++;
+		}
+	}
+	sink = hits;
+	auto end = std::chrono::steady_clock::now();
+	double ms = std::chrono::duration<double, std::milli>(end - start).count();
+	std::cout << "Operand checks: " << QUERIES << " in " << ms 
+		<< "ms (" << sink << " matched)\n";
+}
+
+static std::string program(){
+	std::ostringstream src;
+	for (size_t f = 0; f < FUNCTIONS; f++){
+		src << "void f" << f << "(int a, int b, int c, bool p, bool q){\n"
+		    << "\tint x;\n\tbool y;\n";
+		for (size_t s = 0; s < STATEMENTS; s++){
+			src << "\tx = a + b * c - (a / " << (s + 1) << ") + -b * (c - a);\n"
+			    << "\ty = (a < b) && (b >= c) || !p && (x > a) || q;\n";
+		}
+		src << "}\n";
+	}
+	return src.str();
+}
+
+int main(){
+	std::string source = program();
+	double total = 0;
+	double best = 0;
+	for (size_t r = 0; r < ROUNDS; r++){
+		std::istringstream input(source);
+		holeyc::ProgramNode * root = nullptr;
+		{
+			holeyc::Scanner scanner(&input);
+			holeyc::Parser parser(scanner, &root);
+			if (parser.parse() != 0){ return 1; }
+		}
+		holeyc::NameAnalysis * na = holeyc::NameAnalysis::build(root);
+		if (na == nullptr){ return 1; }
+
+		auto start = std::chrono::steady_clock::now();
+		holeyc::TypeAnalysis * ta = holeyc::TypeAnalysis::build(na);
+		auto end = std::chrono::steady_clock::now();
+		if (ta == nullptr){ return 1; }
+		delete ta;
+
+		double ms = std::chrono::duration<double, std::milli>(end - start).count();
+		total += ms;
+		if (r == 0 || ms < best){ best = ms; }
+	}
+	std::cout << "Type analysis of " << FUNCTIONS * STATEMENTS * 2
+		<< " statements: best " << best << "ms, mean " 
+		<< total / ROUNDS << "ms over " << ROUNDS << " rounds\n";
+	queries();
+	return 0;
+}
@@ -0,0 +1,71 @@
+#ifndef HOLEYC_PARALLEL_HPP
+#define HOLEYC_PARALLEL_HPP
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace holeyc{
+
+//Work distribution for the passes that can process top-level
+// declarations independently. Each worker repeatedly claims 
+// the next unclaimed index, so uneven declarations still 
+// balance across threads.
+class Parallel{
+public:
+	//The number of worker threads passes may use (-j). One
+	// unless asked for more, so that a plain compilation takes
+	// the serial paths and starts no threads.
+	static unsigned jobs(){ return jobCount(); }
+	static void setJobs(unsigned jobs){ 
+		jobCount() = jobs == 0 ? 1 : jobs; 
+	}
+
+	//Call work(i) for every i in [0, count). Runs inline
+	// when only one worker would be used. If any call 
+	// throws, the remaining indices are abandoned and the 
+	// first exception is rethrown on the calling thread.
+	template <typename F>
+	static void forEach(size_t count, F work){
+		size_t workers = jobs();
+		if (workers > count){ workers = count; }
+		if (workers <= 1){
+			for (size_t i = 0; i < count; i++){ work(i); }
+			return;
+		}
+		std::atomic<size_t> next(0);
+		std::exception_ptr failure;
+		std::mutex failureLock;
+		auto worker = [&](){
+			try {
+				for (size_t i = next++; i < count; i = next++){
+					work(i);
+				}
+			} catch (...) {
+				next = count;
+				std::lock_guard<std::mutex> guard(failureLock);
+				if (!failure){ failure = std::current_exception(); }
+			}
+		};
+		std::vector<std::thread> threads;
+		for (size_t t = 1; t < workers; t++){
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (std::thread& thread : threads){
+			thread.join();
+		}
+		if (failure){ std::rethrow_exception(failure); }
+	}
+private:
+	static unsigned& jobCount(){
+		static unsigned count = 1;
+		return count;
+	}
+};
+
+}
+
+#endif
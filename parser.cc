@@ -329,7 +329,119 @@ namespace holeyc {
       YY_SYMBOL_PRINT (yymsg, yysym);
 
     // User destructor.
-    YYUSE (yysym.kind ());
+    switch (yysym.kind ())
+    {
+      case symbol_kind::S_globals: // globals
+#line 156 "holeyc.yy"
+                    { for (auto elt : *(yysym.value.transDeclList)){ delete elt; } delete (yysym.value.transDeclList); }
+#line 338 "parser.cc"
+        break;
+
+      case symbol_kind::S_decl: // decl
+#line 152 "holeyc.yy"
+                    { delete (yysym.value.transDecl); }
+#line 344 "parser.cc"
+        break;
+
+      case symbol_kind::S_varDecl: // varDecl
+#line 152 "holeyc.yy"
+                    { delete (yysym.value.transVarDecl); }
+#line 350 "parser.cc"
+        break;
+
+      case symbol_kind::S_type: // type
+#line 153 "holeyc.yy"
+                    { delete (yysym.value.transType); }
+#line 356 "parser.cc"
+        break;
+
+      case symbol_kind::S_fnDecl: // fnDecl
+#line 153 "holeyc.yy"
+                    { delete (yysym.value.transFn); }
+#line 362 "parser.cc"
+        break;
+
+      case symbol_kind::S_formals: // formals
+#line 157 "holeyc.yy"
+                    { for (auto elt : *(yysym.value.transFormals)){ delete elt; } delete (yysym.value.transFormals); }
+#line 368 "parser.cc"
+        break;
+
+      case symbol_kind::S_formalsList: // formalsList
+#line 157 "holeyc.yy"
+                    { for (auto elt : *(yysym.value.transFormals)){ delete elt; } delete (yysym.value.transFormals); }
+#line 374 "parser.cc"
+        break;
+
+      case symbol_kind::S_formalDecl: // formalDecl
+#line 152 "holeyc.yy"
+                    { delete (yysym.value.transFormal); }
+#line 380 "parser.cc"
+        break;
+
+      case symbol_kind::S_fnBody: // fnBody
+#line 158 "holeyc.yy"
+                    { for (auto elt : *(yysym.value.transStmts)){ delete elt; } delete (yysym.value.transStmts); }
+#line 386 "parser.cc"
+        break;
+
+      case symbol_kind::S_stmtList: // stmtList
+#line 158 "holeyc.yy"
+                    { for (auto elt : *(yysym.value.transStmts)){ delete elt; } delete (yysym.value.transStmts); }
+#line 392 "parser.cc"
+        break;
+
+      case symbol_kind::S_stmt: // stmt
+#line 154 "holeyc.yy"
+                    { delete (yysym.value.transStmt); }
+#line 398 "parser.cc"
+        break;
+
+      case symbol_kind::S_exp: // exp
+#line 154 "holeyc.yy"
+                    { delete (yysym.value.transExp); }
+#line 404 "parser.cc"
+        break;
+
+      case symbol_kind::S_assignExp: // assignExp
+#line 154 "holeyc.yy"
+                    { delete (yysym.value.transAssignExp); }
+#line 410 "parser.cc"
+        break;
+
+      case symbol_kind::S_callExp: // callExp
+#line 155 "holeyc.yy"
+                    { delete (yysym.value.transCallExp); }
+#line 416 "parser.cc"
+        break;
+
+      case symbol_kind::S_actualsList: // actualsList
+#line 159 "holeyc.yy"
+                    { for (auto elt : *(yysym.value.transActuals)){ delete elt; } delete (yysym.value.transActuals); }
+#line 422 "parser.cc"
+        break;
+
+      case symbol_kind::S_term: // term
+#line 154 "holeyc.yy"
+                    { delete (yysym.value.transExp); }
+#line 428 "parser.cc"
+        break;
+
+      case symbol_kind::S_lval: // lval
+#line 153 "holeyc.yy"
+                    { delete (yysym.value.transLVal); }
+#line 434 "parser.cc"
+        break;
+
+      case symbol_kind::S_id: // id
+#line 153 "holeyc.yy"
+                    { delete (yysym.value.transID); }
+#line 440 "parser.cc"
+        break;
+
+      default:
+        break;
+    }
   }
 
 #if YYDEBUG
@@ -583,553 +695,553 @@ namespace holeyc {
           switch (yyn)
             {
   case 2: // program: globals
-#line 163 "holeyc.yy"
+#line 176 "holeyc.yy"
                   {
 		  (yylhs.value.transProgram) = new ProgramNode((yystack_[0].value.transDeclList));
 		  *root = (yylhs.value.transProgram);
 		  }
-#line 592 "parser.cc"
+#line 704 "parser.cc"
     break;
 
   case 3: // globals: globals decl
-#line 169 "holeyc.yy"
+#line 182 "holeyc.yy"
                   { 
 	  	  (yylhs.value.transDeclList) = (yystack_[1].value.transDeclList); 
 	  	  DeclNode * declNode = (yystack_[0].value.transDecl);
 		  (yylhs.value.transDeclList)->push_back(declNode);
 	  	  }
-#line 602 "parser.cc"
+#line 714 "parser.cc"
     break;
 
   case 4: // globals: %empty
-#line 175 "holeyc.yy"
+#line 188 "holeyc.yy"
                   {
 		  (yylhs.value.transDeclList) = new std::list<DeclNode * >();
 		  }
-#line 610 "parser.cc"
+#line 722 "parser.cc"
     break;
 
   case 5: // decl: varDecl SEMICOLON
-#line 180 "holeyc.yy"
+#line 193 "holeyc.yy"
                   { (yylhs.value.transDecl) = (yystack_[1].value.transVarDecl); }
-#line 616 "parser.cc"
+#line 728 "parser.cc"
     break;
 
   case 6: // decl: fnDecl
-#line 182 "holeyc.yy"
+#line 195 "holeyc.yy"
                   { (yylhs.value.transDecl) = (yystack_[0].value.transFn); }
-#line 622 "parser.cc"
+#line 734 "parser.cc"
     break;
 
   case 7: // varDecl: type id
-#line 185 "holeyc.yy"
+#line 198 "holeyc.yy"
                   {
 		  size_t line = (yystack_[1].value.transType)->line();
 		  size_t col = (yystack_[1].value.transType)->col();
 		  (yylhs.value.transVarDecl) = new VarDeclNode(line, col, (yystack_[1].value.transType), (yystack_[0].value.transID));
 		  }
-#line 632 "parser.cc"
+#line 744 "parser.cc"
     break;
 
   case 8: // type: INT
-#line 192 "holeyc.yy"
+#line 205 "holeyc.yy"
                   { 
 		  (yylhs.value.transType) = new IntTypeNode((yystack_[0].value.transToken)->line(), (yystack_[0].value.transToken)->col(), false);
 		  }
-#line 640 "parser.cc"
+#line 752 "parser.cc"
     break;
 
   case 9: // type: INTPTR
-#line 196 "holeyc.yy"
+#line 209 "holeyc.yy"
                   { 
 		  (yylhs.value.transType) = new IntTypeNode((yystack_[0].value.transToken)->line(), (yystack_[0].value.transToken)->col(), true);
 		  }
-#line 648 "parser.cc"
+#line 760 "parser.cc"
     break;
 
   case 10: // type: BOOL
-#line 200 "holeyc.yy"
+#line 213 "holeyc.yy"
                   {
 		  (yylhs.value.transType) = new BoolTypeNode((yystack_[0].value.transToken)->line(), (yystack_[0].value.transToken)->col(), false);
 		  }
-#line 656 "parser.cc"
+#line 768 "parser.cc"
     break;
 
   case 11: // type: BOOLPTR
-#line 204 "holeyc.yy"
+#line 217 "holeyc.yy"
                   {
 		  (yylhs.value.transType) = new BoolTypeNode((yystack_[0].value.transToken)->line(), (yystack_[0].value.transToken)->col(), true);
 		  }
-#line 664 "parser.cc"
+#line 776 "parser.cc"
     break;
 
   case 12: // type: CHAR
-#line 208 "holeyc.yy"
+#line 221 "holeyc.yy"
                   {
 		  (yylhs.value.transType) = new CharTypeNode((yystack_[0].value.transToken)->line(), (yystack_[0].value.transToken)->col(), false);
 		  }
-#line 672 "parser.cc"
+#line 784 "parser.cc"
     break;
 
   case 13: // type: CHARPTR
-#line 212 "holeyc.yy"
+#line 225 "holeyc.yy"
                   {
 		  (yylhs.value.transType) = new CharTypeNode((yystack_[0].value.transToken)->line(), (yystack_[0].value.transToken)->col(), true);
 		  }
-#line 680 "parser.cc"
+#line 792 "parser.cc"
     break;
 
   case 14: // type: VOID
-#line 216 "holeyc.yy"
+#line 229 "holeyc.yy"
                   {
 		  (yylhs.value.transType) = new VoidTypeNode((yystack_[0].value.transToken)->line(), (yystack_[0].value.transToken)->col());
 		  }
-#line 688 "parser.cc"
+#line 800 "parser.cc"
     break;
 
   case 15: // fnDecl: type id formals fnBody
-#line 221 "holeyc.yy"
+#line 234 "holeyc.yy"
                   {
 		  (yylhs.value.transFn) = new FnDeclNode((yystack_[3].value.transType)->line(), (yystack_[3].value.transType)->col(), 
 		    (yystack_[3].value.transType), (yystack_[2].value.transID), (yystack_[1].value.transFormals), (yystack_[0].value.transStmts));
 		  }
-#line 697 "parser.cc"
+#line 809 "parser.cc"
     break;
 
   case 16: // formals: LPAREN RPAREN
-#line 227 "holeyc.yy"
+#line 240 "holeyc.yy"
                   {
 		  (yylhs.value.transFormals) = new std::list<FormalDeclNode *>();
 		  }
-#line 705 "parser.cc"
+#line 817 "parser.cc"
     break;
 
   case 17: // formals: LPAREN formalsList RPAREN
-#line 231 "holeyc.yy"
+#line 244 "holeyc.yy"
                   {
 		  (yylhs.value.transFormals) = (yystack_[1].value.transFormals);
 		  }
-#line 713 "parser.cc"
+#line 825 "parser.cc"
     break;
 
   case 18: // formalsList: formalDecl
-#line 237 "holeyc.yy"
+#line 250 "holeyc.yy"
                   {
 		  (yylhs.value.transFormals) = new std::list<FormalDeclNode *>();
 		  (yylhs.value.transFormals)->push_back((yystack_[0].value.transFormal));
 		  }
-#line 722 "parser.cc"
+#line 834 "parser.cc"
     break;
 
   case 19: // formalsList: formalDecl COMMA formalsList
-#line 242 "holeyc.yy"
+#line 255 "holeyc.yy"
                   {
 		  (yylhs.value.transFormals) = (yystack_[0].value.transFormals);
 		  (yylhs.value.transFormals)->push_front((yystack_[2].value.transFormal));
 		  }
-#line 731 "parser.cc"
+#line 843 "parser.cc"
     break;
 
   case 20: // formalDecl: type id
-#line 248 "holeyc.yy"
+#line 261 "holeyc.yy"
                   {
 		  (yylhs.value.transFormal) = new FormalDeclNode((yystack_[1].value.transType)->line(), (yystack_[1].value.transType)->col(), 
 		    (yystack_[1].value.transType), (yystack_[0].value.transID));
 		  }
-#line 740 "parser.cc"
+#line 852 "parser.cc"
     break;
 
   case 21: // fnBody: LCURLY stmtList RCURLY
-#line 254 "holeyc.yy"
+#line 267 "holeyc.yy"
                   {
 		  (yylhs.value.transStmts) = (yystack_[1].value.transStmts);
 		  }
-#line 748 "parser.cc"
+#line 860 "parser.cc"
     break;
 
   case 22: // stmtList: %empty
-#line 259 "holeyc.yy"
+#line 272 "holeyc.yy"
                   {
 		  (yylhs.value.transStmts) = new std::list<StmtNode *>();
 		  //$$->push_back($1);
 	   	  }
-#line 757 "parser.cc"
+#line 869 "parser.cc"
     break;
 
   case 23: // stmtList: stmtList stmt
-#line 264 "holeyc.yy"
+#line 277 "holeyc.yy"
                   {
 		  (yylhs.value.transStmts) = (yystack_[1].value.transStmts);
 		  (yylhs.value.transStmts)->push_back((yystack_[0].value.transStmt));
 	  	  }
-#line 766 "parser.cc"
+#line 878 "parser.cc"
     break;
 
   case 24: // stmt: varDecl SEMICOLON
-#line 270 "holeyc.yy"
+#line 283 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = (yystack_[1].value.transVarDecl);
 		  }
-#line 774 "parser.cc"
+#line 886 "parser.cc"
     break;
 
   case 25: // stmt: assignExp SEMICOLON
-#line 274 "holeyc.yy"
+#line 287 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = new AssignStmtNode((yystack_[1].value.transAssignExp)->line(), (yystack_[1].value.transAssignExp)->col(), (yystack_[1].value.transAssignExp)); 
 		  }
-#line 782 "parser.cc"
+#line 894 "parser.cc"
     break;
 
   case 26: // stmt: lval DASHDASH SEMICOLON
-#line 278 "holeyc.yy"
+#line 291 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = new PostDecStmtNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transLVal));
 		  }
-#line 790 "parser.cc"
+#line 902 "parser.cc"
     break;
 
   case 27: // stmt: lval CROSSCROSS SEMICOLON
-#line 282 "holeyc.yy"
+#line 295 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = new PostIncStmtNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transLVal));
 		  }
-#line 798 "parser.cc"
+#line 910 "parser.cc"
     break;
 
   case 28: // stmt: FROMCONSOLE lval SEMICOLON
-#line 286 "holeyc.yy"
+#line 299 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = new FromConsoleStmtNode((yystack_[2].value.transToken)->line(), (yystack_[2].value.transToken)->col(), (yystack_[1].value.transLVal));
 		  }
-#line 806 "parser.cc"
+#line 918 "parser.cc"
     break;
 
   case 29: // stmt: TOCONSOLE exp SEMICOLON
-#line 290 "holeyc.yy"
+#line 303 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = new ToConsoleStmtNode((yystack_[2].value.transToken)->line(), (yystack_[2].value.transToken)->col(), (yystack_[1].value.transExp));
 		  }
-#line 814 "parser.cc"
+#line 926 "parser.cc"
     break;
 
   case 30: // stmt: IF LPAREN exp RPAREN LCURLY stmtList RCURLY
-#line 294 "holeyc.yy"
+#line 307 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = new IfStmtNode((yystack_[6].value.transToken)->line(), (yystack_[6].value.transToken)->col(), (yystack_[4].value.transExp), (yystack_[1].value.transStmts));
 		  }
-#line 822 "parser.cc"
+#line 934 "parser.cc"
     break;
 
   case 31: // stmt: IF LPAREN exp RPAREN LCURLY stmtList RCURLY ELSE LCURLY stmtList RCURLY
-#line 298 "holeyc.yy"
+#line 311 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = new IfElseStmtNode((yystack_[10].value.transToken)->line(), (yystack_[10].value.transToken)->col(), (yystack_[8].value.transExp), 
 		    (yystack_[5].value.transStmts), (yystack_[1].value.transStmts));
 		  }
-#line 831 "parser.cc"
+#line 943 "parser.cc"
     break;
 
   case 32: // stmt: WHILE LPAREN exp RPAREN LCURLY stmtList RCURLY
-#line 303 "holeyc.yy"
+#line 316 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = new WhileStmtNode((yystack_[6].value.transToken)->line(), (yystack_[6].value.transToken)->col(), (yystack_[4].value.transExp), (yystack_[1].value.transStmts));
 		  }
-#line 839 "parser.cc"
+#line 951 "parser.cc"
     break;
 
   case 33: // stmt: RETURN exp SEMICOLON
-#line 307 "holeyc.yy"
+#line 320 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = new ReturnStmtNode((yystack_[2].value.transToken)->line(), (yystack_[2].value.transToken)->col(), (yystack_[1].value.transExp));
 		  }
-#line 847 "parser.cc"
+#line 959 "parser.cc"
     break;
 
   case 34: // stmt: RETURN SEMICOLON
-#line 311 "holeyc.yy"
+#line 324 "holeyc.yy"
                   {
 		  (yylhs.value.transStmt) = new ReturnStmtNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), nullptr);
 		  }
-#line 855 "parser.cc"
+#line 967 "parser.cc"
     break;
 
   case 35: // stmt: callExp SEMICOLON
-#line 315 "holeyc.yy"
+#line 328 "holeyc.yy"
                   { (yylhs.value.transStmt) = new CallStmtNode((yystack_[1].value.transCallExp)->line(), (yystack_[1].value.transCallExp)->col(), (yystack_[1].value.transCallExp)); }
-#line 861 "parser.cc"
+#line 973 "parser.cc"
     break;
 
   case 36: // exp: assignExp
-#line 318 "holeyc.yy"
+#line 331 "holeyc.yy"
                   { (yylhs.value.transExp) = (yystack_[0].value.transAssignExp); }
-#line 867 "parser.cc"
+#line 979 "parser.cc"
     break;
 
   case 37: // exp: exp DASH exp
-#line 320 "holeyc.yy"
+#line 333 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new MinusNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 875 "parser.cc"
+#line 987 "parser.cc"
     break;
 
   case 38: // exp: exp CROSS exp
-#line 324 "holeyc.yy"
+#line 337 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new PlusNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 883 "parser.cc"
+#line 995 "parser.cc"
     break;
 
   case 39: // exp: exp STAR exp
-#line 328 "holeyc.yy"
+#line 341 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new TimesNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 891 "parser.cc"
+#line 1003 "parser.cc"
     break;
 
   case 40: // exp: exp SLASH exp
-#line 332 "holeyc.yy"
+#line 345 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new DivideNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 899 "parser.cc"
+#line 1011 "parser.cc"
     break;
 
   case 41: // exp: exp AND exp
-#line 336 "holeyc.yy"
+#line 349 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new AndNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 907 "parser.cc"
+#line 1019 "parser.cc"
     break;
 
   case 42: // exp: exp OR exp
-#line 340 "holeyc.yy"
+#line 353 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new OrNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 915 "parser.cc"
+#line 1027 "parser.cc"
     break;
 
   case 43: // exp: exp EQUALS exp
-#line 344 "holeyc.yy"
+#line 357 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new EqualsNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 923 "parser.cc"
+#line 1035 "parser.cc"
     break;
 
   case 44: // exp: exp NOTEQUALS exp
-#line 348 "holeyc.yy"
+#line 361 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new NotEqualsNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 931 "parser.cc"
+#line 1043 "parser.cc"
     break;
 
   case 45: // exp: exp GREATER exp
-#line 352 "holeyc.yy"
+#line 365 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new GreaterNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 939 "parser.cc"
+#line 1051 "parser.cc"
     break;
 
   case 46: // exp: exp GREATEREQ exp
-#line 356 "holeyc.yy"
+#line 369 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new GreaterEqNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 947 "parser.cc"
+#line 1059 "parser.cc"
     break;
 
   case 47: // exp: exp LESS exp
-#line 360 "holeyc.yy"
+#line 373 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new LessNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 955 "parser.cc"
+#line 1067 "parser.cc"
     break;
 
   case 48: // exp: exp LESSEQ exp
-#line 364 "holeyc.yy"
+#line 377 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new LessEqNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transExp), (yystack_[0].value.transExp));
 		  }
-#line 963 "parser.cc"
+#line 1075 "parser.cc"
     break;
 
   case 49: // exp: NOT exp
-#line 368 "holeyc.yy"
+#line 381 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new NotNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[0].value.transExp));
 		  }
-#line 971 "parser.cc"
+#line 1083 "parser.cc"
     break;
 
   case 50: // exp: DASH term
-#line 372 "holeyc.yy"
+#line 385 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new NegNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[0].value.transExp));
 		  }
-#line 979 "parser.cc"
+#line 1091 "parser.cc"
     break;
 
   case 51: // exp: term
-#line 376 "holeyc.yy"
+#line 389 "holeyc.yy"
                   { (yylhs.value.transExp) = (yystack_[0].value.transExp); }
-#line 985 "parser.cc"
+#line 1097 "parser.cc"
     break;
 
   case 52: // assignExp: lval ASSIGN exp
-#line 379 "holeyc.yy"
+#line 392 "holeyc.yy"
                   {
 		  (yylhs.value.transAssignExp) = new AssignExpNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[2].value.transLVal), (yystack_[0].value.transExp));
 		  }
-#line 993 "parser.cc"
+#line 1105 "parser.cc"
     break;
 
   case 53: // callExp: id LPAREN RPAREN
-#line 384 "holeyc.yy"
+#line 397 "holeyc.yy"
                   {
 		  std::list<ExpNode *> * noargs =
 		    new std::list<ExpNode *>();
 		  (yylhs.value.transCallExp) = new CallExpNode((yystack_[2].value.transID)->line(), (yystack_[2].value.transID)->col(), (yystack_[2].value.transID), noargs);
 		  }
-#line 1003 "parser.cc"
+#line 1115 "parser.cc"
     break;
 
   case 54: // callExp: id LPAREN actualsList RPAREN
-#line 390 "holeyc.yy"
+#line 403 "holeyc.yy"
                   {
 		  (yylhs.value.transCallExp) = new CallExpNode((yystack_[3].value.transID)->line(), (yystack_[3].value.transID)->col(), (yystack_[3].value.transID), (yystack_[1].value.transActuals));
 		  }
-#line 1011 "parser.cc"
+#line 1123 "parser.cc"
     break;
 
   case 55: // actualsList: exp
-#line 395 "holeyc.yy"
+#line 408 "holeyc.yy"
                   {
 		  std::list<ExpNode *> * list =
 		    new std::list<ExpNode *>();
 		  list->push_back((yystack_[0].value.transExp));
 		  (yylhs.value.transActuals) = list;
 		  }
-#line 1022 "parser.cc"
+#line 1134 "parser.cc"
     break;
 
   case 56: // actualsList: actualsList COMMA exp
-#line 402 "holeyc.yy"
+#line 415 "holeyc.yy"
                   {
 		  (yylhs.value.transActuals) = (yystack_[2].value.transActuals);
 		  (yylhs.value.transActuals)->push_back((yystack_[0].value.transExp));
 		  }
-#line 1031 "parser.cc"
+#line 1143 "parser.cc"
     break;
 
   case 57: // term: lval
-#line 408 "holeyc.yy"
+#line 421 "holeyc.yy"
                   { (yylhs.value.transExp) = (yystack_[0].value.transLVal); }
-#line 1037 "parser.cc"
+#line 1149 "parser.cc"
     break;
 
   case 58: // term: callExp
-#line 410 "holeyc.yy"
+#line 423 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = (yystack_[0].value.transCallExp);
 		  }
-#line 1045 "parser.cc"
+#line 1157 "parser.cc"
     break;
 
   case 59: // term: NULLPTR
-#line 414 "holeyc.yy"
+#line 427 "holeyc.yy"
                   {
 		  (yylhs.value.transExp) = new NullPtrNode((yystack_[0].value.transToken)->line(), (yystack_[0].value.transToken)->col());
 		  }
-#line 1053 "parser.cc"
+#line 1165 "parser.cc"
     break;
 
   case 60: // term: INTLITERAL
-#line 418 "holeyc.yy"
+#line 431 "holeyc.yy"
                   { (yylhs.value.transExp) = new IntLitNode((yystack_[0].value.transIntToken)->line(), (yystack_[0].value.transIntToken)->col(), (yystack_[0].value.transIntToken)->num()); }
-#line 1059 "parser.cc"
+#line 1171 "parser.cc"
     break;
 
   case 61: // term: STRLITERAL
-#line 420 "holeyc.yy"
+#line 433 "holeyc.yy"
                   { (yylhs.value.transExp) = new StrLitNode((yystack_[0].value.transStrToken)->line(), (yystack_[0].value.transStrToken)->col(), (yystack_[0].value.transStrToken)->str()); }
-#line 1065 "parser.cc"
+#line 1177 "parser.cc"
     break;
 
   case 62: // term: CHARLIT
-#line 422 "holeyc.yy"
+#line 435 "holeyc.yy"
                   { (yylhs.value.transExp) = new CharLitNode((yystack_[0].value.transCharToken)->line(), (yystack_[0].value.transCharToken)->col(), (yystack_[0].value.transCharToken)->val()); }
-#line 1071 "parser.cc"
+#line 1183 "parser.cc"
     break;
 
   case 63: // term: TRUE
-#line 424 "holeyc.yy"
+#line 437 "holeyc.yy"
                   { (yylhs.value.transExp) = new TrueNode((yystack_[0].value.transToken)->line(), (yystack_[0].value.transToken)->col()); }
-#line 1077 "parser.cc"
+#line 1189 "parser.cc"
     break;
 
   case 64: // term: FALSE
-#line 426 "holeyc.yy"
+#line 439 "holeyc.yy"
                   { (yylhs.value.transExp) = new FalseNode((yystack_[0].value.transToken)->line(), (yystack_[0].value.transToken)->col()); }
-#line 1083 "parser.cc"
+#line 1195 "parser.cc"
     break;
 
   case 65: // term: LPAREN exp RPAREN
-#line 428 "holeyc.yy"
+#line 441 "holeyc.yy"
                   { (yylhs.value.transExp) = (yystack_[1].value.transExp); }
-#line 1089 "parser.cc"
+#line 1201 "parser.cc"
     break;
 
   case 66: // lval: id
-#line 431 "holeyc.yy"
+#line 444 "holeyc.yy"
                   {
 		  (yylhs.value.transLVal) = (yystack_[0].value.transID);
 		  }
-#line 1097 "parser.cc"
+#line 1209 "parser.cc"
     break;
 
   case 67: // lval: id LBRACE exp RBRACE
-#line 435 "holeyc.yy"
+#line 448 "holeyc.yy"
                   {
 		  (yylhs.value.transLVal) = new IndexNode((yystack_[3].value.transID)->line(), (yystack_[3].value.transID)->col(), (yystack_[3].value.transID), (yystack_[1].value.transExp));
 		  }
-#line 1105 "parser.cc"
+#line 1217 "parser.cc"
     break;
 
   case 68: // lval: AT id
-#line 439 "holeyc.yy"
+#line 452 "holeyc.yy"
                   {
 		  (yylhs.value.transLVal) = new DerefNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[0].value.transID));
 		  }
-#line 1113 "parser.cc"
+#line 1225 "parser.cc"
     break;
 
   case 69: // lval: CARAT id
-#line 443 "holeyc.yy"
+#line 456 "holeyc.yy"
                   {
 		  (yylhs.value.transLVal) = new RefNode((yystack_[1].value.transToken)->line(), (yystack_[1].value.transToken)->col(), (yystack_[0].value.transID));
 		  }
-#line 1121 "parser.cc"
+#line 1233 "parser.cc"
     break;
 
   case 70: // id: ID
-#line 448 "holeyc.yy"
+#line 461 "holeyc.yy"
                   {
 		  (yylhs.value.transID) = new IDNode((yystack_[0].value.transIDToken)->line(), (yystack_[0].value.transIDToken)->col(), (yystack_[0].value.transIDToken)->value()); 
 		  }
-#line 1129 "parser.cc"
+#line 1241 "parser.cc"
     break;
 
 
-#line 1133 "parser.cc"
+#line 1245 "parser.cc"
 
             default:
               break;
@@ -1806,12 +1918,12 @@ namespace holeyc {
 
 #line 5 "holeyc.yy"
 } // holeyc
-#line 1810 "parser.cc"
+#line 1922 "parser.cc"
 
-#line 452 "holeyc.yy"
+#line 465 "holeyc.yy"
 
 
 void holeyc::Parser::error(const std::string& msg){
 	std::cout << msg << std::endl;
-	std::cerr << "syntax error" << std::endl;
+	Report::fatal(DiagCode::SYNTAX_ERROR, "syntax error");
 }
@@ -0,0 +1,98 @@
+#include <sstream>
+
+#include "prelude.hpp"
+#include "scanner.hpp"
+#include "ast.hpp"
+#include "name_analysis.hpp"
+#include "type_analysis.hpp"
+
+namespace holeyc{
+
+static const char * const PRELUDE_SOURCE =
+	"int abs(int x){\n"
+	"	if (x < 0){\n"
+	"		return -x;\n"
+	"	}\n"
+	"	return x;\n"
+	"}\n"
+	"int min(int a, int b){\n"
+	"	if (a < b){\n"
+	"		return a;\n"
+	"	}\n"
+	"	return b;\n"
+	"}\n"
+	"int max(int a, int b){\n"
+	"	if (a > b){\n"
+	"		return a;\n"
+	"	}\n"
+	"	return b;\n"
+	"}\n"
+	"int clamp(int x, int lo, int hi){\n"
+	"	if (x < lo){\n"
+	"		return lo;\n"
+	"	}\n"
+	"	if (x > hi){\n"
+	"		return hi;\n"
+	"	}\n"
+	"	return x;\n"
+	"}\n"
+	"void newline(){\n"
+	"	TOCONSOLE '\\n;\n"
+	"}\n"
+	;
+
+const char * Prelude::source(){
+	return PRELUDE_SOURCE;
+}
+
+const PersistentScopeTable& Prelude::scope(){
+	return instance().globals;
+}
+
+FnDeclNode * Prelude::fnDecl(const SemSymbol * fn){
+	for (DeclNode * decl : *instance().analysis->ast->getGlobals()){
+		FnDeclNode * fnDecl = dynamic_cast<FnDeclNode *>(decl);
+		if (fnDecl != nullptr && fnDecl->ID()->getSymbol() == fn){
+			return fnDecl;
+		}
+	}
+	return nullptr;
+}
+
+TypeAnalysis * Prelude::types(){
+	return instance().analysis;
+}
+
+const Prelude& Prelude::instance(){
+	//Initialized exactly once, even if several threads 
+	// ask for it at the same time
+	static const Prelude prelude;
+	return prelude;
+}
+
+Prelude::Prelude(){
+	std::istringstream input(PRELUDE_SOURCE);
+	ProgramNode * root = nullptr;
+	{
+		Scanner scanner(&input);
+		Parser parser(scanner, &root);
+		if (parser.parse() != 0){
+			throw new InternalError("Prelude failed to parse");
+		}
+	}
+	NameAnalysis * nameAnalysis = NameAnalysis::build(root, false);
+	if (nameAnalysis == nullptr){
+		throw new InternalError("Prelude failed name analysis");
+	}
+	globals = nameAnalysis->globalScope();
+	analysis = TypeAnalysis::build(nameAnalysis);
+	if (analysis == nullptr){
+		throw new InternalError("Prelude failed type analysis");
+	}
+}
+
+Prelude::~Prelude(){
+	delete analysis;
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef HOLEYC_PRELUDE_HPP
+#define HOLEYC_PRELUDE_HPP
+
+#include "symbol_table.hpp"
+
+namespace holeyc{
+
+class FnDeclNode;
+class TypeAnalysis;
+
+//The standard library every program is compiled against. 
+// Its source is parsed and analysed once per process, the
+// first time any compilation needs it; its global scope is
+// then frozen and shared (by reference, never copied) as the
+// outermost scope of every compilation. Programs may shadow
+// prelude functions with their own globals.
+class Prelude{
+public:
+	//The frozen scope holding the prelude's functions
+	static const PersistentScopeTable& scope();
+	static const char * source();
+	//The declaration of a prelude function, or nullptr if fn
+	// is not one
+	static FnDeclNode * fnDecl(const SemSymbol * fn);
+	//The analysis the prelude's declarations were checked by
+	static TypeAnalysis * types();
+private:
+	Prelude();
+	~Prelude();
+	static const Prelude& instance();
+	//Owns the prelude's AST, symbols and function types,
+	// which live for the rest of the process
+	TypeAnalysis * analysis;
+	PersistentScopeTable globals;
+};
+
+}
+
+#endif
@@ -0,0 +1,1002 @@
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "ast.hpp"
+#include "hash.hpp"
+#include "prelude.hpp"
+#include "query.hpp"
+#include "scanner.hpp"
+#include "symbol_table.hpp"
+#include "type_analysis.hpp"
+
+namespace holeyc{
+
+static bool sameDiags(const std::vector<Diagnostic>& a,
+	const std::vector<Diagnostic>& b){
+	if (a.size() != b.size()){ return false; }
+	for (size_t i = 0; i < a.size(); i++){
+		if (a[i].severity != b[i].severity || a[i].code != b[i].code
+			|| a[i].located != b[i].located || a[i].line != b[i].line
+			|| a[i].col != b[i].col
+			|| std::strcmp(a[i].message(), b[i].message()) != 0){
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool anyFatal(const std::vector<Diagnostic>& diags){
+	for (const Diagnostic& diag : diags){
+		if (diag.severity == Diagnostic::FATAL){ return true; }
+	}
+	return false;
+}
+
+//Copy diags into out, moving them from lines counted from
+// a declaration's first line to lines of the file. Line 0
+// (no position, as -c reports it) stays where it is.
+static void place(const std::vector<Diagnostic>& diags, size_t firstLine,
+	std::vector<Diagnostic>& out){
+	for (Diagnostic diag : diags){
+		if (diag.located && diag.line != 0){ diag.line += firstLine - 1; }
+		out.push_back(diag);
+	}
+}
+
+//Run step with its diagnostics going to errs. An internal
+// error ends it, and is kept in failure as the status line
+// -c would write for it.
+template <typename Step>
+static void guarded(DiagBuffer& errs, std::string& failure, Step step){
+	DiagBuffer * prev = Report::redirect(&errs);
+	try {
+		step();
+	} catch (InternalError * e) {
+		failure = "InternalError: " + e->msg() + "\n";
+		delete e;
+	} catch (ToDoError * e) {
+		failure = std::string("ToDoError: ") + e->msg() + "\n";
+		delete e;
+	} catch (...) {
+		Report::redirect(prev);
+		throw;
+	}
+	Report::redirect(prev);
+}
+
+//Hands the parser tokens the engine has kept, rather than
+// scanning them from text
+class ReplayScanner : public Scanner{
+public:
+	ReplayScanner(const std::vector<Lexeme>& tokens)
+	: Scanner(&noInput()), myTokens(tokens){ }
+	using Scanner::yylex;
+	int yylex(Parser::semantic_type * const lval) override {
+		if (myNext >= myTokens.size()){
+			myNext = myTokens.size() + 1;
+			return TokenKind::END;
+		}
+		const Lexeme& lex = myTokens[myNext++];
+		switch (lex.kind){
+		case TokenKind::ID:
+			lval->transToken = new IDToken(lex.line, lex.col, lex.text);
+			break;
+		case TokenKind::STRLITERAL:
+			lval->transToken = new StrToken(lex.line, lex.col, lex.text);
+			break;
+		case TokenKind::INTLITERAL:
+			lval->transToken = new IntLitToken(lex.line, lex.col, lex.num);
+			break;
+		case TokenKind::CHARLIT:
+			lval->transToken = new CharLitToken(lex.line, lex.col,
+				static_cast<char>(lex.num));
+			break;
+		default:
+			lval->transToken = new Token(lex.line, lex.col, lex.kind);
+		}
+		return lex.kind;
+	}
+	//The index of the last token handed out, or the number
+	// of tokens if it was the end of the input
+	size_t last() const { return myNext == 0 ? 0 : myNext - 1; }
+private:
+	static std::istream& noInput(){
+		static std::istringstream none;
+		return none;
+	}
+	const std::vector<Lexeme>& myTokens;
+	size_t myNext = 0;
+};
+
+//The file's text, in runs of whole lines (the input)
+struct QueryEngine::TextMemo : Memo{
+	std::vector<std::string> chunks;
+	bool sameAs(const Memo& other) const override {
+		return chunks == static_cast<const TextMemo&>(other).chunks;
+	}
+};
+
+//The tokens of the file or of a run of its lines, and what
+// the scanner reported. A run's lines count from its own
+// first line.
+struct QueryEngine::TokensMemo : Memo{
+	std::vector<Lexeme> tokens;
+	std::vector<Diagnostic> diags;
+	bool sameAs(const Memo& other) const override {
+		auto& o = static_cast<const TokensMemo&>(other);
+		return tokens == o.tokens && sameDiags(diags, o.diags);
+	}
+};
+
+//Where each top-level declaration is. The tokens are cut
+// after each semicolon or closing brace outside of braces:
+// a declaration that parses ends there, and the parser
+// gives up on the first one that doesn't.
+struct QueryEngine::OutlineMemo : Memo{
+	struct Decl{
+		//The first name in it (for a declaration that
+		// parses, the name declared), and how many before
+		// it have the same
+		std::string name;
+		size_t nth;
+		//Its tokens, [first, end)
+		size_t first;
+		size_t end;
+		//The position of its first token
+		size_t line;
+		size_t col;
+		bool operator==(const Decl& o) const {
+			return name == o.name && nth == o.nth && first == o.first
+				&& end == o.end && line == o.line && col == o.col;
+		}
+	};
+	std::vector<Decl> decls;
+	//Each name's declarations, as indices into decls
+	std::unordered_map<std::string, std::vector<size_t>> byName;
+	//A hash of the names and counts alone, which only
+	// changes when declarations come or go
+	uint64_t names = 0;
+	bool sameAs(const Memo& other) const override {
+		return decls == static_cast<const OutlineMemo&>(other).decls;
+	}
+	//The index of the nth declaration of name, or
+	// decls.size() if there is none
+	size_t find(const std::string& name, size_t nth) const {
+		auto found = byName.find(name);
+		if (found == byName.end() || nth >= found->second.size()){
+			return decls.size();
+		}
+		return found->second[nth];
+	}
+};
+
+//Where a declaration comes among the others. Unlike its
+// position, this stays the same when lines are added above.
+struct QueryEngine::IndexMemo : Memo{
+	size_t index = 0;
+	bool sameAs(const Memo& other) const override {
+		return index == static_cast<const IndexMemo&>(other).index;
+	}
+};
+
+//A declaration's tokens, with lines counted from its first
+// line, so that they stay the same when it moves
+struct QueryEngine::DeclTokensMemo : Memo{
+	bool found = false;
+	std::vector<Lexeme> tokens;
+	bool sameAs(const Memo& other) const override {
+		auto& o = static_cast<const DeclTokensMemo&>(other);
+		return found == o.found && tokens == o.tokens;
+	}
+};
+
+//A declaration, parsed as a program of its own
+struct QueryEngine::DeclASTMemo : Memo{
+	~DeclASTMemo(){ delete ast; }
+	ProgramNode * ast = nullptr;
+	//Every node of the tree, children before parents
+	std::vector<ASTNode *> nodes;
+	//If it doesn't parse: the syntax error, and the index
+	// of the token the parser gave up at
+	std::vector<Diagnostic> syntax;
+	size_t stop = 0;
+	DeclNode * decl() const {
+		if (ast == nullptr || ast->getGlobals()->empty()){ return nullptr; }
+		return ast->getGlobals()->front();
+	}
+	bool sameAs(const Memo&) const override { return false; }
+};
+
+//The symbol a declaration would bind in the global scope,
+// if nothing before it has the name
+struct QueryEngine::SignatureMemo : Memo{
+	std::unique_ptr<SemSymbol> symbol;
+	//Where its name is, in the declaration's lines
+	size_t line = 0;
+	size_t col = 0;
+	bool sameAs(const Memo& other) const override {
+		auto& o = static_cast<const SignatureMemo&>(other);
+		if (symbol == nullptr || o.symbol == nullptr){
+			return symbol == nullptr && o.symbol == nullptr;
+		}
+		return symbol->getKind() == o.symbol->getKind()
+			&& symbol->getDataType() == o.symbol->getDataType()
+			&& line == o.line && col == o.col;
+	}
+};
+
+//The global scope: for each name, the first declaration
+// that binds it. Symbols are told apart by the declaration
+// they come from and the revision their signature last
+// changed at, rather than by address, which may be reused.
+struct QueryEngine::GlobalsMemo : Memo{
+	struct Global{
+		size_t nth;
+		size_t index;
+		size_t version;
+		SemSymbol * symbol;
+	};
+	std::unordered_map<std::string, Global> bound;
+	bool sameAs(const Memo& other) const override {
+		auto& o = static_cast<const GlobalsMemo&>(other);
+		if (bound.size() != o.bound.size()){ return false; }
+		for (const auto& global : bound){
+			auto found = o.bound.find(global.first);
+			if (found == o.bound.end()
+				|| found->second.nth != global.second.nth
+				|| found->second.index != global.second.index
+				|| found->second.version != global.second.version){
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+//What a global name means to a declaration: the symbol of
+// an earlier declaration, or nothing (leaving the prelude)
+struct QueryEngine::LookupMemo : Memo{
+	SemSymbol * symbol = nullptr;
+	size_t nth = 0;
+	size_t version = 0;
+	bool sameAs(const Memo& other) const override {
+		auto& o = static_cast<const LookupMemo&>(other);
+		if (symbol == nullptr || o.symbol == nullptr){
+			return symbol == nullptr && o.symbol == nullptr;
+		}
+		return nth == o.nth && version == o.version;
+	}
+};
+
+//The name and type analysis of a declaration
+struct QueryEngine::AnalysisMemo : Memo{
+	~AnalysisMemo(){
+		delete types;
+		delete symbols;
+	}
+	//The symbols of its own scopes; the globals it uses
+	// belong to other declarations' signatures
+	SymbolTable * symbols = nullptr;
+	//Only if its names are all bound
+	TypeAnalysis * types = nullptr;
+	bool namesOK = false;
+	std::vector<Diagnostic> nameDiags;
+	std::vector<Diagnostic> typeDiags;
+	//An internal error, and whether it ended name analysis
+	// (rather than type analysis)
+	std::string failure;
+	bool failedNames = false;
+	bool sameAs(const Memo&) const override { return false; }
+};
+
+//The symbol of the identifier at a position in a
+// declaration, and where it was declared
+struct QueryEngine::SymbolMemo : Memo{
+	SemSymbol * symbol = nullptr;
+	bool prelude = false;
+	std::string decl;
+	size_t nth = 0;
+	size_t line = 0;
+	size_t col = 0;
+	bool sameAs(const Memo&) const override { return false; }
+};
+
+//The type of the expression at a position in a declaration
+struct QueryEngine::TypeMemo : Memo{
+	const DataType * type = nullptr;
+	bool sameAs(const Memo& other) const override {
+		return type == static_cast<const TypeMemo&>(other).type;
+	}
+};
+
+//What analysing a declaration reported, with lines counted
+// from its first line
+struct QueryEngine::FnDiagsMemo : Memo{
+	bool isFn = false;
+	bool namesOK = false;
+	std::vector<Diagnostic> nameDiags;
+	std::vector<Diagnostic> typeDiags;
+	std::string failure;
+	bool failedNames = false;
+	bool sameAs(const Memo& other) const override {
+		auto& o = static_cast<const FnDiagsMemo&>(other);
+		return isFn == o.isFn && namesOK == o.namesOK
+			&& failure == o.failure && failedNames == o.failedNames
+			&& sameDiags(nameDiags, o.nameDiags)
+			&& sameDiags(typeDiags, o.typeDiags);
+	}
+};
+
+struct QueryEngine::DiagnosticsMemo : Memo{
+	ProgramDiagnostics result;
+	bool sameAs(const Memo&) const override { return false; }
+};
+
+size_t QueryEngine::KeyHash::operator()(const Key& key) const {
+	return static_cast<size_t>(Hasher(key.kind).add(key.decl).add(key.nth)
+		.add(key.name).add(key.line).add(key.col).done());
+}
+
+QueryEngine::QueryEngine(){ }
+
+QueryEngine::~QueryEngine(){ }
+
+QueryEngine::Key QueryEngine::key(Kind kind, const std::string& decl,
+	size_t nth){
+	return Key{kind, decl, nth, std::string(), 0, 0};
+}
+
+void QueryEngine::setText(const std::string& text){
+	setText(std::vector<std::string>(1, text));
+}
+
+void QueryEngine::setText(const std::vector<std::string>& chunks){
+	std::unique_ptr<Memo>& slot = myMemos[key(TEXT)];
+	if (slot != nullptr && static_cast<TextMemo&>(*slot).chunks == chunks){
+		return;
+	}
+	myRevision++;
+	std::unique_ptr<TextMemo> memo(new TextMemo());
+	memo->chunks = chunks;
+	memo->changedAt = myRevision;
+	memo->verifiedAt = myRevision;
+	slot = std::move(memo);
+
+	//The tokens of runs that are gone are dropped (a hash
+	// that matches by chance only keeps one a while longer)
+	std::unordered_set<uint64_t> kept;
+	for (const std::string& chunk : chunks){
+		kept.insert(Hasher().add(chunk).done());
+	}
+	for (auto memo = myMemos.begin(); memo != myMemos.end(); ){
+		if (memo->first.kind == CHUNK_TOKENS
+			&& kept.count(Hasher().add(memo->first.decl).done()) == 0){
+			memo = myMemos.erase(memo);
+		} else {
+			++memo;
+		}
+	}
+}
+
+QueryEngine::Memo * QueryEngine::get(const Key& key){
+	if (myActive.count(key) != 0){
+		throw new InternalError("Query depends on itself");
+	}
+	std::unique_ptr<Memo>& slot = myMemos[key];
+	if (slot == nullptr || !verify(*slot)){
+		recompute(key, slot);
+	}
+	if (!myFrames.empty()){ myFrames.back()->push_back(key); }
+	return slot.get();
+}
+
+bool QueryEngine::verify(Memo& memo){
+	if (memo.verifiedAt == myRevision){ return true; }
+	for (const Key& dep : memo.deps){
+		auto found = myMemos.find(dep);
+		if (found == myMemos.end() || found->second == nullptr){
+			return false;
+		}
+		if (!verify(*found->second)){
+			recompute(dep, found->second);
+		}
+		if (found->second->changedAt > memo.verifiedAt){ return false; }
+	}
+	memo.verifiedAt = myRevision;
+	myReused++;
+	return true;
+}
+
+void QueryEngine::recompute(const Key& key, std::unique_ptr<Memo>& slot){
+	std::vector<Key> deps;
+	myFrames.push_back(&deps);
+	myActive.insert(key);
+	std::unique_ptr<Memo> fresh;
+	try {
+		fresh = compute(key);
+	} catch (...) {
+		myFrames.pop_back();
+		myActive.erase(key);
+		throw;
+	}
+	myFrames.pop_back();
+	myActive.erase(key);
+	myComputed++;
+
+	//A query may ask the same thing many times (a name
+	// looked up throughout a body); once is enough
+	std::unordered_set<Key, KeyHash> seen;
+	std::vector<Key> unique;
+	for (Key& dep : deps){
+		if (seen.insert(dep).second){ unique.push_back(std::move(dep)); }
+	}
+
+	//An answer that came out the same keeps its revision,
+	// so whatever depends on it need not be redone (and
+	// the old answer is kept, so pointers into it hold)
+	if (slot != nullptr && slot->sameAs(*fresh)){
+		slot->deps = std::move(unique);
+		slot->verifiedAt = myRevision;
+		return;
+	}
+	fresh->deps = std::move(unique);
+	fresh->changedAt = myRevision;
+	fresh->verifiedAt = myRevision;
+	slot = std::move(fresh);
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::compute(const Key& key){
+	switch (key.kind){
+	case TEXT: return std::unique_ptr<Memo>(new TextMemo());
+	case CHUNK_TOKENS: return chunkTokensQuery(key);
+	case TOKENS: return tokensQuery();
+	case OUTLINE: return outlineQuery();
+	case INDEX: return indexQuery(key);
+	case DECL_TOKENS: return declTokensQuery(key);
+	case DECL_AST: return declASTQuery(key);
+	case SIGNATURE: return signatureQuery(key);
+	case GLOBALS: return globalsQuery();
+	case LOOKUP: return lookupQuery(key);
+	case ANALYSIS: return analysisQuery(key);
+	case SYMBOL: return symbolQuery(key);
+	case TYPE: return typeQuery(key);
+	case FN_DIAGS: return fnDiagsQuery(key);
+	case DIAGNOSTICS: return diagnosticsQuery();
+	}
+	throw new InternalError("Unknown query");
+}
+
+void QueryEngine::sweep(){
+	auto found = myMemos.find(key(OUTLINE));
+	if (found == myMemos.end() || found->second == nullptr
+		|| found->second->verifiedAt != myRevision){
+		return;
+	}
+	const OutlineMemo& outline = static_cast<OutlineMemo&>(*found->second);
+	if (outline.names == mySwept){ return; }
+	mySwept = outline.names;
+	//Whatever depended on a dropped answer finds it
+	// missing, and so is redone
+	for (auto memo = myMemos.begin(); memo != myMemos.end(); ){
+		const Key& at = memo->first;
+		bool aboutDecl = at.kind != TEXT && at.kind != CHUNK_TOKENS
+			&& at.kind != TOKENS && at.kind != OUTLINE && at.kind != GLOBALS
+			&& at.kind != DIAGNOSTICS;
+		if (aboutDecl && outline.find(at.decl, at.nth) == outline.decls.size()){
+			memo = myMemos.erase(memo);
+		} else {
+			++memo;
+		}
+	}
+}
+
+bool QueryEngine::locate(size_t& line, size_t col, Key& decl){
+	const OutlineMemo& outline = fetch<OutlineMemo>(key(OUTLINE));
+	auto after = std::upper_bound(outline.decls.begin(),
+		outline.decls.end(), std::make_pair(line, col),
+		[](const std::pair<size_t, size_t>& pos,
+			const OutlineMemo::Decl& d){
+			return pos.first < d.line
+				|| (pos.first == d.line && pos.second < d.col);
+		});
+	if (after == outline.decls.begin()){ return false; }
+	const OutlineMemo::Decl& at = *(after - 1);
+	decl = key(ANALYSIS, at.name, at.nth);
+	line = line - at.line + 1;
+	return true;
+}
+
+const std::vector<Lexeme>& QueryEngine::tokens(){
+	const std::vector<Lexeme>& res = fetch<TokensMemo>(key(TOKENS)).tokens;
+	sweep();
+	return res;
+}
+
+DeclNode * QueryEngine::declaration(const std::string& name, size_t nth){
+	DeclNode * res = fetch<DeclASTMemo>(key(DECL_AST, name, nth)).decl();
+	sweep();
+	return res;
+}
+
+bool QueryEngine::symbolAt(size_t line, size_t col, SymbolInfo& out){
+	Key at;
+	bool res = false;
+	if (locate(line, col, at)){
+		at.kind = SYMBOL;
+		at.line = line;
+		at.col = col;
+		const SymbolMemo& found = fetch<SymbolMemo>(at);
+		if (found.symbol != nullptr){
+			out.symbol = found.symbol;
+			out.line = 0;
+			out.col = 0;
+			if (!found.prelude){
+				const OutlineMemo& outline = fetch<OutlineMemo>(key(OUTLINE));
+				size_t index = outline.find(found.decl, found.nth);
+				out.line = outline.decls[index].line + found.line - 1;
+				out.col = found.col;
+			}
+			res = true;
+		}
+	}
+	sweep();
+	return res;
+}
+
+const DataType * QueryEngine::typeAt(size_t line, size_t col){
+	Key at;
+	const DataType * res = nullptr;
+	if (locate(line, col, at)){
+		at.kind = TYPE;
+		at.line = line;
+		at.col = col;
+		res = fetch<TypeMemo>(at).type;
+	}
+	sweep();
+	return res;
+}
+
+bool QueryEngine::fnDiagnostics(const std::string& name,
+	std::vector<Diagnostic>& out, std::string& failure){
+	const OutlineMemo& outline = fetch<OutlineMemo>(key(OUTLINE));
+	auto found = outline.byName.find(name);
+	bool res = false;
+	if (found != outline.byName.end()){
+		for (size_t index : found->second){
+			const OutlineMemo::Decl& decl = outline.decls[index];
+			const FnDiagsMemo& fn = fetch<FnDiagsMemo>(
+				key(FN_DIAGS, decl.name, decl.nth));
+			if (!fn.isFn){ continue; }
+			place(fn.nameDiags, decl.line, out);
+			place(fn.typeDiags, decl.line, out);
+			failure = fn.failure;
+			res = true;
+			break;
+		}
+	}
+	sweep();
+	return res;
+}
+
+const ProgramDiagnostics& QueryEngine::diagnostics(){
+	const ProgramDiagnostics& res =
+		fetch<DiagnosticsMemo>(key(DIAGNOSTICS)).result;
+	sweep();
+	return res;
+}
+
+std::vector<SymbolInfo> QueryEngine::globals(){
+	const OutlineMemo& outline = fetch<OutlineMemo>(key(OUTLINE));
+	const GlobalsMemo& globals = fetch<GlobalsMemo>(key(GLOBALS));
+	std::vector<SymbolInfo> res;
+	for (size_t i = 0; i < outline.decls.size(); i++){
+		const OutlineMemo::Decl& decl = outline.decls[i];
+		auto found = globals.bound.find(decl.name);
+		if (found == globals.bound.end() || found->second.index != i){
+			continue;
+		}
+		const SignatureMemo& sig = fetch<SignatureMemo>(
+			key(SIGNATURE, decl.name, decl.nth));
+		res.push_back(SymbolInfo{sig.symbol.get(),
+			decl.line + sig.line - 1, sig.col});
+	}
+	sweep();
+	return res;
+}
+
+static Lexeme lexeme(int kind, const Token * token){
+	Lexeme res{kind, token->line(), token->col(), std::string(), 0};
+	switch (kind){
+	case TokenKind::ID:
+		res.text = static_cast<const IDToken *>(token)->value();
+		break;
+	case TokenKind::STRLITERAL:
+		res.text = static_cast<const StrToken *>(token)->str();
+		break;
+	case TokenKind::INTLITERAL:
+		res.num = static_cast<const IntLitToken *>(token)->num();
+		break;
+	case TokenKind::CHARLIT:
+		res.num = static_cast<const CharLitToken *>(token)->val();
+		break;
+	}
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::chunkTokensQuery(
+	const Key& at){
+	std::unique_ptr<TokensMemo> res(new TokensMemo());
+	std::istringstream input(at.decl);
+	DiagBuffer errs;
+	DiagBuffer * prev = Report::redirect(&errs);
+	try {
+		Scanner scanner(&input);
+		Parser::semantic_type lval;
+		int kind;
+		while ((kind = scanner.yylex(&lval)) != TokenKind::END){
+			res->tokens.push_back(lexeme(kind, lval.transToken));
+		}
+	} catch (...) {
+		Report::redirect(prev);
+		throw;
+	}
+	Report::redirect(prev);
+	res->diags = errs.diagnostics();
+	return res;
+}
+
+//The runs of lines are scanned separately, and their tokens
+// put back at the lines of the file
+std::unique_ptr<QueryEngine::Memo> QueryEngine::tokensQuery(){
+	const std::vector<std::string>& chunks =
+		fetch<TextMemo>(key(TEXT)).chunks;
+	std::unique_ptr<TokensMemo> res(new TokensMemo());
+	size_t lines = 0;
+	for (const std::string& chunk : chunks){
+		const TokensMemo& lexed = fetch<TokensMemo>(key(CHUNK_TOKENS, chunk));
+		for (Lexeme lex : lexed.tokens){
+			lex.line += lines;
+			res->tokens.push_back(std::move(lex));
+		}
+		for (Diagnostic diag : lexed.diags){
+			if (diag.line != 0){ diag.line += lines; }
+			res->diags.push_back(std::move(diag));
+		}
+		lines += static_cast<size_t>(
+			std::count(chunk.begin(), chunk.end(), '\n'));
+	}
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::outlineQuery(){
+	const std::vector<Lexeme>& tokens = fetch<TokensMemo>(key(TOKENS)).tokens;
+	std::unique_ptr<OutlineMemo> res(new OutlineMemo());
+	size_t depth = 0;
+	size_t first = 0;
+	Hasher names;
+	for (size_t i = 0; i < tokens.size(); i++){
+		int kind = tokens[i].kind;
+		if (kind == TokenKind::LCURLY){ depth++; }
+		if (kind == TokenKind::RCURLY && depth > 0){ depth--; }
+		bool ends = depth == 0 && (kind == TokenKind::SEMICOLON
+			|| kind == TokenKind::RCURLY);
+		if (!ends && i + 1 < tokens.size()){ continue; }
+
+		std::string name;
+		for (size_t j = first; j <= i; j++){
+			if (tokens[j].kind == TokenKind::ID){
+				name = tokens[j].text;
+				break;
+			}
+		}
+		std::vector<size_t>& same = res->byName[name];
+		res->decls.push_back(OutlineMemo::Decl{name, same.size(),
+			first, i + 1, tokens[first].line, tokens[first].col});
+		names.add(name).add(same.size());
+		same.push_back(res->decls.size() - 1);
+		first = i + 1;
+	}
+	res->names = names.done();
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::indexQuery(const Key& at){
+	const OutlineMemo& outline = fetch<OutlineMemo>(key(OUTLINE));
+	std::unique_ptr<IndexMemo> res(new IndexMemo());
+	res->index = outline.find(at.decl, at.nth);
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::declTokensQuery(
+	const Key& at){
+	const OutlineMemo& outline = fetch<OutlineMemo>(key(OUTLINE));
+	std::unique_ptr<DeclTokensMemo> res(new DeclTokensMemo());
+	size_t index = outline.find(at.decl, at.nth);
+	if (index == outline.decls.size()){ return res; }
+	const OutlineMemo::Decl& decl = outline.decls[index];
+	const std::vector<Lexeme>& tokens = fetch<TokensMemo>(key(TOKENS)).tokens;
+	res->found = true;
+	res->tokens.assign(tokens.begin() + static_cast<std::ptrdiff_t>(decl.first),
+		tokens.begin() + static_cast<std::ptrdiff_t>(decl.end));
+	for (Lexeme& lex : res->tokens){
+		lex.line = lex.line - decl.line + 1;
+	}
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::declASTQuery(const Key& at){
+	const DeclTokensMemo& tokens = fetch<DeclTokensMemo>(
+		key(DECL_TOKENS, at.decl, at.nth));
+	std::unique_ptr<DeclASTMemo> res(new DeclASTMemo());
+	if (!tokens.found){ return res; }
+
+	//The parser writes syntax errors to std::cout as well
+	// as to Report
+	DiagBuffer errs;
+	DiagBuffer * prevErrs = Report::redirect(&errs);
+	std::ostringstream discard;
+	std::streambuf * prevOut = std::cout.rdbuf(discard.rdbuf());
+	ProgramNode * root = nullptr;
+	try {
+		ReplayScanner scanner(tokens.tokens);
+		NodeLog log;
+		Parser parser(scanner, &root);
+		if (parser.parse() == 0){
+			res->ast = root;
+			res->nodes = log.nodes();
+		} else {
+			delete root;
+			res->stop = scanner.last();
+		}
+	} catch (...) {
+		std::cout.rdbuf(prevOut);
+		Report::redirect(prevErrs);
+		throw;
+	}
+	std::cout.rdbuf(prevOut);
+	Report::redirect(prevErrs);
+	res->syntax = errs.diagnostics();
+	return res;
+}
+
+SemSymbol * QueryEngine::signature(DeclNode * decl){
+	const std::string& name = decl->ID()->getName();
+	if (auto var = dynamic_cast<VarDeclNode *>(decl)){
+		DataType * type = var->getTypeNode()->getType();
+		if (type->validVarType()){
+			return new VarSymbol(name, type);
+		}
+	} else if (auto fn = dynamic_cast<FnDeclNode *>(decl)){
+		std::vector<const DataType *> formalTypes;
+		for (FormalDeclNode * formal : *fn->getFormals()){
+			formalTypes.push_back(formal->getTypeNode()->getType());
+		}
+		return new FnSymbol(name, FnType::produce(formalTypes,
+			fn->getRetTypeNode()->getType()));
+	}
+	return nullptr;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::signatureQuery(const Key& at){
+	DeclNode * decl = fetch<DeclASTMemo>(key(DECL_AST, at.decl, at.nth)).decl();
+	std::unique_ptr<SignatureMemo> res(new SignatureMemo());
+	if (decl == nullptr){ return res; }
+	res->symbol.reset(signature(decl));
+	res->line = decl->ID()->line();
+	res->col = decl->ID()->col();
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::globalsQuery(){
+	const OutlineMemo& outline = fetch<OutlineMemo>(key(OUTLINE));
+	std::unique_ptr<GlobalsMemo> res(new GlobalsMemo());
+	for (size_t i = 0; i < outline.decls.size(); i++){
+		const OutlineMemo::Decl& decl = outline.decls[i];
+		SignatureMemo& sig = fetch<SignatureMemo>(
+			key(SIGNATURE, decl.name, decl.nth));
+		if (sig.symbol == nullptr){ continue; }
+		//A later declaration of the name clashes with this one
+		res->bound.emplace(decl.name, GlobalsMemo::Global{decl.nth, i,
+			sig.changedAt, sig.symbol.get()});
+	}
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::lookupQuery(const Key& at){
+	const GlobalsMemo& globals = fetch<GlobalsMemo>(key(GLOBALS));
+	size_t from = fetch<IndexMemo>(key(INDEX, at.decl, at.nth)).index;
+	std::unique_ptr<LookupMemo> res(new LookupMemo());
+	auto found = globals.bound.find(at.name);
+	if (found != globals.bound.end() && found->second.index < from){
+		res->symbol = found->second.symbol;
+		res->nth = found->second.nth;
+		res->version = found->second.version;
+	}
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::analysisQuery(const Key& at){
+	const DeclASTMemo& parsed = fetch<DeclASTMemo>(
+		key(DECL_AST, at.decl, at.nth));
+	std::unique_ptr<AnalysisMemo> res(new AnalysisMemo());
+	DeclNode * decl = parsed.decl();
+	if (decl == nullptr){ return res; }
+
+	//The declaration gets a scope of its own, in which the
+	// globals before it are found through lookup queries,
+	// so that it only depends on the names it uses
+	std::string declName = at.decl;
+	size_t nth = at.nth;
+	res->symbols = new SymbolTable(Prelude::scope().enterScope());
+	res->symbols->resolveGlobals([this, declName, nth](
+		const std::string& name){
+		Key lookup = key(LOOKUP, declName, nth);
+		lookup.name = name;
+		return fetch<LookupMemo>(lookup).symbol;
+	});
+	res->symbols->enterScope();
+
+	DiagBuffer nameErrs;
+	guarded(nameErrs, res->failure, [&](){
+		bool declOK = decl->nameAnalysisDecl(res->symbols);
+		bool bodyOK = decl->nameAnalysisBody(res->symbols);
+		res->namesOK = declOK && bodyOK;
+	});
+	res->nameDiags = nameErrs.diagnostics();
+	if (!res->failure.empty()){
+		res->failedNames = true;
+		res->namesOK = false;
+	}
+	if (!res->namesOK){ return res; }
+
+	res->types = TypeAnalysis::blank(parsed.ast);
+	DiagBuffer typeErrs;
+	guarded(typeErrs, res->failure, [&](){
+		decl->typeAnalysis(res->types);
+	});
+	res->typeDiags = typeErrs.diagnostics();
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::symbolQuery(const Key& at){
+	const AnalysisMemo& analysis = fetch<AnalysisMemo>(
+		key(ANALYSIS, at.decl, at.nth));
+	const DeclASTMemo& parsed = fetch<DeclASTMemo>(
+		key(DECL_AST, at.decl, at.nth));
+	std::unique_ptr<SymbolMemo> res(new SymbolMemo());
+	if (analysis.symbols == nullptr){ return res; }
+
+	SemSymbol * symbol = nullptr;
+	for (ASTNode * node : parsed.nodes){
+		IDNode * id = dynamic_cast<IDNode *>(node);
+		if (id != nullptr && id->line() == at.line && id->col() <= at.col
+			&& at.col < id->col() + id->getName().size()){
+			symbol = id->getSymbol();
+			break;
+		}
+	}
+	if (symbol == nullptr){ return res; }
+	res->symbol = symbol;
+
+	//Declared in this declaration (its own name, a formal
+	// or a local)...
+	for (ASTNode * node : parsed.nodes){
+		DeclNode * decl = dynamic_cast<DeclNode *>(node);
+		if (decl != nullptr && decl->ID()->getSymbol() == symbol){
+			res->decl = at.decl;
+			res->nth = at.nth;
+			res->line = decl->ID()->line();
+			res->col = decl->ID()->col();
+			return res;
+		}
+	}
+	//...or by an earlier one, or else by the prelude
+	const GlobalsMemo& globals = fetch<GlobalsMemo>(key(GLOBALS));
+	auto found = globals.bound.find(symbol->getName());
+	if (found == globals.bound.end() || found->second.symbol != symbol){
+		res->prelude = true;
+		return res;
+	}
+	const SignatureMemo& sig = fetch<SignatureMemo>(
+		key(SIGNATURE, symbol->getName(), found->second.nth));
+	res->decl = symbol->getName();
+	res->nth = found->second.nth;
+	res->line = sig.line;
+	res->col = sig.col;
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::typeQuery(const Key& at){
+	const AnalysisMemo& analysis = fetch<AnalysisMemo>(
+		key(ANALYSIS, at.decl, at.nth));
+	const DeclASTMemo& parsed = fetch<DeclASTMemo>(
+		key(DECL_AST, at.decl, at.nth));
+	std::unique_ptr<TypeMemo> res(new TypeMemo());
+	if (analysis.types == nullptr){ return res; }
+	//Children come first, so this finds the innermost
+	for (ASTNode * node : parsed.nodes){
+		ExpNode * exp = dynamic_cast<ExpNode *>(node);
+		if (exp == nullptr || exp->line() != at.line || exp->col() != at.col){
+			continue;
+		}
+		res->type = analysis.types->findType(exp);
+		if (res->type != nullptr){ break; }
+	}
+	return res;
+}
+
+std::unique_ptr<QueryEngine::Memo> QueryEngine::fnDiagsQuery(const Key& at){
+	const AnalysisMemo& analysis = fetch<AnalysisMemo>(
+		key(ANALYSIS, at.decl, at.nth));
+	DeclNode * decl = fetch<DeclASTMemo>(key(DECL_AST, at.decl, at.nth)).decl();
+	std::unique_ptr<FnDiagsMemo> res(new FnDiagsMemo());
+	res->isFn = dynamic_cast<FnDeclNode *>(decl) != nullptr;
+	res->namesOK = analysis.namesOK;
+	res->nameDiags = analysis.nameDiags;
+	res->typeDiags = analysis.typeDiags;
+	res->failure = analysis.failure;
+	res->failedNames = analysis.failedNames;
+	return res;
+}
+
+//Put together what -c would report: the scanner's
+// diagnostics, then either the first syntax error or the
+// name errors, and the type errors only if there were none
+// of those. As in the fused pass, type checking stops at
+// the first declaration that fails internally.
+std::unique_ptr<QueryEngine::Memo> QueryEngine::diagnosticsQuery(){
+	const TokensMemo& lexed = fetch<TokensMemo>(key(TOKENS));
+	const OutlineMemo& outline = fetch<OutlineMemo>(key(OUTLINE));
+	std::unique_ptr<DiagnosticsMemo> res(new DiagnosticsMemo());
+	ProgramDiagnostics& out = res->result;
+	out.passed = false;
+
+	for (const OutlineMemo::Decl& decl : outline.decls){
+		const DeclASTMemo& parsed = fetch<DeclASTMemo>(
+			key(DECL_AST, decl.name, decl.nth));
+		if (parsed.ast != nullptr){ continue; }
+		//The parser only got as far as the token it gave
+		// up at, and so did the scanner
+		size_t stop = decl.first + parsed.stop;
+		for (const Diagnostic& diag : lexed.diags){
+			if (stop < decl.end && (diag.line > lexed.tokens[stop].line
+				|| (diag.line == lexed.tokens[stop].line
+				&& diag.col > lexed.tokens[stop].col))){
+				break;
+			}
+			out.diags.push_back(diag);
+		}
+		out.diags.insert(out.diags.end(), parsed.syntax.begin(),
+			parsed.syntax.end());
+		return res;
+	}
+	out.diags = lexed.diags;
+
+	bool namesOK = true;
+	bool typesOK = true;
+	std::vector<Diagnostic> typeDiags;
+	for (const OutlineMemo::Decl& decl : outline.decls){
+		const FnDiagsMemo& fn = fetch<FnDiagsMemo>(
+			key(FN_DIAGS, decl.name, decl.nth));
+		place(fn.nameDiags, decl.line, out.diags);
+		if (fn.failedNames){
+			out.failure = fn.failure;
+			return res;
+		}
+		namesOK = fn.namesOK && namesOK;
+		if (!namesOK || !out.failure.empty()){ continue; }
+		place(fn.typeDiags, decl.line, typeDiags);
+		typesOK = typesOK && !anyFatal(fn.typeDiags);
+		out.failure = fn.failure;
+	}
+	if (!namesOK){
+		out.failure.clear();
+		return res;
+	}
+	out.diags.insert(out.diags.end(), typeDiags.begin(), typeDiags.end());
+	out.passed = typesOK && out.failure.empty();
+	return res;
+}
+
+}
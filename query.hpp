@@ -0,0 +1,215 @@
+#ifndef HOLEYC_QUERY_HPP
+#define HOLEYC_QUERY_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "errors.hpp"
+
+namespace holeyc{
+
+class DataType;
+class DeclNode;
+class SemSymbol;
+
+//A token as the query engine keeps it: plain data, so that
+// it can be compared, and replayed to the parser later
+struct Lexeme{
+	int kind;
+	size_t line;
+	size_t col;
+	//The name of an ID, or the text of a string literal
+	std::string text;
+	//The value of an int or char literal
+	int num;
+	bool operator==(const Lexeme& other) const {
+		return kind == other.kind && line == other.line
+			&& col == other.col && text == other.text
+			&& num == other.num;
+	}
+};
+
+//What an identifier refers to
+struct SymbolInfo{
+	SemSymbol * symbol;
+	//Where the symbol was declared, or 0 if it comes from
+	// the prelude
+	size_t line;
+	size_t col;
+};
+
+//The diagnostics of a whole program, as -c would report
+// them
+struct ProgramDiagnostics{
+	std::vector<Diagnostic> diags;
+	bool passed;
+	//Set if the analysis ended in an internal error; the
+	// status line -c would write for it
+	std::string failure;
+};
+
+//Semantic facts about one source file, computed on demand.
+// Every fact is a query whose answer is memoized along with
+// the queries it asked while being computed. When the text
+// changes, an answer is reused as long as none of the
+// queries it depends on has changed: those are brought up
+// to date first (recursively), and one whose answer comes
+// out the same as before does not count as changed. Since
+// declarations are known by name rather than by position,
+// editing one function leaves the answers about the others
+// in place.
+//
+// Pointers into answers (ASTs, symbols, types) stay valid
+// until a query is asked after the text has changed.
+class QueryEngine{
+public:
+	QueryEngine();
+	~QueryEngine();
+	//The input: the text of the file
+	void setText(const std::string& text);
+	//The input as runs of whole lines (such as the chunks of
+	// a Document), which are scanned each on its own. Runs
+	// whose text was seen last time are not scanned again.
+	void setText(const std::vector<std::string>& chunks);
+
+	//Every token of the file
+	const std::vector<Lexeme>& tokens();
+	//The AST of the nth declaration of name, or nullptr if
+	// there is none or it doesn't parse. Its lines are
+	// counted from the declaration's first line.
+	DeclNode * declaration(const std::string& name, size_t nth = 0);
+	//The symbol of the identifier at (line, col). False if
+	// there is none, or it is not bound.
+	bool symbolAt(size_t line, size_t col, SymbolInfo& out);
+	//The type of the innermost expression starting at
+	// (line, col), or nullptr if none has one
+	const DataType * typeAt(size_t line, size_t col);
+	//The diagnostics of the first function called name,
+	// from its own analysis: its name errors and, if its
+	// names are all bound, its type errors. False if there
+	// is no such function.
+	bool fnDiagnostics(const std::string& name,
+		std::vector<Diagnostic>& out, std::string& failure);
+	//The diagnostics of the whole file
+	const ProgramDiagnostics& diagnostics();
+	//The symbols of the global scope, in the order they are
+	// declared. Declarations that don't parse are skipped.
+	std::vector<SymbolInfo> globals();
+	//The symbol name analysis would bind for a global
+	// declaration, or nullptr if it would bind none. The
+	// caller owns it.
+	static SemSymbol * signature(DeclNode * decl);
+
+	//How many queries have been computed, and how many
+	// answers were found to be still up to date, so far
+	size_t computed() const { return myComputed; }
+	size_t reused() const { return myReused; }
+private:
+	enum Kind {
+		TEXT, CHUNK_TOKENS, TOKENS, OUTLINE, INDEX, DECL_TOKENS, DECL_AST,
+		SIGNATURE, GLOBALS, LOOKUP, ANALYSIS, SYMBOL, TYPE,
+		FN_DIAGS, DIAGNOSTICS
+	};
+	//A query and its arguments. Queries about a declaration
+	// name it by its name and which declaration of that
+	// name it is.
+	struct Key{
+		Kind kind;
+		//CHUNK_TOKENS: the text of the run
+		std::string decl;
+		size_t nth;
+		//LOOKUP: the global looked up
+		std::string name;
+		//SYMBOL and TYPE: the position, with lines counted
+		// from the declaration's first line
+		size_t line;
+		size_t col;
+		bool operator==(const Key& other) const {
+			return kind == other.kind && nth == other.nth
+				&& line == other.line && col == other.col
+				&& decl == other.decl && name == other.name;
+		}
+	};
+	struct KeyHash{
+		size_t operator()(const Key& key) const;
+	};
+	//A memoized answer. Revisions count changes of the
+	// text: changedAt is when the answer last changed, and
+	// verifiedAt when it was last known to be up to date.
+	struct Memo{
+		virtual ~Memo(){ }
+		//Is other (a fresh answer to the same query) the
+		// same answer?
+		virtual bool sameAs(const Memo& other) const = 0;
+		size_t changedAt = 0;
+		size_t verifiedAt = 0;
+		std::vector<Key> deps;
+	};
+	struct TextMemo;
+	struct TokensMemo;
+	struct OutlineMemo;
+	struct IndexMemo;
+	struct DeclTokensMemo;
+	struct DeclASTMemo;
+	struct SignatureMemo;
+	struct GlobalsMemo;
+	struct LookupMemo;
+	struct AnalysisMemo;
+	struct SymbolMemo;
+	struct TypeMemo;
+	struct FnDiagsMemo;
+	struct DiagnosticsMemo;
+
+	static Key key(Kind kind, const std::string& decl = "",
+		size_t nth = 0);
+	//The up-to-date answer to a query, recorded as a
+	// dependency of the query being computed (if any)
+	Memo * get(const Key& key);
+	template <typename T> T& fetch(const Key& key){
+		return static_cast<T&>(*get(key));
+	}
+	//Make sure memo is up to date, recomputing the queries
+	// it depends on as needed. False if it must be
+	// recomputed itself.
+	bool verify(Memo& memo);
+	void recompute(const Key& key, std::unique_ptr<Memo>& slot);
+	std::unique_ptr<Memo> compute(const Key& key);
+	//Drop the answers about declarations that are gone.
+	// Only done between queries.
+	void sweep();
+	//The declaration around (line, col), with line made
+	// relative to it. False if there is none.
+	bool locate(size_t& line, size_t col, Key& decl);
+
+	std::unique_ptr<Memo> chunkTokensQuery(const Key& key);
+	std::unique_ptr<Memo> tokensQuery();
+	std::unique_ptr<Memo> outlineQuery();
+	std::unique_ptr<Memo> indexQuery(const Key& key);
+	std::unique_ptr<Memo> declTokensQuery(const Key& key);
+	std::unique_ptr<Memo> declASTQuery(const Key& key);
+	std::unique_ptr<Memo> signatureQuery(const Key& key);
+	std::unique_ptr<Memo> globalsQuery();
+	std::unique_ptr<Memo> lookupQuery(const Key& key);
+	std::unique_ptr<Memo> analysisQuery(const Key& key);
+	std::unique_ptr<Memo> symbolQuery(const Key& key);
+	std::unique_ptr<Memo> typeQuery(const Key& key);
+	std::unique_ptr<Memo> fnDiagsQuery(const Key& key);
+	std::unique_ptr<Memo> diagnosticsQuery();
+
+	std::unordered_map<Key, std::unique_ptr<Memo>, KeyHash> myMemos;
+	//The dependencies of the queries being computed,
+	// innermost last, and the queries themselves
+	std::vector<std::vector<Key> *> myFrames;
+	std::unordered_set<Key, KeyHash> myActive;
+	size_t myRevision = 1;
+	size_t mySwept = 0;
+	size_t myComputed = 0;
+	size_t myReused = 0;
+};
+
+}
+
+#endif
@@ -57,68 +57,75 @@ public:
    }
 
    void errIllegal(size_t l, size_t c, std::string match){
-	Report::fatal(l, c, "Illegal character "
+	Report::fatal(l, c, DiagCode::ILLEGAL_CHAR, "Illegal character "
 		+ match);
 	hasError = true;
    }
 
    void errChrEscEmpty(size_t l, size_t c){
-	Report::fatal(l, c, "Empty escape sequence in"
+	Report::fatal(l, c, DiagCode::CHAR_EMPTY_ESC, "Empty escape sequence in"
 	" character literal");
 	hasError = true;
    }
 
    void errChrEmpty(size_t l, size_t c){
-	Report::fatal(l, c, "Empty character literal");
+	Report::fatal(l, c, DiagCode::CHAR_EMPTY, "Empty character literal");
 	hasError = true;
    }
 
    void errChrEsc(size_t l, size_t c){
-	Report::fatal(l, c, "Bad escape sequence in"
+	Report::fatal(l, c, DiagCode::CHAR_BAD_ESC, "Bad escape sequence in"
 	" char literal");
 	hasError = true;
    }
 
    void errStrEsc(size_t l, size_t c){
-	Report::fatal(l, c, "String literal with bad"
+	Report::fatal(l, c, DiagCode::STR_BAD_ESC, "String literal with bad"
 	" escape sequence ignored");
 	hasError = true;
    }
 
    void errStrUnterm(size_t l, size_t c){
-	Report::fatal(l, c, "Unterminated string"
+	Report::fatal(l, c, DiagCode::STR_UNTERM, "Unterminated string"
 	" literal ignored");
 	hasError = true;
 	
    }
 
    void errStrEscAndUnterm(size_t l, size_t c){
-	Report::fatal(l, c, "Unterminated string literal"
+	Report::fatal(l, c, DiagCode::STR_UNTERM_BAD_ESC, "Unterminated string literal"
 	"  with bad escape sequence ignored");
 	hasError = true;
    }
 
    void errIntOverflow(size_t l, size_t c){
-	Report::fatal(l, c, "Integer literal too large;"
+	Report::fatal(l, c, DiagCode::INT_TOO_LARGE, "Integer literal too large;"
 	"  using max value");
 	hasError = true;
    }
 
    void warn(int lineNumIn, int colNumIn, std::string msg){
-	std::cerr << lineNumIn << ":" << colNumIn 
-		<< " ***WARNING*** " << msg << std::endl;
+	Report::warn(static_cast<size_t>(lineNumIn), 
+		static_cast<size_t>(colNumIn), DiagCode::SCAN_WARNING, msg);
    }
 
    void error(int lineNumIn, int colNumIn, std::string msg){
-	std::cerr << lineNumIn << ":" << colNumIn 
-		<< " ***ERROR*** " << msg << std::endl;
+	Report::fatal(static_cast<size_t>(lineNumIn), 
+		static_cast<size_t>(colNumIn), DiagCode::SCAN_ERROR, msg);
    }
 
+   //Where scanning has got to, e.g. when the parser gives up
+   size_t getLine() const { return lineNum; }
+   size_t getCol() const { return colNum; }
+
    static std::string tokenKindString(int tokenKind);
 
    void outputTokens(std::ostream& outstream);
 
 private:
+   //Frees the tokens handed to the parser once the
+   // scanner goes away
+   TokenArena tokens;
    holeyc::Parser::semantic_type *yylval = nullptr;
    size_t lineNum;
    size_t colNum;
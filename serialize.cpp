@@ -0,0 +1,633 @@
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ast.hpp"
+#include "errors.hpp"
+#include "serialize.hpp"
+
+namespace holeyc{
+
+const char ASTImage::MAGIC[8] = {'H','O','L','E','Y','A','S','T'};
+
+static void putU32(std::string& out, uint32_t val){
+	for (int i = 0; i < 4; i++){
+		out.push_back(static_cast<char>((val >> (8 * i)) & 0xff));
+	}
+}
+
+static void setU32(std::string& out, size_t offset, uint32_t val){
+	for (size_t i = 0; i < 4; i++){
+		out[offset + i] = static_cast<char>((val >> (8 * i)) & 0xff);
+	}
+}
+
+void ASTWriter::node(NodeKind kind, const ASTNode * n){
+	byte(kind);
+	num(n->line());
+	num(n->col());
+}
+
+void ASTWriter::num(uint64_t val){
+	//LEB128: 7 bits per byte, high bit set on all but the last
+	while (val >= 0x80){
+		byte(static_cast<uint8_t>(val | 0x80));
+		val >>= 7;
+	}
+	byte(static_cast<uint8_t>(val));
+}
+
+void ASTWriter::snum(int64_t val){
+	//Zigzag-encode so that small negative numbers stay short
+	uint64_t bits = static_cast<uint64_t>(val);
+	num((bits << 1) ^ (val < 0 ? ~static_cast<uint64_t>(0) : 0));
+}
+
+void ASTWriter::atom(const std::string& str){
+	auto found = myAtomIDs.find(str);
+	if (found != myAtomIDs.end()){
+		num(found->second);
+		return;
+	}
+	uint32_t id = static_cast<uint32_t>(myAtoms.size());
+	myAtoms.push_back(str);
+	myAtomIDs.insert(std::make_pair(str, id));
+	num(id);
+}
+
+void ASTWriter::startDecl(){
+	myDecls.push_back(static_cast<uint32_t>(myNodes.size()));
+}
+
+void ASTWriter::write(const char * outPath){
+	std::string image;
+	image.reserve(ASTImage::HEADER_SIZE + myNodes.size()
+		+ 8 * myAtoms.size() + 4 * myDecls.size());
+	image.append(ASTImage::MAGIC, sizeof(ASTImage::MAGIC));
+	putU32(image, ASTImage::VERSION);
+	//The remaining header fields are patched in below,
+	// once their offsets are known
+	while (image.size() < ASTImage::HEADER_SIZE){
+		image.push_back('\0');
+	}
+
+	uint32_t nodesStart = static_cast<uint32_t>(image.size());
+	image += myNodes;
+
+	std::vector<uint32_t> atomOffsets;
+	for (const std::string& atom : myAtoms){
+		atomOffsets.push_back(static_cast<uint32_t>(image.size()));
+		image += atom;
+	}
+
+	uint32_t atomIndex = static_cast<uint32_t>(image.size());
+	for (size_t i = 0; i < myAtoms.size(); i++){
+		putU32(image, atomOffsets[i]);
+		putU32(image, static_cast<uint32_t>(myAtoms[i].size()));
+	}
+
+	uint32_t declIndex = static_cast<uint32_t>(image.size());
+	for (uint32_t declOffset : myDecls){
+		putU32(image, nodesStart + declOffset);
+	}
+
+	setU32(image, 12, static_cast<uint32_t>(myAtoms.size()));
+	setU32(image, 16, atomIndex);
+	setU32(image, 20, static_cast<uint32_t>(myDecls.size()));
+	setU32(image, 24, declIndex);
+	setU32(image, 28, nodesStart);
+	setU32(image, 32, static_cast<uint32_t>(image.size()));
+
+	std::ofstream outStream(outPath, std::ios::binary);
+	if (!outStream.good()){
+		std::string msg = "Bad output file ";
+		msg += outPath;
+		throw new InternalError(msg.c_str());
+	}
+	outStream.write(image.data(), static_cast<std::streamsize>(image.size()));
+}
+
+bool ASTReader::isImage(const char * path){
+	std::ifstream in(path, std::ios::binary);
+	char magic[sizeof(ASTImage::MAGIC)];
+	if (!in.read(magic, sizeof(magic))){
+		return false;
+	}
+	return memcmp(magic, ASTImage::MAGIC, sizeof(magic)) == 0;
+}
+
+ASTReader * ASTReader::open(const char * path){
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0){
+		std::string msg = "Bad AST image ";
+		msg += path;
+		throw new InternalError(msg.c_str());
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0
+	    || static_cast<size_t>(info.st_size) < ASTImage::HEADER_SIZE){
+		::close(fd);
+		throw new InternalError("Truncated AST image");
+	}
+	size_t size = static_cast<size_t>(info.st_size);
+	void * map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED){
+		throw new InternalError("Could not map AST image");
+	}
+	return new ASTReader(static_cast<const unsigned char *>(map), size);
+}
+
+ASTReader::ASTReader(const unsigned char * base, size_t size)
+: myBase(base), mySize(size){
+	if (memcmp(myBase, ASTImage::MAGIC, sizeof(ASTImage::MAGIC)) != 0){
+		corrupt();
+	}
+	if (u32(8) != ASTImage::VERSION){
+		throw new InternalError("Unsupported AST image version");
+	}
+	myAtomCount = u32(12);
+	myAtomIndex = u32(16);
+	myDeclCount = u32(20);
+	myDeclIndex = u32(24);
+	if (u32(32) != mySize
+	    || myAtomIndex + 8 * myAtomCount > mySize
+	    || myDeclIndex + 4 * myDeclCount > mySize){
+		corrupt();
+	}
+}
+
+ASTReader::~ASTReader(){
+	munmap(const_cast<unsigned char *>(myBase), mySize);
+}
+
+void ASTReader::corrupt() const{
+	throw new InternalError("Corrupt AST image");
+}
+
+uint32_t ASTReader::u32(size_t offset) const{
+	if (offset + 4 > mySize){ corrupt(); }
+	uint32_t val = 0;
+	for (size_t i = 0; i < 4; i++){
+		val |= static_cast<uint32_t>(myBase[offset + i]) << (8 * i);
+	}
+	return val;
+}
+
+uint8_t ASTReader::byte(size_t& offset) const{
+	if (offset >= mySize){ corrupt(); }
+	return myBase[offset++];
+}
+
+uint64_t ASTReader::num(size_t& offset) const{
+	uint64_t val = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7){
+		uint8_t b = byte(offset);
+		val |= static_cast<uint64_t>(b & 0x7f) << shift;
+		if ((b & 0x80) == 0){ return val; }
+	}
+	corrupt();
+	return 0;
+}
+
+int64_t ASTReader::snum(size_t& offset) const{
+	uint64_t bits = num(offset);
+	return static_cast<int64_t>((bits >> 1) ^ (~(bits & 1) + 1));
+}
+
+std::string ASTReader::atom(size_t& offset) const{
+	uint64_t id = num(offset);
+	if (id >= myAtomCount){ corrupt(); }
+	size_t entry = myAtomIndex + 8 * static_cast<size_t>(id);
+	size_t start = u32(entry);
+	size_t len = u32(entry + 4);
+	if (start + len > mySize){ corrupt(); }
+	return std::string(reinterpret_cast<const char *>(myBase + start), len);
+}
+
+template <typename T>
+std::unique_ptr<T> ASTReader::nodeAs(size_t& offset){
+	std::unique_ptr<ASTNode> read(node(offset));
+	T * res = dynamic_cast<T *>(read.get());
+	if (res == nullptr){ corrupt(); }
+	read.release();
+	return std::unique_ptr<T>(res);
+}
+
+template <typename T>
+ASTReader::OwnedList<T> ASTReader::list(size_t& offset){
+	uint64_t count = num(offset);
+	OwnedList<T> res(new std::list<T *>());
+	for (uint64_t i = 0; i < count; i++){
+		res->push_back(nodeAs<T>(offset).release());
+	}
+	return res;
+}
+
+DeclNode * ASTReader::decl(size_t index){
+	if (index >= myDeclCount){
+		throw new InternalError("AST image declaration out of range");
+	}
+	size_t offset = u32(myDeclIndex + 4 * index);
+	return nodeAs<DeclNode>(offset).release();
+}
+
+ProgramNode * ASTReader::program(){
+	OwnedList<DeclNode> globals(new std::list<DeclNode *>());
+	for (size_t i = 0; i < myDeclCount; i++){
+		globals->push_back(decl(i));
+	}
+	return new ProgramNode(globals.release());
+}
+
+//Note that children are always read into locals before the
+// node is constructed: the order in which function arguments
+// are evaluated is unspecified, but the stream must be read
+// in order. The locals own the children until the node does,
+// so that they are freed if a later read finds corruption.
+ASTNode * ASTReader::node(size_t& off){
+	NodeKind kind = static_cast<NodeKind>(byte(off));
+	if (kind == NONE_NODE){ return nullptr; }
+	size_t l = num(off);
+	size_t c = num(off);
+	switch (kind){
+	case ID_NODE:
+		return new IDNode(l, c, atom(off));
+	case REF_NODE:
+		return new RefNode(l, c, nodeAs<IDNode>(off).release());
+	case DEREF_NODE:
+		return new DerefNode(l, c, nodeAs<IDNode>(off).release());
+	case INDEX_NODE: {
+		std::unique_ptr<IDNode> base = nodeAs<IDNode>(off);
+		std::unique_ptr<ExpNode> offset = nodeAs<ExpNode>(off);
+		return new IndexNode(l, c, base.release(), offset.release());
+	}
+	case INT_TYPE_NODE:
+		return new IntTypeNode(l, c, byte(off) != 0);
+	case BOOL_TYPE_NODE:
+		return new BoolTypeNode(l, c, byte(off) != 0);
+	case CHAR_TYPE_NODE:
+		return new CharTypeNode(l, c, byte(off) != 0);
+	case VOID_TYPE_NODE:
+		return new VoidTypeNode(l, c);
+	case VAR_DECL_NODE: {
+		std::unique_ptr<TypeNode> type = nodeAs<TypeNode>(off);
+		std::unique_ptr<IDNode> id = nodeAs<IDNode>(off);
+		return new VarDeclNode(l, c, type.release(), id.release());
+	}
+	case FORMAL_DECL_NODE: {
+		std::unique_ptr<TypeNode> type = nodeAs<TypeNode>(off);
+		std::unique_ptr<IDNode> id = nodeAs<IDNode>(off);
+		return new FormalDeclNode(l, c, type.release(), id.release());
+	}
+	case FN_DECL_NODE: {
+		std::unique_ptr<TypeNode> retType = nodeAs<TypeNode>(off);
+		std::unique_ptr<IDNode> id = nodeAs<IDNode>(off);
+		auto formals = list<FormalDeclNode>(off);
+		auto body = list<StmtNode>(off);
+		return new FnDeclNode(l, c, retType.release(), id.release(),
+			formals.release(), body.release());
+	}
+	case ASSIGN_STMT_NODE:
+		return new AssignStmtNode(l, c, nodeAs<AssignExpNode>(off).release());
+	case FROM_CONSOLE_STMT_NODE:
+		return new FromConsoleStmtNode(l, c, nodeAs<LValNode>(off).release());
+	case TO_CONSOLE_STMT_NODE:
+		return new ToConsoleStmtNode(l, c, nodeAs<ExpNode>(off).release());
+	case POST_DEC_STMT_NODE:
+		return new PostDecStmtNode(l, c, nodeAs<LValNode>(off).release());
+	case POST_INC_STMT_NODE:
+		return new PostIncStmtNode(l, c, nodeAs<LValNode>(off).release());
+	case IF_STMT_NODE: {
+		std::unique_ptr<ExpNode> cond = nodeAs<ExpNode>(off);
+		auto body = list<StmtNode>(off);
+		return new IfStmtNode(l, c, cond.release(), body.release());
+	}
+	case IF_ELSE_STMT_NODE: {
+		std::unique_ptr<ExpNode> cond = nodeAs<ExpNode>(off);
+		auto bodyTrue = list<StmtNode>(off);
+		auto bodyFalse = list<StmtNode>(off);
+		return new IfElseStmtNode(l, c, cond.release(),
+			bodyTrue.release(), bodyFalse.release());
+	}
+	case WHILE_STMT_NODE: {
+		std::unique_ptr<ExpNode> cond = nodeAs<ExpNode>(off);
+		auto body = list<StmtNode>(off);
+		return new WhileStmtNode(l, c, cond.release(), body.release());
+	}
+	case RETURN_STMT_NODE: {
+		//The returned expression is optional
+		std::unique_ptr<ASTNode> exp(node(off));
+		ExpNode * retExp = dynamic_cast<ExpNode *>(exp.get());
+		if (exp != nullptr && retExp == nullptr){ corrupt(); }
+		exp.release();
+		return new ReturnStmtNode(l, c, retExp);
+	}
+	case CALL_STMT_NODE:
+		return new CallStmtNode(l, c, nodeAs<CallExpNode>(off).release());
+	case CALL_EXP_NODE: {
+		std::unique_ptr<IDNode> id = nodeAs<IDNode>(off);
+		auto args = list<ExpNode>(off);
+		return new CallExpNode(l, c, id.release(), args.release());
+	}
+	case PLUS_NODE: case MINUS_NODE: case TIMES_NODE:
+	case DIVIDE_NODE: case AND_NODE: case OR_NODE:
+	case EQUALS_NODE: case NOT_EQUALS_NODE: case LESS_NODE:
+	case LESS_EQ_NODE: case GREATER_NODE: case GREATER_EQ_NODE: {
+		std::unique_ptr<ExpNode> lhsRead = nodeAs<ExpNode>(off);
+		std::unique_ptr<ExpNode> rhsRead = nodeAs<ExpNode>(off);
+		ExpNode * lhs = lhsRead.release();
+		ExpNode * rhs = rhsRead.release();
+		switch (kind){
+		case PLUS_NODE: return new PlusNode(l, c, lhs, rhs);
+		case MINUS_NODE: return new MinusNode(l, c, lhs, rhs);
+		case TIMES_NODE: return new TimesNode(l, c, lhs, rhs);
+		case DIVIDE_NODE: return new DivideNode(l, c, lhs, rhs);
+		case AND_NODE: return new AndNode(l, c, lhs, rhs);
+		case OR_NODE: return new OrNode(l, c, lhs, rhs);
+		case EQUALS_NODE: return new EqualsNode(l, c, lhs, rhs);
+		case NOT_EQUALS_NODE: return new NotEqualsNode(l, c, lhs, rhs);
+		case LESS_NODE: return new LessNode(l, c, lhs, rhs);
+		case LESS_EQ_NODE: return new LessEqNode(l, c, lhs, rhs);
+		case GREATER_NODE: return new GreaterNode(l, c, lhs, rhs);
+		default: return new GreaterEqNode(l, c, lhs, rhs);
+		}
+	}
+	case NEG_NODE:
+		return new NegNode(l, c, nodeAs<ExpNode>(off).release());
+	case NOT_NODE:
+		return new NotNode(l, c, nodeAs<ExpNode>(off).release());
+	case ASSIGN_EXP_NODE: {
+		std::unique_ptr<LValNode> dst = nodeAs<LValNode>(off);
+		std::unique_ptr<ExpNode> src = nodeAs<ExpNode>(off);
+		return new AssignExpNode(l, c, dst.release(), src.release());
+	}
+	case INT_LIT_NODE:
+		return new IntLitNode(l, c, static_cast<int>(snum(off)));
+	case STR_LIT_NODE:
+		return new StrLitNode(l, c, atom(off));
+	case CHAR_LIT_NODE:
+		return new CharLitNode(l, c, static_cast<char>(byte(off)));
+	case NULL_PTR_NODE:
+		return new NullPtrNode(l, c);
+	case TRUE_NODE:
+		return new TrueNode(l, c);
+	case FALSE_NODE:
+		return new FalseNode(l, c);
+	default:
+		corrupt();
+	}
+	return nullptr;
+}
+
+void ProgramNode::serialize(ASTWriter * w){
+	//The program node itself is implicit in the image: the
+	// decl index lists its children
+	for (DeclNode * decl : *myGlobals){
+		w->startDecl();
+		decl->serialize(w);
+	}
+}
+
+void IDNode::serialize(ASTWriter * w){
+	w->node(ID_NODE, this);
+	w->atom(name);
+}
+
+void RefNode::serialize(ASTWriter * w){
+	w->node(REF_NODE, this);
+	myID->serialize(w);
+}
+
+void DerefNode::serialize(ASTWriter * w){
+	w->node(DEREF_NODE, this);
+	myID->serialize(w);
+}
+
+void IndexNode::serialize(ASTWriter * w){
+	w->node(INDEX_NODE, this);
+	myBase->serialize(w);
+	myOffset->serialize(w);
+}
+
+void IntTypeNode::serialize(ASTWriter * w){
+	w->node(INT_TYPE_NODE, this);
+	w->byte(isPtr ? 1 : 0);
+}
+
+void BoolTypeNode::serialize(ASTWriter * w){
+	w->node(BOOL_TYPE_NODE, this);
+	w->byte(isPtr ? 1 : 0);
+}
+
+void CharTypeNode::serialize(ASTWriter * w){
+	w->node(CHAR_TYPE_NODE, this);
+	w->byte(isPtr ? 1 : 0);
+}
+
+void VoidTypeNode::serialize(ASTWriter * w){
+	w->node(VOID_TYPE_NODE, this);
+}
+
+void VarDeclNode::serialize(ASTWriter * w){
+	w->node(VAR_DECL_NODE, this);
+	myType->serialize(w);
+	myID->serialize(w);
+}
+
+void FormalDeclNode::serialize(ASTWriter * w){
+	w->node(FORMAL_DECL_NODE, this);
+	getTypeNode()->serialize(w);
+	ID()->serialize(w);
+}
+
+void FnDeclNode::serialize(ASTWriter * w){
+	w->node(FN_DECL_NODE, this);
+	myRetType->serialize(w);
+	myID->serialize(w);
+	w->list(myFormals);
+	w->list(myBody);
+}
+
+void AssignStmtNode::serialize(ASTWriter * w){
+	w->node(ASSIGN_STMT_NODE, this);
+	myExp->serialize(w);
+}
+
+void FromConsoleStmtNode::serialize(ASTWriter * w){
+	w->node(FROM_CONSOLE_STMT_NODE, this);
+	myDst->serialize(w);
+}
+
+void ToConsoleStmtNode::serialize(ASTWriter * w){
+	w->node(TO_CONSOLE_STMT_NODE, this);
+	mySrc->serialize(w);
+}
+
+void PostDecStmtNode::serialize(ASTWriter * w){
+	w->node(POST_DEC_STMT_NODE, this);
+	myLVal->serialize(w);
+}
+
+void PostIncStmtNode::serialize(ASTWriter * w){
+	w->node(POST_INC_STMT_NODE, this);
+	myLVal->serialize(w);
+}
+
+void IfStmtNode::serialize(ASTWriter * w){
+	w->node(IF_STMT_NODE, this);
+	myCond->serialize(w);
+	w->list(myBody);
+}
+
+void IfElseStmtNode::serialize(ASTWriter * w){
+	w->node(IF_ELSE_STMT_NODE, this);
+	myCond->serialize(w);
+	w->list(myBodyTrue);
+	w->list(myBodyFalse);
+}
+
+void WhileStmtNode::serialize(ASTWriter * w){
+	w->node(WHILE_STMT_NODE, this);
+	myCond->serialize(w);
+	w->list(myBody);
+}
+
+void ReturnStmtNode::serialize(ASTWriter * w){
+	w->node(RETURN_STMT_NODE, this);
+	if (myExp == nullptr){
+		w->none();
+	} else {
+		myExp->serialize(w);
+	}
+}
+
+void CallStmtNode::serialize(ASTWriter * w){
+	w->node(CALL_STMT_NODE, this);
+	myCallExp->serialize(w);
+}
+
+void CallExpNode::serialize(ASTWriter * w){
+	w->node(CALL_EXP_NODE, this);
+	myID->serialize(w);
+	w->list(myArgs);
+}
+
+void PlusNode::serialize(ASTWriter * w){
+	w->node(PLUS_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void MinusNode::serialize(ASTWriter * w){
+	w->node(MINUS_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void TimesNode::serialize(ASTWriter * w){
+	w->node(TIMES_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void DivideNode::serialize(ASTWriter * w){
+	w->node(DIVIDE_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void AndNode::serialize(ASTWriter * w){
+	w->node(AND_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void OrNode::serialize(ASTWriter * w){
+	w->node(OR_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void EqualsNode::serialize(ASTWriter * w){
+	w->node(EQUALS_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void NotEqualsNode::serialize(ASTWriter * w){
+	w->node(NOT_EQUALS_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void LessNode::serialize(ASTWriter * w){
+	w->node(LESS_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void LessEqNode::serialize(ASTWriter * w){
+	w->node(LESS_EQ_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void GreaterNode::serialize(ASTWriter * w){
+	w->node(GREATER_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void GreaterEqNode::serialize(ASTWriter * w){
+	w->node(GREATER_EQ_NODE, this);
+	myExp1->serialize(w);
+	myExp2->serialize(w);
+}
+
+void NegNode::serialize(ASTWriter * w){
+	w->node(NEG_NODE, this);
+	myExp->serialize(w);
+}
+
+void NotNode::serialize(ASTWriter * w){
+	w->node(NOT_NODE, this);
+	myExp->serialize(w);
+}
+
+void AssignExpNode::serialize(ASTWriter * w){
+	w->node(ASSIGN_EXP_NODE, this);
+	myDst->serialize(w);
+	mySrc->serialize(w);
+}
+
+void IntLitNode::serialize(ASTWriter * w){
+	w->node(INT_LIT_NODE, this);
+	w->snum(myNum);
+}
+
+void StrLitNode::serialize(ASTWriter * w){
+	w->node(STR_LIT_NODE, this);
+	w->atom(myStr);
+}
+
+void CharLitNode::serialize(ASTWriter * w){
+	w->node(CHAR_LIT_NODE, this);
+	w->byte(static_cast<uint8_t>(myVal));
+}
+
+void NullPtrNode::serialize(ASTWriter * w){
+	w->node(NULL_PTR_NODE, this);
+}
+
+void TrueNode::serialize(ASTWriter * w){
+	w->node(TRUE_NODE, this);
+}
+
+void FalseNode::serialize(ASTWriter * w){
+	w->node(FALSE_NODE, this);
+}
+
+} //End namespace holeyc
@@ -0,0 +1,140 @@
+#ifndef HOLEYC_SERIALIZE_HPP
+#define HOLEYC_SERIALIZE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include "ast.hpp"
+#include "errors.hpp"
+
+namespace holeyc{
+
+//Tags written in front of every node in a serialized AST.
+// The values are part of the file format, so new kinds
+// must only ever be appended (and the version bumped if an
+// existing kind changes shape).
+enum NodeKind : uint8_t {
+	NONE_NODE = 0,
+	PROGRAM_NODE,
+	ID_NODE, REF_NODE, DEREF_NODE, INDEX_NODE,
+	INT_TYPE_NODE, BOOL_TYPE_NODE, CHAR_TYPE_NODE, VOID_TYPE_NODE,
+	VAR_DECL_NODE, FORMAL_DECL_NODE, FN_DECL_NODE,
+	ASSIGN_STMT_NODE, FROM_CONSOLE_STMT_NODE, TO_CONSOLE_STMT_NODE,
+	POST_DEC_STMT_NODE, POST_INC_STMT_NODE,
+	IF_STMT_NODE, IF_ELSE_STMT_NODE, WHILE_STMT_NODE,
+	RETURN_STMT_NODE, CALL_STMT_NODE,
+	CALL_EXP_NODE,
+	PLUS_NODE, MINUS_NODE, TIMES_NODE, DIVIDE_NODE,
+	AND_NODE, OR_NODE,
+	EQUALS_NODE, NOT_EQUALS_NODE,
+	LESS_NODE, LESS_EQ_NODE, GREATER_NODE, GREATER_EQ_NODE,
+	NEG_NODE, NOT_NODE,
+	ASSIGN_EXP_NODE,
+	INT_LIT_NODE, STR_LIT_NODE, CHAR_LIT_NODE,
+	NULL_PTR_NODE, TRUE_NODE, FALSE_NODE,
+	NODE_KIND_COUNT
+};
+
+//The on-disk layout of a serialized AST ("AST image"):
+//
+//  [header]      magic, version, and the offsets below
+//  [nodes]       preorder node stream, one record per node:
+//                kind byte, varint line, varint col, then
+//                the node's own fields and children
+//  [atom data]   bytes of every distinct identifier/string
+//  [atom index]  (offset, length) pairs into the atom data
+//  [decl index]  offset of each top-level declaration
+//
+// All fixed-width fields are little-endian uint32s. Since
+// every top-level declaration can be found through the decl
+// index, a reader only has to decode the declarations it is
+// actually asked for.
+class ASTImage{
+public:
+	static const char MAGIC[8];
+	static const uint32_t VERSION = 1;
+	static const size_t HEADER_SIZE = 36;
+};
+
+//Accumulates the serialized form of an AST. Each node's
+// serialize method calls back into the writer to emit its
+// kind, position and fields.
+class ASTWriter{
+public:
+	ASTWriter(){ }
+	void node(NodeKind kind, const ASTNode * n);
+	void none(){ byte(NONE_NODE); }
+	void byte(uint8_t b){ myNodes.push_back(static_cast<char>(b)); }
+	void num(uint64_t val);
+	void snum(int64_t val);
+	void atom(const std::string& str);
+	void startDecl();
+	template <typename T>
+	void list(const std::list<T *> * elts){
+		num(elts->size());
+		for (T * elt : *elts){
+			elt->serialize(this);
+		}
+	}
+	//Write the finished image to the given path.
+	void write(const char * outPath);
+private:
+	std::string myNodes;
+	std::vector<uint32_t> myDecls;
+	std::vector<std::string> myAtoms;
+	HashMap<std::string, uint32_t> myAtomIDs;
+};
+
+//Reads an AST image by memory-mapping it. Nothing is
+// decoded up front: the header is validated when the image
+// is opened, and nodes are only reconstructed when a
+// declaration (or the whole program) is requested. If the
+// image turns out to be corrupt partway through a node, the
+// nodes already read for it are freed before the error is
+// thrown.
+class ASTReader{
+public:
+	//Returns true if the file at path starts with the
+	// image magic, i.e. should be loaded rather than parsed
+	static bool isImage(const char * path);
+	static ASTReader * open(const char * path);
+	~ASTReader();
+	size_t declCount() const { return myDeclCount; }
+	DeclNode * decl(size_t index);
+	ProgramNode * program();
+private:
+	//Deletes a list of nodes along with the nodes in it
+	struct ListDeleter{
+		template <typename T>
+		void operator()(std::list<T *> * elts) const{
+			for (T * elt : *elts){ delete elt; }
+			delete elts;
+		}
+	};
+	template <typename T>
+	using OwnedList = std::unique_ptr<std::list<T *>, ListDeleter>;
+
+	ASTReader(const unsigned char * base, size_t size);
+	uint32_t u32(size_t offset) const;
+	uint8_t byte(size_t& offset) const;
+	uint64_t num(size_t& offset) const;
+	int64_t snum(size_t& offset) const;
+	std::string atom(size_t& offset) const;
+	ASTNode * node(size_t& offset);
+	template <typename T> std::unique_ptr<T> nodeAs(size_t& offset);
+	template <typename T> OwnedList<T> list(size_t& offset);
+	void corrupt() const;
+
+	const unsigned char * myBase;
+	size_t mySize;
+	size_t myAtomCount;
+	size_t myAtomIndex;
+	size_t myDeclCount;
+	size_t myDeclIndex;
+};
+
+}
+
+#endif
@@ -0,0 +1,339 @@
+#include <map>
+#include <unordered_map>
+
+#include "3ac.hpp"
+#include "cfg.hpp"
+#include "dataflow.hpp"
+#include "errors.hpp"
+
+namespace holeyc{
+
+typedef std::vector<std::unique_ptr<Quad>> QuadList;
+//dst := src, one of a set of copies that happen at once
+typedef std::pair<Opd *, Opd *> Copy;
+
+//Code that can't run would otherwise keep writing the
+// original variables, so it goes first. The leave quad
+// stays even when it can't be reached (the function loops
+// forever), since the procedure ends with it.
+void Procedure::dropUnreachable(){
+	CFG cfg(this);
+	QuadList kept;
+	kept.reserve(myQuads.size());
+	for (size_t id = 0; id < cfg.size(); id++){
+		if (!cfg.reachable(id) && id != cfg.exit()){ continue; }
+		const BasicBlock& block = cfg.block(id);
+		for (size_t i = block.first(); i < block.end(); i++){
+			kept.push_back(std::move(myQuads[i]));
+		}
+	}
+	myQuads = std::move(kept);
+}
+
+//The construction of Cytron et al., "Efficiently Computing
+// Static Single Assignment Form and the Control Dependence
+// Graph", pruned with liveness: a variable gets a phi at
+// each block in the iterated dominance frontier of the
+// blocks that write it, but only where it is live. The
+// renaming walk then gives each write a new name and each
+// read the name of the write that reaches it.
+//
+// The first value of a variable keeps the variable's own
+// operand: the value it has on entry if it is live there,
+// and otherwise the first write the walk meets. A temporary
+// written once is then left as it is.
+void Procedure::toSSA(){
+	if (mySSA){ throw new InternalError("Procedure already in SSA form"); }
+	dropUnreachable();
+	CFG cfg(this);
+	DomTree dom(cfg);
+	Variables vars(cfg);
+	Liveness live(cfg, vars);
+
+	//The variables to rename, and the blocks that write each
+	std::vector<Opd *> renamed;
+	std::unordered_map<const Opd *, size_t> ids;
+	std::vector<std::vector<size_t>> defBlocks;
+	for (size_t b = 0; b < cfg.size(); b++){
+		const BasicBlock& block = cfg.block(b);
+		for (size_t i = block.first(); i < block.end(); i++){
+			Opd * def = myQuads[i]->getDef();
+			if (def == nullptr || myProg->isEscaping(def)){ continue; }
+			auto found = ids.find(def);
+			if (found == ids.end()){
+				found = ids.emplace(def, renamed.size()).first;
+				renamed.push_back(def);
+				defBlocks.emplace_back();
+			}
+			std::vector<size_t>& blocks = defBlocks[found->second];
+			if (blocks.empty() || blocks.back() != b){ blocks.push_back(b); }
+		}
+	}
+
+	//The phis of each block, and the variable of each phi.
+	// An untracked variable is never live outside the block
+	// that writes it, so it needs none.
+	std::vector<std::vector<PhiQuad *>> phis(cfg.size());
+	std::vector<std::vector<size_t>> phiVars(cfg.size());
+	std::vector<size_t> considered(cfg.size(), DomTree::NONE);
+	std::vector<size_t> writes(cfg.size(), DomTree::NONE);
+	for (size_t v = 0; v < renamed.size(); v++){
+		long tracked = vars.find(renamed[v]);
+		if (tracked < 0){ continue; }
+		std::vector<size_t> work = defBlocks[v];
+		for (size_t b : work){ writes[b] = v; }
+		while (!work.empty()){
+			size_t b = work.back();
+			work.pop_back();
+			for (size_t d : dom.frontier(b)){
+				if (considered[d] == v){ continue; }
+				considered[d] = v;
+				if (!live.in(d).test(static_cast<size_t>(tracked))){ continue; }
+				phis[d].push_back(new PhiQuad(renamed[v]));
+				phiVars[d].push_back(v);
+				if (writes[d] != v){
+					writes[d] = v;
+					work.push_back(d);
+				}
+			}
+		}
+	}
+
+	//The names of each variable's values that dominate the
+	// block being renamed, innermost last
+	std::vector<std::vector<Opd *>> stacks(renamed.size());
+	std::vector<bool> named(renamed.size(), false);
+	for (size_t v = 0; v < renamed.size(); v++){
+		long tracked = vars.find(renamed[v]);
+		if (tracked >= 0
+		  && live.in(cfg.entry()).test(static_cast<size_t>(tracked))){
+			stacks[v].push_back(renamed[v]);
+			named[v] = true;
+		}
+	}
+	std::vector<std::vector<size_t>> pushed(cfg.size());
+	auto write = [&](size_t b, size_t v){
+		Opd * opd = named[v] ? makeVersion(renamed[v]) : renamed[v];
+		named[v] = true;
+		stacks[v].push_back(opd);
+		pushed[b].push_back(v);
+		return opd;
+	};
+	auto read = [&](Opd * opd){
+		auto found = ids.find(opd);
+		if (found == ids.end()){ return opd; }
+		if (stacks[found->second].empty()){
+			throw new InternalError("Read with no reaching write in SSA");
+		}
+		return stacks[found->second].back();
+	};
+
+	//Preorder over the dominator tree, with an explicit
+	// stack; each block is pushed again to pop its names
+	std::vector<std::pair<size_t, bool>> walk;
+	walk.emplace_back(cfg.entry(), false);
+	while (!walk.empty()){
+		size_t b = walk.back().first;
+		bool leaving = walk.back().second;
+		walk.pop_back();
+		if (leaving){
+			for (size_t v : pushed[b]){ stacks[v].pop_back(); }
+			continue;
+		}
+		walk.emplace_back(b, true);
+		for (size_t k = 0; k < phis[b].size(); k++){
+			phis[b][k]->setDef(write(b, phiVars[b][k]));
+		}
+		const BasicBlock& block = cfg.block(b);
+		for (size_t i = block.first(); i < block.end(); i++){
+			Quad * quad = myQuads[i].get();
+			quad->mapUses(read);
+			Opd * def = quad->getDef();
+			if (def == nullptr){ continue; }
+			auto found = ids.find(def);
+			if (found != ids.end()){ quad->setDef(write(b, found->second)); }
+		}
+		for (size_t succ : block.succs()){
+			for (size_t k = 0; k < phis[succ].size(); k++){
+				phis[succ][k]->addArg(b, read(renamed[phiVars[succ][k]]));
+			}
+		}
+		//Last in, first out: children go in reverse so that
+		// versions are numbered in block order
+		const std::vector<size_t>& children = dom.children(b);
+		for (size_t k = children.size(); k > 0; k--){
+			walk.emplace_back(children[k - 1], false);
+		}
+	}
+
+	//Put the phis at the tops of their blocks. They don't
+	// jump, so the blocks and their ids stay the same.
+	QuadList quads;
+	quads.reserve(myQuads.size());
+	for (size_t b = 0; b < cfg.size(); b++){
+		const BasicBlock& block = cfg.block(b);
+		if (!phis[b].empty()){
+			Quad * first = myQuads[block.first()].get();
+			phis[b][0]->setLabel(first->getLabel());
+			first->setLabel(nullptr);
+		}
+		for (PhiQuad * phi : phis[b]){ quads.emplace_back(phi); }
+		for (size_t i = block.first(); i < block.end(); i++){
+			quads.push_back(std::move(myQuads[i]));
+		}
+	}
+	myQuads = std::move(quads);
+	mySSA = true;
+}
+
+//Emit parallel copies one at a time. A copy can go once no
+// copy still to go reads its destination; when only cycles
+// are left, one destination is saved to a temporary first.
+static void sequentialize(Procedure * proc, std::vector<Copy> copies,
+	QuadList& out){
+	while (!copies.empty()){
+		bool progress = false;
+		for (size_t i = 0; i < copies.size(); ){
+			bool read = false;
+			for (const Copy& other : copies){
+				if (other.second == copies[i].first){ read = true; }
+			}
+			if (read){
+				i++;
+				continue;
+			}
+			out.emplace_back(new AssignQuad(copies[i].first, copies[i].second));
+			copies.erase(copies.begin() + static_cast<long>(i));
+			progress = true;
+		}
+		if (!progress){
+			Opd * saved = copies[0].first;
+			Opd * tmp = proc->makeTmp(saved->getWidth());
+			out.emplace_back(new AssignQuad(tmp, saved));
+			for (Copy& copy : copies){
+				if (copy.second == saved){ copy.second = tmp; }
+			}
+		}
+	}
+}
+
+//Each phi becomes a copy at the end of each predecessor.
+// A predecessor that ends with a conditional jump has two
+// ways out, and copies for one must not happen on the
+// other, so those edges are split: the copies for the jump
+// go in a new block after the leave quad that jumps on to
+// the phis' block, and those for the fall-through go right
+// after the predecessor. Splitting means no copy can
+// overwrite a value still needed on another path (the
+// "lost copy" problem), and sequentializing each edge's
+// copies as a parallel set handles phis that read each
+// other (the "swap" problem).
+void Procedure::fromSSA(){
+	if (!mySSA){ throw new InternalError("Procedure not in SSA form"); }
+	CFG cfg(this);
+	std::map<std::pair<size_t, size_t>, std::vector<Copy>> edges;
+	for (size_t b = 0; b < cfg.size(); b++){
+		const BasicBlock& block = cfg.block(b);
+		for (size_t i = block.first(); i < block.end(); i++){
+			auto phi = dynamic_cast<const PhiQuad *>(myQuads[i].get());
+			if (phi == nullptr){ break; }
+			for (const auto& arg : phi->getArgs()){
+				if (arg.second == phi->getDef()){ continue; }
+				edges[std::make_pair(arg.first, b)].emplace_back(
+					phi->getDef(), arg.second);
+			}
+		}
+	}
+	auto copiesOn = [&](size_t from, size_t to) -> const std::vector<Copy> *{
+		auto found = edges.find(std::make_pair(from, to));
+		return found == edges.end() ? nullptr : &found->second;
+	};
+
+	QuadList quads;
+	QuadList split;
+	quads.reserve(myQuads.size());
+	for (size_t b = 0; b < cfg.size(); b++){
+		const BasicBlock& block = cfg.block(b);
+		Label * label = nullptr;
+		size_t i = block.first();
+		for (; i < block.end(); i++){
+			if (dynamic_cast<const PhiQuad *>(myQuads[i].get()) == nullptr){
+				break;
+			}
+			if (myQuads[i]->getLabel() != nullptr){
+				label = myQuads[i]->getLabel();
+			}
+		}
+		if (label != nullptr){ myQuads[i]->setLabel(label); }
+
+		Quad * last = myQuads[block.end() - 1].get();
+		Label * target = last->getJumpTarget();
+		bool conditional = target != nullptr && last->fallsThrough();
+		//Copies go before the jump that ends the block, if any
+		size_t stop = target != nullptr ? block.end() - 1 : block.end();
+		for (; i < stop; i++){ quads.push_back(std::move(myQuads[i])); }
+
+		if (!conditional){
+			if (!block.succs().empty()){
+				const std::vector<Copy> * copies = copiesOn(b, block.succs()[0]);
+				if (copies != nullptr){
+					size_t first = quads.size();
+					sequentialize(this, *copies, quads);
+					//A block that is only a goto has its label there
+					Label * own = i < block.end() ? myQuads[i]->getLabel() : nullptr;
+					if (own != nullptr){
+						myQuads[i]->setLabel(nullptr);
+						quads[first]->setLabel(own);
+					}
+				}
+			}
+			for (; i < block.end(); i++){ quads.push_back(std::move(myQuads[i])); }
+			continue;
+		}
+
+		JmpIfQuad * jump = dynamic_cast<JmpIfQuad *>(last);
+		if (jump == nullptr){ throw new InternalError("Unknown branch in SSA"); }
+		//The fall-through successor comes first, and is the only
+		// one if the jump is to the next block too
+		size_t next = b + 1;
+		size_t taken = block.succs().back();
+		if (taken != next){
+			const std::vector<Copy> * copies = copiesOn(b, taken);
+			if (copies != nullptr){
+				size_t first = split.size();
+				sequentialize(this, *copies, split);
+				Label * hop = makeLabel();
+				split[first]->setLabel(hop);
+				split.emplace_back(new JmpQuad(jump->getTarget()));
+				jump->setTarget(hop);
+			}
+		}
+		const std::vector<Copy> * copies = copiesOn(b, next);
+		if (copies != nullptr){
+			size_t first = quads.size() + 1;
+			quads.push_back(std::move(myQuads[block.end() - 1]));
+			sequentialize(this, *copies, quads);
+			//A jump to the next block takes the same edge
+			if (taken == next){
+				Label * hop = makeLabel();
+				quads[first]->setLabel(hop);
+				jump->setTarget(hop);
+			}
+		} else {
+			quads.push_back(std::move(myQuads[block.end() - 1]));
+		}
+	}
+	for (auto& quad : split){ quads.push_back(std::move(quad)); }
+	myQuads = std::move(quads);
+	mySSA = false;
+}
+
+void IRProgram::toSSA(){
+	for (auto& proc : myProcs){ proc->toSSA(); }
+}
+
+void IRProgram::fromSSA(){
+	for (auto& proc : myProcs){ proc->fromSSA(); }
+}
+
+}
@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "errors.hpp"
+#include "hash.hpp"
+#include "symbol_index.hpp"
+
+namespace holeyc{
+
+const char SymbolIndexFormat::MAGIC[8] = {'H','O','L','E','Y','I','D','X'};
+
+uint32_t SymbolIndexFormat::hash(const char * name, size_t len){
+	return static_cast<uint32_t>(Hasher().add(name, len).done());
+}
+
+static void putU32(std::string& out, uint32_t val){
+	for (int i = 0; i < 4; i++){
+		out.push_back(static_cast<char>((val >> (8 * i)) & 0xff));
+	}
+}
+
+static void setU32(std::string& out, size_t offset, uint32_t val){
+	for (size_t i = 0; i < 4; i++){
+		out[offset + i] = static_cast<char>((val >> (8 * i)) & 0xff);
+	}
+}
+
+static uint32_t narrow(size_t val){
+	if (val > UINT32_MAX){
+		throw new InternalError("Symbol index too large");
+	}
+	return static_cast<uint32_t>(val);
+}
+
+void SymbolIndexWriter::addFile(const std::string& path,
+	const std::vector<IndexedSymbol>& symbols){
+	myFiles[path] = symbols;
+}
+
+void SymbolIndexWriter::write(const char * outPath) const{
+	std::string out(SymbolIndexFormat::MAGIC,
+		sizeof(SymbolIndexFormat::MAGIC));
+	putU32(out, SymbolIndexFormat::VERSION);
+	//The rest of the header is patched in at the end
+	while (out.size() < SymbolIndexFormat::HEADER_SIZE){
+		out.push_back('\0');
+	}
+
+	size_t stringsStart = out.size();
+	std::unordered_map<std::string, uint32_t> strings;
+	auto intern = [&](const std::string& str){
+		auto found = strings.find(str);
+		if (found != strings.end()){ return found->second; }
+		uint32_t offset = narrow(out.size());
+		out += str;
+		out.push_back('\0');
+		strings.emplace(str, offset);
+		return offset;
+	};
+
+	struct Record{
+		const IndexedSymbol * symbol;
+		uint32_t name;
+		uint32_t type;
+		uint32_t file;
+	};
+	std::vector<uint32_t> paths;
+	std::vector<Record> records;
+	for (const auto& file : myFiles){
+		uint32_t fileIndex = narrow(paths.size());
+		paths.push_back(intern(file.first));
+		for (const IndexedSymbol& symbol : file.second){
+			records.push_back(Record{&symbol, intern(symbol.name),
+				intern(symbol.type), fileIndex});
+		}
+	}
+	size_t stringsEnd = out.size();
+	std::stable_sort(records.begin(), records.end(),
+		[](const Record& a, const Record& b){
+			return a.symbol->name < b.symbol->name;
+		});
+
+	size_t filesStart = out.size();
+	for (uint32_t path : paths){ putU32(out, path); }
+
+	size_t symbolsStart = out.size();
+	size_t names = 0;
+	for (size_t i = 0; i < records.size(); i++){
+		const Record& rec = records[i];
+		putU32(out, rec.name);
+		putU32(out, rec.type);
+		putU32(out, rec.file);
+		putU32(out, narrow(rec.symbol->line));
+		putU32(out, narrow(rec.symbol->col));
+		putU32(out, static_cast<uint32_t>(rec.symbol->kind));
+		if (i == 0 || records[i - 1].name != rec.name){ names++; }
+	}
+
+	//At most half full, so probes stay short
+	size_t slotCount = 1;
+	while (slotCount < 2 * names){ slotCount *= 2; }
+	std::vector<uint32_t> slots(slotCount, 0);
+	for (size_t i = 0; i < records.size(); i++){
+		if (i > 0 && records[i - 1].name == records[i].name){ continue; }
+		const std::string& name = records[i].symbol->name;
+		size_t slot = SymbolIndexFormat::hash(name.data(), name.size())
+			& (slotCount - 1);
+		while (slots[slot] != 0){ slot = (slot + 1) & (slotCount - 1); }
+		slots[slot] = narrow(i + 1);
+	}
+	size_t tableStart = out.size();
+	for (uint32_t slot : slots){ putU32(out, slot); }
+
+	setU32(out, 12, narrow(out.size()));
+	setU32(out, 16, narrow(stringsStart));
+	setU32(out, 20, narrow(stringsEnd));
+	setU32(out, 24, narrow(paths.size()));
+	setU32(out, 28, narrow(filesStart));
+	setU32(out, 32, narrow(records.size()));
+	setU32(out, 36, narrow(symbolsStart));
+	setU32(out, 40, narrow(slotCount));
+	setU32(out, 44, narrow(tableStart));
+
+	//Written aside and renamed into place, so that a reader
+	// that has the old index mapped keeps a whole one
+	std::string temp = std::string(outPath) + ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		file.write(out.data(), static_cast<std::streamsize>(out.size()));
+		if (!file.good()){
+			file.close();
+			std::remove(temp.c_str());
+			std::string msg = "Bad output file ";
+			msg += outPath;
+			throw new InternalError(msg.c_str());
+		}
+	}
+	if (std::rename(temp.c_str(), outPath) != 0){
+		std::remove(temp.c_str());
+		std::string msg = "Bad output file ";
+		msg += outPath;
+		throw new InternalError(msg.c_str());
+	}
+}
+
+SymbolIndex * SymbolIndex::open(const char * path){
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0){
+		std::string msg = "Bad symbol index ";
+		msg += path;
+		throw new InternalError(msg.c_str());
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0
+	    || static_cast<size_t>(info.st_size) < SymbolIndexFormat::HEADER_SIZE){
+		::close(fd);
+		throw new InternalError("Truncated symbol index");
+	}
+	size_t size = static_cast<size_t>(info.st_size);
+	void * map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED){
+		throw new InternalError("Could not map symbol index");
+	}
+	try {
+		return new SymbolIndex(static_cast<const unsigned char *>(map), size);
+	} catch (...) {
+		munmap(map, size);
+		throw;
+	}
+}
+
+SymbolIndex::SymbolIndex(const unsigned char * base, size_t size)
+: myBase(base), mySize(size){
+	if (memcmp(myBase, SymbolIndexFormat::MAGIC,
+		sizeof(SymbolIndexFormat::MAGIC)) != 0){
+		corrupt();
+	}
+	if (u32(8) != SymbolIndexFormat::VERSION){
+		throw new InternalError("Unsupported symbol index version");
+	}
+	myStrings = u32(16);
+	myStringsEnd = u32(20);
+	myFileCount = u32(24);
+	myFiles = u32(28);
+	mySymbolCount = u32(32);
+	mySymbols = u32(36);
+	mySlotCount = u32(40);
+	myTable = u32(44);
+	//Every string ends in a NUL before the end of the
+	// strings, so reading one can't run off their end
+	if (u32(12) != mySize
+	    || myStrings > myStringsEnd || myStringsEnd > mySize
+	    || (myStringsEnd > myStrings && myBase[myStringsEnd - 1] != '\0')
+	    || myFiles + 4 * myFileCount > mySize
+	    || mySymbols + SymbolIndexFormat::RECORD_SIZE * mySymbolCount > mySize
+	    || mySlotCount == 0 || (mySlotCount & (mySlotCount - 1)) != 0
+	    || myTable + 4 * mySlotCount > mySize){
+		corrupt();
+	}
+}
+
+SymbolIndex::~SymbolIndex(){
+	munmap(const_cast<unsigned char *>(myBase), mySize);
+}
+
+void SymbolIndex::corrupt() const{
+	throw new InternalError("Corrupt symbol index");
+}
+
+uint32_t SymbolIndex::u32(size_t offset) const{
+	if (offset + 4 > mySize){ corrupt(); }
+	uint32_t val = 0;
+	for (size_t i = 0; i < 4; i++){
+		val |= static_cast<uint32_t>(myBase[offset + i]) << (8 * i);
+	}
+	return val;
+}
+
+const char * SymbolIndex::str(uint32_t offset) const{
+	if (offset < myStrings || offset >= myStringsEnd){ corrupt(); }
+	return reinterpret_cast<const char *>(myBase + offset);
+}
+
+size_t SymbolIndex::record(size_t index) const{
+	if (index >= mySymbolCount){
+		throw new InternalError("Symbol index entry out of range");
+	}
+	return mySymbols + SymbolIndexFormat::RECORD_SIZE * index;
+}
+
+const char * SymbolIndex::file(size_t index) const{
+	if (index >= myFileCount){ corrupt(); }
+	return str(u32(myFiles + 4 * index));
+}
+
+IndexedSymbol SymbolIndex::symbol(size_t index) const{
+	size_t rec = record(index);
+	uint32_t kind = u32(rec + 20);
+	if (kind > FN){ corrupt(); }
+	return IndexedSymbol{str(u32(rec)), static_cast<SymbolKind>(kind),
+		str(u32(rec + 4)), file(u32(rec + 8)), u32(rec + 12),
+		u32(rec + 16)};
+}
+
+bool SymbolIndex::find(const std::string& name, size_t& first,
+	size_t& count) const{
+	size_t mask = mySlotCount - 1;
+	size_t slot = SymbolIndexFormat::hash(name.data(), name.size()) & mask;
+	for (size_t probes = 0; probes < mySlotCount; probes++){
+		uint32_t entry = u32(myTable + 4 * slot);
+		if (entry == 0){ return false; }
+		size_t rec = record(entry - 1);
+		uint32_t atom = u32(rec);
+		if (strcmp(str(atom), name.c_str()) == 0){
+			first = entry - 1;
+			count = 1;
+			//Names are interned, so the same name is the
+			// same offset
+			while (first + count < mySymbolCount
+				&& u32(record(first + count)) == atom){
+				count++;
+			}
+			return true;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return false;
+}
+
+void SymbolIndex::addTo(SymbolIndexWriter& out) const{
+	std::vector<std::vector<IndexedSymbol>> files(myFileCount);
+	for (size_t i = 0; i < mySymbolCount; i++){
+		IndexedSymbol symbol = this->symbol(i);
+		files[u32(record(i) + 8)].push_back(std::move(symbol));
+	}
+	//Back in the order they were declared in
+	for (size_t i = 0; i < myFileCount; i++){
+		std::sort(files[i].begin(), files[i].end(),
+			[](const IndexedSymbol& a, const IndexedSymbol& b){
+				return a.line < b.line || (a.line == b.line && a.col < b.col);
+			});
+		out.addFile(file(i), files[i]);
+	}
+}
+
+}
@@ -0,0 +1,103 @@
+#ifndef HOLEYC_SYMBOL_INDEX_HPP
+#define HOLEYC_SYMBOL_INDEX_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "symbol_table.hpp"
+
+namespace holeyc{
+
+//A global symbol as the index records it
+struct IndexedSymbol{
+	std::string name;
+	SymbolKind kind;
+	//The type, as DataType::getString writes it
+	std::string type;
+	std::string file;
+	size_t line;
+	size_t col;
+};
+
+//The on-disk layout of a symbol index, which covers the
+// globals of one or many source files:
+//
+//  [header]   magic, version, and the counts and offsets
+//             below
+//  [strings]  every distinct name, type and path, each
+//             ending in a NUL. A string is known by its
+//             offset, so equal names are equal numbers.
+//  [files]    the path of each file
+//  [symbols]  one record per symbol: name, type, file
+//             index, line, col and kind, sorted by name
+//             (then file and position), so that the
+//             symbols of a name are next to each other
+//  [table]    an open-addressed hash table of the names,
+//             a power of two long: each slot is 0, or one
+//             more than the index of a name's first symbol
+//
+// All fields are little-endian uint32s. Looking a name up
+// hashes it and probes the table, touching only the pages
+// it needs of a mapped index.
+class SymbolIndexFormat{
+public:
+	static const char MAGIC[8];
+	static const uint32_t VERSION = 2;
+	static const size_t HEADER_SIZE = 48;
+	static const size_t RECORD_SIZE = 24;
+	//The hash of a name, which the table is laid out by
+	static uint32_t hash(const char * name, size_t len);
+};
+
+//Collects the symbols of source files (or of other indexes)
+// and writes them out as one index
+class SymbolIndexWriter{
+public:
+	//Add the symbols of a file, replacing any that were
+	// added for the same path before
+	void addFile(const std::string& path,
+		const std::vector<IndexedSymbol>& symbols);
+	void write(const char * outPath) const;
+private:
+	std::map<std::string, std::vector<IndexedSymbol>> myFiles;
+};
+
+//Reads a symbol index by memory-mapping it. Only the header
+// is checked when it is opened; records are bounds-checked
+// as they are read.
+class SymbolIndex{
+public:
+	static SymbolIndex * open(const char * path);
+	~SymbolIndex();
+	size_t fileCount() const { return myFileCount; }
+	size_t symbolCount() const { return mySymbolCount; }
+	const char * file(size_t index) const;
+	IndexedSymbol symbol(size_t index) const;
+	//The symbols called name, which are [first, first + count)
+	bool find(const std::string& name, size_t& first, size_t& count) const;
+	//Add every file of the index to out
+	void addTo(SymbolIndexWriter& out) const;
+private:
+	SymbolIndex(const unsigned char * base, size_t size);
+	uint32_t u32(size_t offset) const;
+	const char * str(uint32_t offset) const;
+	size_t record(size_t index) const;
+	void corrupt() const;
+
+	const unsigned char * myBase;
+	size_t mySize;
+	size_t myStrings;
+	size_t myStringsEnd;
+	size_t myFileCount;
+	size_t myFiles;
+	size_t mySymbolCount;
+	size_t mySymbols;
+	size_t mySlotCount;
+	size_t myTable;
+};
+
+}
+
+#endif
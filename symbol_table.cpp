@@ -3,20 +3,43 @@
 #include "types.hpp"
 namespace holeyc{
 
-SymbolTable::SymbolTable(){
-	scopeTableChain = new std::list<ScopeTable *>();
+SymbolTable::SymbolTable() : SymbolTable(PersistentScopeTable()){ }
+
+SymbolTable::SymbolTable(const PersistentScopeTable& baseIn)
+: base(baseIn), outerVersion(baseIn){
+	if (outerVersion.empty()){
+		outerVersion = outerVersion.enterScope();
+	}
+	bindings = new HashMap<std::string, BindingStack>();
+	scopeTableChain = new std::vector<ScopeTable *>();
+	symbols = new std::list<SemSymbol *>();
+	snapshots = new std::vector<PersistentScopeTable>();
+}
+
+SymbolTable::~SymbolTable(){
+	for (ScopeTable * scope : *scopeTableChain){
+		delete scope;
+	}
+	delete scopeTableChain;
+	delete bindings;
+	delete snapshots;
+	for (SemSymbol * symbol : *symbols){
+		delete symbol;
+	}
+	delete symbols;
 }
 
 void SymbolTable::print(){
-	for(auto scope : *scopeTableChain){
+	for (auto scope = scopeTableChain->rbegin(); 
+	     scope != scopeTableChain->rend(); ++scope){
 		std::cout << "--- scope ---\n";
-		std::cout << scope->toString();
+		std::cout << (*scope)->toString();
 	}
 }
 
 ScopeTable * SymbolTable::enterScope(){
-	ScopeTable * newScope = new ScopeTable();
-	scopeTableChain->push_front(newScope);
+	ScopeTable * newScope = new ScopeTable(scopeTableChain->size());
+	scopeTableChain->push_back(newScope);
 	return newScope;
 }
 
@@ -25,67 +48,113 @@ void SymbolTable::leaveScope(){
 		throw new InternalError("Attempt to pop"
 			"empty symbol table");
 	}
-	scopeTableChain->pop_front();
+	ScopeTable * scope = scopeTableChain->back();
+	scope->undo();
+	delete scope;
+	scopeTableChain->pop_back();
 }
 
 ScopeTable * SymbolTable::getCurrentScope(){
-	return scopeTableChain->front();
+	return scopeTableChain->back();
 }
 
-bool SymbolTable::clash(std::string varName){
-	bool hasClash = getCurrentScope()->clash(varName);
-	return hasClash;
+bool SymbolTable::clash(const std::string& varName){
+	auto found = bindings->find(varName);
+	size_t depth = getCurrentScope()->getDepth();
+	if (found == bindings->end() || found->second.empty()){
+		return depth == 0 && baseClash(varName);
+	}
+	return found->second.back().depth == depth;
 }
 
-SemSymbol * SymbolTable::find(std::string varName){
-	for (ScopeTable * scope : *scopeTableChain){
-		SemSymbol * sym = scope->lookup(varName);
-		if (sym != nullptr) { return sym; }
+SemSymbol * SymbolTable::find(const std::string& varName){
+	auto found = bindings->find(varName);
+	if (found == bindings->end() || found->second.empty()){
+		if (lookups != nullptr){ lookups->push_back(varName); }
+		if (globals){
+			SemSymbol * global = globals(varName);
+			if (global != nullptr){ return global; }
+		}
+		return base.lookup(varName);
 	}
-	return nullptr;
+	const Binding& binding = found->second.back();
+	if (lookups != nullptr && binding.depth == 0){ 
+		lookups->push_back(varName); 
+	}
+	return binding.symbol;
+}
+
+bool SymbolTable::baseClash(const std::string& name){
+	if (globals && globals(name) != nullptr){ return true; }
+	return base.clash(name);
+}
+
+void SymbolTable::adopt(SymbolTable * other){
+	symbols->splice(symbols->end(), *other->symbols);
 }
 
 bool SymbolTable::insert(SemSymbol * symbol){
-	return scopeTableChain->front()->insert(symbol);
+	ScopeTable * scope = getCurrentScope();
+	//Find-or-create the name's stack in one probe. Stacks
+	// emptied by leaveScope stay in the map for reuse.
+	BindingStack& stack = (*bindings)[symbol->getName()];
+	size_t depth = scope->getDepth();
+	bool clashes = stack.empty() ? depth == 0 && baseClash(symbol->getName())
+		: stack.back().depth == depth;
+	if (clashes){
+		delete symbol;
+		return false;
+	}
+	stack.push_back(Binding{depth, symbol});
+	scope->record(&stack, symbol);
+	symbols->push_back(symbol);
+	if (depth == 0){
+		outerVersion = outerVersion.insert(symbol);
+	}
+	return true;
 }
 
-ScopeTable::ScopeTable(){
-	symbols = new HashMap<std::string, SemSymbol *>();
+PersistentScopeTable PersistentScopeTable::enterScope() const {
+	return PersistentScopeTable(std::make_shared<const Scope>(
+		Scope{PersistentMap<SemSymbol *>(), myTop}));
 }
 
-std::string ScopeTable::toString(){
-	std::string result = "";
-	for (auto entry : *symbols){
-		result += entry.second->toString();
-		result += "\n";
+PersistentScopeTable PersistentScopeTable::insert(SemSymbol * symbol) const {
+	if (myTop == nullptr){
+		throw new InternalError("Insert into no scope");
 	}
-	return result;
+	return PersistentScopeTable(std::make_shared<const Scope>(
+		Scope{myTop->symbols.insert(symbol->getName(), symbol), 
+		myTop->parent}));
 }
 
-bool ScopeTable::clash(std::string varName){
-	SemSymbol * found = lookup(varName);
-	if (found != nullptr){
-		return true;
+SemSymbol * PersistentScopeTable::lookup(const std::string& name) const {
+	for (const Scope * scope = myTop.get(); scope != nullptr; 
+	     scope = scope->parent.get()){
+		SemSymbol * const * found = scope->symbols.find(name);
+		if (found != nullptr){ return *found; }
 	}
-	return false;
+	return nullptr;
 }
 
-SemSymbol * ScopeTable::lookup(std::string name){
-	auto found = symbols->find(name);
-	if (found == symbols->end()){
-		return NULL;
+bool PersistentScopeTable::clash(const std::string& name) const {
+	return myTop != nullptr && myTop->symbols.find(name) != nullptr;
+}
+
+void ScopeTable::undo(){
+	for (auto pushed : myPushed){
+		pushed.first->pop_back();
 	}
-	return found->second;
+	myPushed.clear();
 }
 
-bool ScopeTable::insert(SemSymbol * symbol){
-	std::string symName = symbol->getName();
-	bool alreadyInScope = (this->lookup(symName) != NULL);
-	if (alreadyInScope){
-		return false;
+std::string ScopeTable::toString(){
+	std::string result = "";
+	for (auto pushed : myPushed){
+		result += pushed.second->toString();
+		result += "\n";
 	}
-	this->symbols->insert(std::make_pair(symName, symbol));
-	return true;
+	return result;
 }
 
 std::string SemSymbol::toString(){
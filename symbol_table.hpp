@@ -1,9 +1,13 @@
 #ifndef HOLEYC_SYMBOL_TABLE_HPP
 #define HOLEYC_SYMBOL_TABLE_HPP
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <list>
+#include <memory>
+#include <vector>
 #include "types.hpp"
+#include "hamt.hpp"
 
 //Use an alias template so that we can use
 // "HashMap" and it means "std::unordered_map"
@@ -26,10 +30,11 @@ enum SymbolKind {
 // symbol table. 
 class SemSymbol {
 public:
-	SemSymbol(std::string nameIn, DataType * typeIn) 
+	SemSymbol(const std::string& nameIn, DataType * typeIn) 
 	: myName(nameIn), myType(typeIn){ }
+	virtual ~SemSymbol(){ }
 	virtual std::string toString();
-	std::string getName() const { return myName; }
+	const std::string& getName() const { return myName; }
 	virtual SymbolKind getKind() const = 0;
 
 	virtual DataType * getDataType() const{
@@ -49,60 +54,144 @@ private:
 
 class VarSymbol : public SemSymbol {
 public:
-	VarSymbol(std::string name, DataType * type) 
+	VarSymbol(const std::string& name, DataType * type) 
 	: SemSymbol(name, type) { }
 	virtual SymbolKind getKind() const override { return VAR; } 
 };
 
 class FnSymbol : public SemSymbol{
 public:
-	FnSymbol(std::string name, FnType * fnType)
+	FnSymbol(const std::string& name, FnType * fnType)
 	: SemSymbol(name, fnType){ }
 	virtual SymbolKind getKind() const { return FN; }
 	SymbolKind getKind(){ return FN; } 
 };
 
-//A single scope. The symbol table is broken down into a 
-// chain of scope tables, and each scope table holds 
-// semantic symbols for a single scope. For example,
-// the globals scope will be represented by a ScopeTable,
-// and the contents of each function can be represented by
-// a ScopeTable.
+//One declaration of a name: the symbol and the nesting
+// depth of the scope that declared it
+struct Binding {
+	size_t depth;
+	SemSymbol * symbol;
+};
+
+//Every visible declaration of a name, innermost last
+using BindingStack = std::vector<Binding>;
+
+//A single scope. The symbols themselves live in the 
+// SymbolTable's name map; a ScopeTable is the undo log of 
+// the bindings its scope pushed, so that leaving the scope
+// can pop them without hashing any names. A ScopeTable does
+// not own the symbols in it: AST nodes keep pointing at 
+// symbols after their scope has been left, so the symbols 
+// live as long as the SymbolTable that created them.
 class ScopeTable {
 	public:
-		ScopeTable();
-		SemSymbol * lookup(std::string name);
-		bool insert(SemSymbol * symbol);
-		bool clash(std::string name);
-		std::string toString();
-		void addVar(std::string name, DataType * type){
-			insert(new VarSymbol(name, type));
-		}
-		void addFn(std::string name, FnType * type){
-			insert(new FnSymbol(name, type));
+		ScopeTable(size_t depthIn) : myDepth(depthIn){ }
+		size_t getDepth() const { return myDepth; }
+		void record(BindingStack * stack, SemSymbol * symbol){
+			myPushed.push_back(std::make_pair(stack, symbol));
 		}
+		//Pop every binding this scope pushed
+		void undo();
+		std::string toString();
 	private:
-		HashMap<std::string, SemSymbol *> * symbols;
+		size_t myDepth;
+		std::vector<std::pair<BindingStack *, SemSymbol *>> myPushed;
 };
 
+//An immutable version of a chain of scopes, for keeping the
+// state of the symbol table at some point of the analysis 
+// (e.g. before each top-level declaration) without copying
+// it. Each scope is a PersistentMap, so enterScope and insert
+// return new versions in O(log n) and every older version
+// stays valid. Like ScopeTable, it does not own its symbols.
+class PersistentScopeTable {
+	public:
+		PersistentScopeTable() : myTop(nullptr){ }
+		bool empty() const { return myTop == nullptr; }
+		PersistentScopeTable enterScope() const;
+		PersistentScopeTable insert(SemSymbol * symbol) const;
+		SemSymbol * lookup(const std::string& name) const;
+		//Is name bound in the innermost scope?
+		bool clash(const std::string& name) const;
+	private:
+		struct Scope{
+			PersistentMap<SemSymbol *> symbols;
+			std::shared_ptr<const Scope> parent;
+		};
+		PersistentScopeTable(std::shared_ptr<const Scope> top)
+		: myTop(top){ }
+		std::shared_ptr<const Scope> myTop;
+};
+
+//The symbol table is a single map from each name to the 
+// stack of its visible bindings, plus a chain of scopes 
+// recording what to pop on exit. Looking a name up is one
+// hash probe regardless of how deeply scopes are nested.
 class SymbolTable{
 	public:
 		SymbolTable();
+		//Resume from a snapshot: the first scope entered
+		// reopens the snapshot's innermost scope, and its 
+		// outer scopes enclose everything. The symbols in the
+		// snapshot stay owned by the table they came from.
+		SymbolTable(const PersistentScopeTable& base);
+		~SymbolTable();
 		ScopeTable * enterScope();
 		void leaveScope();
 		ScopeTable * getCurrentScope();
+		//Takes ownership of the symbol, even if it clashes
+		// (in which case it is deleted and false returned)
 		bool insert(SemSymbol * symbol);
-		SemSymbol * find(std::string varName);
-		bool clash(std::string name);
-		void addVar(std::string name, DataType * type){
-			getCurrentScope()->addVar(name, type);
+		SemSymbol * find(const std::string& varName);
+		bool clash(const std::string& name);
+		bool addVar(const std::string& name, DataType * type){
+			return insert(new VarSymbol(name, type));
+		}
+		bool addFn(const std::string& name, FnType * type){
+			return insert(new FnSymbol(name, type));
+		}
+		//Record the current state of the outermost scope 
+		// (ProgramNode takes one before every top-level 
+		// declaration, and one at the end)
+		void takeSnapshot(){ snapshots->push_back(outerVersion); }
+		const PersistentScopeTable& getSnapshot(size_t index) const {
+			return snapshots->at(index);
+		}
+		size_t snapshotCount() const { return snapshots->size(); }
+		//Take over ownership of other's symbols
+		void adopt(SymbolTable * other);
+		//While set, the name of every find that is not 
+		// answered by a nested scope (i.e. that finds a 
+		// global, or nothing) is appended to into
+		void logLookups(std::vector<std::string> * into){
+			lookups = into;
 		}
-		void addFn(std::string name, FnType * type){
-			getCurrentScope()->addFn(name, type);
+		//Have resolver stand in for the globals declared 
+		// before the outermost scope: names nothing else 
+		// binds are looked up with it before the base, and
+		// a global clashes with the names it finds
+		void resolveGlobals(
+			std::function<SemSymbol *(const std::string&)> resolver){
+			globals = resolver;
 		}
 		void print();
 	private:
-		std::list<ScopeTable *> * scopeTableChain;
+		PersistentScopeTable base;
+		//The persistent twin of the outermost scope
+		PersistentScopeTable outerVersion;
+		std::vector<PersistentScopeTable> * snapshots;
+		//Nodes of an unordered_map are never moved, so scopes
+		// can keep pointers to the stacks across rehashes
+		HashMap<std::string, BindingStack> * bindings;
+		std::vector<ScopeTable *> * scopeTableChain;
+		//Every symbol ever inserted, freed with the table
+		std::list<SemSymbol *> * symbols;
+		std::vector<std::string> * lookups = nullptr;
+		std::function<SemSymbol *(const std::string&)> globals;
+		//Is name a global the resolver knows, or bound in the
+		// base's innermost scope?
+		bool baseClash(const std::string& name);
 };
 
 	
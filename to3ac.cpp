@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <iterator>
+
+#include "ast.hpp"
+#include "3ac.hpp"
+#include "errors.hpp"
+#include "prelude.hpp"
+#include "symbol_table.hpp"
+#include "types.hpp"
+
+namespace holeyc{
+
+IRProgram * ProgramNode::to3AC(TypeAnalysis * ta){
+	IRProgram * prog = new IRProgram(ta);
+	//Every global is known before any procedure names its
+	// variables, so that none is named like one
+	for (auto global : *myGlobals){
+		if (dynamic_cast<VarDeclNode *>(global) != nullptr){
+			global->to3ACGlobal(prog);
+		}
+	}
+	for (auto global : *myGlobals){
+		if (dynamic_cast<VarDeclNode *>(global) == nullptr){
+			global->to3ACGlobal(prog);
+		}
+	}
+	//The prelude functions called, and those they call, are
+	// lowered after the program's own, each once. Their
+	// ASTs are shared, so they are lowered as written.
+	std::set<const SemSymbol *> lowered;
+	for (size_t i = 0; i < prog->getProcs().size(); i++){
+		Procedure * caller = prog->getProcs()[i].get();
+		for (const auto& quad : caller->getQuads()){
+			CallQuad * call = dynamic_cast<CallQuad *>(quad.get());
+			if (call == nullptr){ continue; }
+			FnDeclNode * callee = Prelude::fnDecl(call->getCallee());
+			if (callee == nullptr || !lowered.insert(call->getCallee()).second){
+				continue;
+			}
+			callee->to3ACProc(prog->makeProc(call->getCallee(),
+				Prelude::types()));
+		}
+	}
+	return prog;
+}
+
+void FnDeclNode::to3ACGlobal(IRProgram * prog){
+	to3ACProc(prog->makeProc(myID->getSymbol()));
+}
+
+void FnDeclNode::to3ACProc(Procedure * proc){
+	for (auto formal : *myFormals){
+		formal->to3AC(proc);
+	}
+	for (auto stmt : *myBody){
+		stmt->to3AC(proc);
+	}
+	proc->finish();
+}
+
+void FnDeclNode::to3AC(Procedure * proc){
+	throw new InternalError("Function declared inside a function");
+}
+
+void VarDeclNode::to3ACGlobal(IRProgram * prog){
+	prog->gatherGlobal(ID()->getSymbol());
+}
+
+void VarDeclNode::to3AC(Procedure * proc){
+	proc->gatherLocal(ID()->getSymbol());
+}
+
+void FormalDeclNode::to3AC(Procedure * proc){
+	SymOpd * opd = proc->gatherFormal(ID()->getSymbol());
+	proc->addQuad(new GetArgQuad(proc->getFormals().size(), opd));
+}
+
+void AssignStmtNode::to3AC(Procedure * proc){
+	myExp->flatten(proc);
+}
+
+void FromConsoleStmtNode::to3AC(Procedure * proc){
+	const DataType * type = proc->nodeType(myDst);
+	Opd * tmp = proc->makeTmp(Opd::width(type));
+	proc->addQuad(new ReadQuad(tmp, type));
+	myDst->store(proc, tmp);
+}
+
+void ToConsoleStmtNode::to3AC(Procedure * proc){
+	Opd * src = mySrc->flatten(proc);
+	proc->addQuad(new WriteQuad(src, proc->nodeType(mySrc)));
+}
+
+//x++ and x-- as x := x op 1
+static void step(Procedure * proc, LValNode * lval, OpKind op){
+	Opd * val = lval->flatten(proc);
+	Opd * tmp = proc->makeTmp(val->getWidth());
+	Opd * one = proc->getProg()->makeLit("1", val->getWidth());
+	proc->addQuad(new BinOpQuad(tmp, op, val, one));
+	lval->store(proc, tmp);
+}
+
+void PostIncStmtNode::to3AC(Procedure * proc){
+	step(proc, myLVal, PLUS_OP);
+}
+
+void PostDecStmtNode::to3AC(Procedure * proc){
+	step(proc, myLVal, MINUS_OP);
+}
+
+void IfStmtNode::to3AC(Procedure * proc){
+	Label * after = proc->makeLabel();
+	Opd * cond = myCond->flatten(proc);
+	proc->addQuad(new JmpIfQuad(cond, after));
+	for (auto stmt : *myBody){
+		stmt->to3AC(proc);
+	}
+	proc->addLabel(after);
+}
+
+void IfElseStmtNode::to3AC(Procedure * proc){
+	Label * elseLbl = proc->makeLabel();
+	Label * after = proc->makeLabel();
+	Opd * cond = myCond->flatten(proc);
+	proc->addQuad(new JmpIfQuad(cond, elseLbl));
+	for (auto stmt : *myBodyTrue){
+		stmt->to3AC(proc);
+	}
+	proc->addQuad(new JmpQuad(after));
+	proc->addLabel(elseLbl);
+	for (auto stmt : *myBodyFalse){
+		stmt->to3AC(proc);
+	}
+	proc->addLabel(after);
+}
+
+void WhileStmtNode::to3AC(Procedure * proc){
+	Label * head = proc->makeLabel();
+	Label * after = proc->makeLabel();
+	proc->addLabel(head);
+	Opd * cond = myCond->flatten(proc);
+	proc->addQuad(new JmpIfQuad(cond, after));
+	for (auto stmt : *myBody){
+		stmt->to3AC(proc);
+	}
+	proc->addQuad(new JmpQuad(head));
+	proc->addLabel(after);
+}
+
+void ReturnStmtNode::to3AC(Procedure * proc){
+	if (myExp != nullptr){
+		proc->addQuad(new SetRetQuad(myExp->flatten(proc)));
+	}
+	proc->addQuad(new JmpQuad(proc->getLeaveLabel()));
+}
+
+void CallStmtNode::to3AC(Procedure * proc){
+	myCallExp->flatten(proc);
+}
+
+//The operand of a variable is where it is, not its value:
+// if what is evaluated after it may change it (a call, or an
+// assignment), its value is copied out first
+static Opd * valueBefore(Procedure * proc, Opd * opd, bool changes){
+	if (!changes || dynamic_cast<SymOpd *>(opd) == nullptr){
+		return opd;
+	}
+	Opd * tmp = proc->makeTmp(opd->getWidth());
+	proc->addQuad(new AssignQuad(tmp, opd));
+	return tmp;
+}
+
+Opd * CallExpNode::flatten(Procedure * proc){
+	//Every argument is evaluated before any is passed, so
+	// calls among the arguments don't clobber them
+	std::vector<Opd *> args;
+	for (auto arg = myArgs->begin(); arg != myArgs->end(); ++arg){
+		bool changes = std::any_of(std::next(arg), myArgs->end(),
+			[](const ExpNode * later){ return later->hasEffects(); });
+		args.push_back(valueBefore(proc, (*arg)->flatten(proc), changes));
+	}
+	for (size_t i = 0; i < args.size(); i++){
+		proc->addQuad(new SetArgQuad(i + 1, args[i]));
+	}
+	SemSymbol * callee = myID->getSymbol();
+	proc->addQuad(new CallQuad(callee));
+	const DataType * retType = callee->getDataType()->asFn()->getReturnType();
+	if (retType->isVoid()){
+		return nullptr;
+	}
+	Opd * res = proc->makeTmp(Opd::width(retType));
+	proc->addQuad(new GetRetQuad(res));
+	return res;
+}
+
+Opd * BinaryExpNode::flatten(Procedure * proc){
+	Opd * lhs = valueBefore(proc, myExp1->flatten(proc),
+		myExp2->hasEffects());
+	Opd * rhs = myExp2->flatten(proc);
+	Opd * res = proc->makeTmp(Opd::width(proc->nodeType(this)));
+	proc->addQuad(new BinOpQuad(res, getOp(), lhs, rhs));
+	return res;
+}
+
+//The right operand of && and || is only evaluated when the
+// left one doesn't decide the result
+Opd * AndNode::flatten(Procedure * proc){
+	Label * after = proc->makeLabel();
+	Opd * res = proc->makeTmp(BYTE);
+	proc->addQuad(new AssignQuad(res, myExp1->flatten(proc)));
+	proc->addQuad(new JmpIfQuad(res, after));
+	proc->addQuad(new AssignQuad(res, myExp2->flatten(proc)));
+	proc->addLabel(after);
+	return res;
+}
+
+Opd * OrNode::flatten(Procedure * proc){
+	Label * rhs = proc->makeLabel();
+	Label * after = proc->makeLabel();
+	Opd * res = proc->makeTmp(BYTE);
+	proc->addQuad(new AssignQuad(res, myExp1->flatten(proc)));
+	proc->addQuad(new JmpIfQuad(res, rhs));
+	proc->addQuad(new JmpQuad(after));
+	proc->addLabel(rhs);
+	proc->addQuad(new AssignQuad(res, myExp2->flatten(proc)));
+	proc->addLabel(after);
+	return res;
+}
+
+Opd * UnaryExpNode::flatten(Procedure * proc){
+	Opd * src = myExp->flatten(proc);
+	Opd * res = proc->makeTmp(src->getWidth());
+	proc->addQuad(new UnaryOpQuad(res, getOp(), src));
+	return res;
+}
+
+Opd * AssignExpNode::flatten(Procedure * proc){
+	Opd * src = mySrc->flatten(proc);
+	myDst->store(proc, src);
+	return src;
+}
+
+Opd * IDNode::flatten(Procedure * proc){
+	if (mySymbol == nullptr){
+		throw new InternalError("Unbound name in 3AC");
+	}
+	return proc->getSymOpd(mySymbol);
+}
+
+void IDNode::store(Procedure * proc, Opd * src){
+	proc->addQuad(new AssignQuad(flatten(proc), src));
+}
+
+Opd * RefNode::flatten(Procedure * proc){
+	SymOpd * var = proc->getSymOpd(myID->getSymbol());
+	proc->getProg()->addressTaken(var);
+	Opd * res = proc->makeTmp(ADDR);
+	proc->addQuad(new AddrQuad(res, var));
+	return res;
+}
+
+void RefNode::store(Procedure * proc, Opd * src){
+	throw new InternalError("Assignment to an address");
+}
+
+//The width of what the pointer id points to
+static OpdWidth pointeeWidth(IDNode * id){
+	const DataType * pointee =
+		PtrType::derefType(id->getSymbol()->getDataType());
+	if (pointee == nullptr || pointee->asError()){
+		throw new InternalError("Dereference of a non-pointer in 3AC");
+	}
+	return Opd::width(pointee);
+}
+
+Opd * DerefNode::flatten(Procedure * proc){
+	Opd * addr = myID->flatten(proc);
+	Opd * res = proc->makeTmp(pointeeWidth(myID));
+	proc->addQuad(new LoadQuad(res, addr));
+	return res;
+}
+
+void DerefNode::store(Procedure * proc, Opd * src){
+	proc->addQuad(new StoreQuad(myID->flatten(proc), src));
+}
+
+//base + offset * (the size of an element)
+static Opd * elementAddr(Procedure * proc, IDNode * base, ExpNode * offset){
+	Opd * baseOpd = base->flatten(proc);
+	Opd * offOpd = offset->flatten(proc);
+	size_t size = Opd::bytes(pointeeWidth(base));
+	if (size != 1){
+		Opd * scaled = proc->makeTmp(QUADWORD);
+		Opd * sizeOpd = proc->getProg()->makeLit(std::to_string(size),
+			QUADWORD);
+		proc->addQuad(new BinOpQuad(scaled, TIMES_OP, offOpd, sizeOpd));
+		offOpd = scaled;
+	}
+	Opd * addr = proc->makeTmp(ADDR);
+	proc->addQuad(new BinOpQuad(addr, PLUS_OP, baseOpd, offOpd));
+	return addr;
+}
+
+Opd * IndexNode::flatten(Procedure * proc){
+	Opd * addr = elementAddr(proc, myBase, myOffset);
+	Opd * res = proc->makeTmp(pointeeWidth(myBase));
+	proc->addQuad(new LoadQuad(res, addr));
+	return res;
+}
+
+void IndexNode::store(Procedure * proc, Opd * src){
+	proc->addQuad(new StoreQuad(elementAddr(proc, myBase, myOffset), src));
+}
+
+Opd * IntLitNode::flatten(Procedure * proc){
+	return proc->getProg()->makeLit(std::to_string(myNum), QUADWORD);
+}
+
+Opd * StrLitNode::flatten(Procedure * proc){
+	return proc->getProg()->makeString(myStr);
+}
+
+Opd * CharLitNode::flatten(Procedure * proc){
+	return proc->getProg()->makeLit(std::to_string(static_cast<int>(myVal)),
+		BYTE);
+}
+
+Opd * NullPtrNode::flatten(Procedure * proc){
+	return proc->getProg()->makeLit("0", ADDR);
+}
+
+Opd * TrueNode::flatten(Procedure * proc){
+	return proc->getProg()->makeLit("1", BYTE);
+}
+
+Opd * FalseNode::flatten(Procedure * proc){
+	return proc->getProg()->makeLit("0", BYTE);
+}
+
+}
@@ -60,8 +60,28 @@ static std::string tokenKindString(int tokKind){
 	
 }
 
+static thread_local TokenArena * currentArena = nullptr;
+
+TokenArena::TokenArena() : myOuter(currentArena){
+	currentArena = this;
+}
+
+TokenArena::~TokenArena(){
+	for (Token * token : myTokens){
+		delete token;
+	}
+	currentArena = myOuter;
+}
+
+TokenArena * TokenArena::current(){
+	return currentArena;
+}
+
 Token::Token(size_t lineIn, size_t columnIn, int kindIn)
   : myLine(lineIn), myCol(columnIn), myKind(kindIn){
+	if (currentArena != nullptr){
+		currentArena->adopt(this);
+	}
 }
 
 std::string Token::toString(){
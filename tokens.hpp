@@ -2,12 +2,32 @@
 #define HOLYC_TOKEN_H
 
 #include <string>
+#include <vector>
 
 namespace holeyc{
 
+class Token;
+
+//Owns every token constructed on its thread while it is 
+// the innermost live arena. The scanner holds one, so tokens
+// (which the parser only copies values out of) are freed
+// along with the scanner that produced them. Tokens are 
+// always heap-allocated by the scanner.
+class TokenArena{
+public:
+	TokenArena();
+	~TokenArena();
+	void adopt(Token * token){ myTokens.push_back(token); }
+	static TokenArena * current();
+private:
+	TokenArena * myOuter;
+	std::vector<Token *> myTokens;
+};
+
 class Token{
 public:
 	Token(size_t lineIn, size_t columnIn, int kindIn);
+	virtual ~Token(){ }
 	virtual std::string toString();
 	size_t line() const;
 	size_t col() const;
@@ -4,6 +4,10 @@
 #include "types.hpp"
 #include "name_analysis.hpp"
 #include "type_analysis.hpp"
+#include "parallel.hpp"
+#include "fn_cache.hpp"
+#include <exception>
+#include <vector>
 
 namespace holeyc{
 
@@ -12,11 +16,22 @@ TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis){
 	// being complete, a name analysis must be supplied for 
 	// type analysis to be performed.
 	TypeAnalysis * typeAnalysis = new TypeAnalysis();
+	typeAnalysis->nameAnalysis = nameAnalysis;
 	auto ast = nameAnalysis->ast;	
 	typeAnalysis->ast = ast;
+	typeAnalysis->firstNodeID = ast->getFirstNodeID();
+	typeAnalysis->nodeToType.assign(ast->getNodeCount(), nullptr);
 
-	ast->typeAnalysis(typeAnalysis);
+	//The analysis owns the name analysis, and through it the
+	// tree, so all of them are freed if a pass throws
+	try {
+		ast->typeAnalysis(typeAnalysis);
+	} catch (...) {
+		delete typeAnalysis;
+		throw;
+	}
 	if (typeAnalysis->hasError){
+		delete typeAnalysis;
 		return nullptr;
 	}
 
@@ -24,14 +39,62 @@ TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis){
 
 }
 
-void ProgramNode::typeAnalysis(TypeAnalysis * ta){
+TypeAnalysis * TypeAnalysis::blank(ProgramNode * ast){
+	TypeAnalysis * typeAnalysis = new TypeAnalysis();
+	typeAnalysis->ast = ast;
+	typeAnalysis->firstNodeID = ast->getFirstNodeID();
+	typeAnalysis->nodeToType.assign(ast->getNodeCount(), nullptr);
+	return typeAnalysis;
+}
+
+TypeAnalysis * TypeAnalysis::buildFused(ProgramNode * ast,
+	FnCache * cache){
+	TypeAnalysis * typeAnalysis = blank(ast);
 
-	//pass the TypeAnalysis down throughout
-	// the entire tree, getting the types for
-	// each element in turn and adding them
-	// to the ta object's hashMap
-	for (auto global : *myGlobals){
-		global->typeAnalysis(ta);
+	bool namesOK = false;
+	try {
+		typeAnalysis->nameAnalysis = NameAnalysis::buildFused(ast, 
+			typeAnalysis, namesOK, cache);
+	} catch (...) {
+		//The name analysis has freed the tree
+		delete typeAnalysis;
+		throw;
+	}
+	if (!namesOK || typeAnalysis->hasError){
+		delete typeAnalysis;
+		return nullptr;
+	}
+	return typeAnalysis;
+}
+
+TypeAnalysis::~TypeAnalysis(){
+	delete nameAnalysis;
+}
+
+TypeAnalysis * TypeAnalysis::worker(){
+	TypeAnalysis * worker = new TypeAnalysis();
+	worker->table = table;
+	worker->firstNodeID = firstNodeID;
+	worker->ast = ast;
+	return worker;
+}
+
+void TypeAnalysis::join(TypeAnalysis * worker){
+	hasError = hasError || worker->hasError;
+	delete worker;
+}
+
+void ProgramNode::typeAnalysis(TypeAnalysis * ta){
+	if (Parallel::jobs() > 1 && myGlobals->size() > 1){
+		typeAnalysisParallel(ta);
+	} else {
+		//pass the TypeAnalysis down throughout
+		// the entire tree, getting the types for
+		// each element in turn and adding them
+		// to the ta object's table
+		for (auto global : *myGlobals){
+			global->typeAnalysis(ta);
+		}
 	}
 
 	//The type of the program node will never
@@ -41,18 +104,162 @@ void ProgramNode::typeAnalysis(TypeAnalysis * ta){
 	ta->nodeType(this, BasicType::produce(VOID));
 }
 
-void FnDeclNode::typeAnalysis(TypeAnalysis * ta){ 
-	DataType * ret_type = this->getRetTypeNode()->getType();
+static bool anyFatal(const std::vector<Diagnostic>& diags){
+	for (const Diagnostic& diag : diags){
+		if (diag.severity == Diagnostic::FATAL){ return true; }
+	}
+	return false;
+}
+
+//fusedAnalysis of one function, through the cache. The 
+// declaration itself is always analysed afresh, as whether
+// its name clashes depends on the rest of the program. The
+// body's results are replayed if the cache has them, and
+// otherwise found and kept. To keep a whole result, the 
+// function is type-checked even where fusedAnalysis would
+// have stopped (namesSoFar false, or typeFailure set), but 
+// its type errors are only reported where it would not.
+static bool cachedFnAnalysis(FnCache * cache, size_t index, 
+	DeclNode * decl, SymbolTable * symTab, TypeAnalysis * ta,
+	bool namesSoFar, DiagBuffer& typeErrs, 
+	std::exception_ptr& typeFailure){
+	bool declOK = decl->nameAnalysisDecl(symTab);
+	const FnResult * hit = cache->find(index, symTab);
+	if (hit != nullptr){
+		FnCache::replay(hit->nameDiags, decl->line(), Report::buffer());
+		bool namesOK = declOK && hit->namesOK;
+		if (namesSoFar && namesOK && !typeFailure){
+			FnCache::replay(hit->typeDiags, decl->line(), typeErrs);
+			ta->replayed(anyFatal(hit->typeDiags));
+		}
+		return namesOK;
+	}
+
+	FnResult result;
+	DiagBuffer nameErrs;
+	symTab->logLookups(&result.deps);
+	DiagBuffer * prev = Report::redirect(&nameErrs);
+	result.namesOK = decl->nameAnalysisBody(symTab);
+	Report::redirect(prev);
+	symTab->logLookups(nullptr);
+	result.nameDiags = nameErrs.diagnostics();
+	Report::buffer().append(nameErrs);
+	if (!result.namesOK){
+		//The type errors of such a body are never reported
+		cache->store(index, decl->line(), std::move(result), symTab);
+		return false;
+	}
+	//Without its own symbol the function can't be checked
+	if (!declOK){ return false; }
+
+	DiagBuffer fnTypeErrs;
+	std::exception_ptr failure;
+	prev = Report::redirect(&fnTypeErrs);
+	try {
+		decl->typeAnalysis(ta);
+	} catch (...) {
+		failure = std::current_exception();
+	}
+	Report::redirect(prev);
+	if (!failure){
+		result.typeDiags = fnTypeErrs.diagnostics();
+		cache->store(index, decl->line(), std::move(result), symTab);
+	}
+	if (namesSoFar && !typeFailure){
+		typeErrs.append(fnTypeErrs);
+		typeFailure = failure;
+	}
+	return true;
+}
+
+//Each declaration is type-checked while its nodes are still
+// fresh from name analysis. The type checker needs every
+// name bound, so it stops at the first declaration with a
+// name error. Its diagnostics are held back until the name
+// errors of the whole program are out, and dropped if there
+// were any, as the two separate passes would. So is an 
+// exception, which also ends the type checking.
+bool ProgramNode::fusedAnalysis(SymbolTable * symTab, 
+	TypeAnalysis * ta, FnCache * cache){
+	DiagBuffer typeErrs;
+	std::exception_ptr typeFailure;
+	bool res = true;
+	symTab->enterScope();
+	size_t index = 0;
+	for (auto decl : *myGlobals){
+		symTab->takeSnapshot();
+		if (cache != nullptr && cache->covers(index)){
+			res = cachedFnAnalysis(cache, index, decl, symTab, ta, 
+				res, typeErrs, typeFailure) && res;
+			index++;
+			continue;
+		}
+		index++;
+		res = decl->nameAnalysis(symTab) && res;
+		if (!res || typeFailure){ continue; }
+		DiagBuffer * prev = Report::redirect(&typeErrs);
+		try {
+			decl->typeAnalysis(ta);
+		} catch (...) {
+			typeFailure = std::current_exception();
+		}
+		Report::redirect(prev);
+	}
+	symTab->takeSnapshot();
+	symTab->leaveScope();
+	if (!res){ return false; }
+
+	Report::buffer().append(typeErrs);
+	if (typeFailure){ std::rethrow_exception(typeFailure); }
+	ta->nodeType(this, BasicType::produce(VOID));
+	return true;
+}
 
-	std::list<const DataType*>* temp = new std::list<const DataType*>();
-	for (auto decl : *myFormals){
-		auto dt = decl->getTypeNode()->getType();
-		const DataType *dt_const = const_cast<DataType*>(dt);
-		temp->push_back(dt_const);
+//Name analysis has already bound every name to its symbol,
+// and so its type, so no declaration depends on another
+// while being checked. Each one gets a worker context of
+// its own; diagnostics are buffered per declaration and
+// written in source order once all of them are done.
+void ProgramNode::typeAnalysisParallel(TypeAnalysis * ta){
+	std::vector<DeclNode *> decls(myGlobals->begin(), myGlobals->end());
+	size_t count = decls.size();
+	std::vector<DiagBuffer> errs(count);
+	std::vector<TypeAnalysis *> workers(count, nullptr);
+	for (size_t i = 0; i < count; i++){
+		workers[i] = ta->worker();
 	}
 
-    const std::list<const DataType*>* formals_list = const_cast<std::list<const DataType*>*>(temp);
-	FnType *fn_type = new FnType(formals_list, ret_type);
+	//A declaration that throws keeps the others going, so 
+	// that the diagnostics before it are all there when its
+	// exception is rethrown, as the serial pass would
+	std::vector<std::exception_ptr> failures(count);
+	Parallel::forEach(count, [&](size_t i){
+		DiagBuffer * prev = Report::redirect(&errs[i]);
+		try {
+			decls[i]->typeAnalysis(workers[i]);
+		} catch (...) {
+			failures[i] = std::current_exception();
+		}
+		Report::redirect(prev);
+	});
+
+	for (size_t i = 0; i < count; i++){
+		Report::buffer().append(errs[i]);
+		if (failures[i]){
+			for (size_t j = i; j < count; j++){ delete workers[j]; }
+			std::rethrow_exception(failures[i]);
+		}
+		ta->join(workers[i]);
+	}
+}
+
+void FnDeclNode::typeAnalysis(TypeAnalysis * ta){ 
+	SemSymbol * sym = ID()->getSymbol();
+	const FnType * fn_type = sym == nullptr ? nullptr 
+		: sym->getDataType()->asFn();
+	if (fn_type == nullptr){
+		throw new InternalError("Function has no type");
+	}
 
 	ta->setCurrentFnType(fn_type);
 	ta->nodeType(this,fn_type);
@@ -171,6 +378,9 @@ void FalseNode::typeAnalysis(TypeAnalysis * ta){
 }
 
 void CallExpNode::typeAnalysis(TypeAnalysis * ta){
+	for (auto arg : *myArgs){
+		arg->typeAnalysis(ta);
+	}
 	
 	auto myFn = myID->getSymbol()->getDataType()->asFn();
 	if (myFn == nullptr){
@@ -178,280 +388,121 @@ void CallExpNode::typeAnalysis(TypeAnalysis * ta){
 		ta->nodeType(this, ErrorType::produce());
 		return;
 	}
-	auto myFrmls = myFn->getFormalTypes();
-	if (myArgs->size() != myFrmls->size()){
+	const auto& myFrmls = myFn->getFormalTypes();
+	if (myArgs->size() != myFrmls.size()){
 		ta->badCallee(myID->line(), myID->col());
 		ta->nodeType(this, ErrorType::produce());
 		return;
 	}
 	
+	size_t argIdx = 0;
 	for (auto arg : *myArgs){
-		if (ta->nodeType(arg) != myFrmls->front()){
-			ta->badCallee(arg->line(), arg->col());
+		const DataType * argType = ta->nodeType(arg);
+		if (argType->asError()){
+			//Already reported
 			ta->nodeType(this, ErrorType::produce());
 			return;
 		}
-		myArgs->pop_front();
-	}
-	ta->setCurrentFnType(myFn);
-	ta->nodeType(this, myFn->getReturnType());
-}
-
-void NegNode::typeAnalysis(TypeAnalysis *ta){ 
-  myExp->typeAnalysis(ta);
-  auto exp = ta->nodeType(myExp);
-  if (exp->isInt()){
-    ta->nodeType(this, exp);
-  } else {
-    ta->badMathOpd(myExp->line(), myExp->col());
-    ta->nodeType(this, ErrorType::produce());
-  }
-}
-
-void NotNode::typeAnalysis(TypeAnalysis *ta){
-	myExp->typeAnalysis(ta);
-  	auto exp = ta->nodeType(myExp);	
-	if (exp->isBool()) {
-    	ta->nodeType(this, exp);
-	}
-	else {
-		ta->badLogicOpd(myExp->line(), myExp->col());
-		ta->nodeType(this, ErrorType::produce());
-	}
-}
-
-void PostIncStmtNode::typeAnalysis(TypeAnalysis *ta){ // CHECK IF A FUNCTION
-	myLVal->typeAnalysis(ta);
-	auto lval = ta->nodeType(myLVal);
-	if (lval->isInt()) {
-    	ta->nodeType(this, lval);
-	}
-	else {
-		ta->badMathOpd(myLVal->line(), myLVal->col());
-		ta->nodeType(this, ErrorType::produce());
-	}
-}
-
-void PostDecStmtNode::typeAnalysis(TypeAnalysis *ta){ // CHECK IF A FUNCTION
-	myLVal->typeAnalysis(ta);
-	auto lval = ta->nodeType(myLVal);
-	if (lval->isInt()) {
-    	ta->nodeType(this, lval);
-	}
-	else {
-		ta->badMathOpd(myLVal->line(), myLVal->col());
-		ta->nodeType(this, ErrorType::produce());
-	}
-}
-
-void BinaryExpNode::typeAnalysis(TypeAnalysis *ta){ // this only covers == and !=, funcs are allowed
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
-	auto lType = ta->nodeType(myExp1); 
-	auto rType = ta->nodeType(myExp2);
-
-	if (lType->asError() || rType->asError())
-	{
-		ta->nodeType(this, ErrorType::produce());
-		return;
-	}
-	else if (lType == rType) {
-		if((lType->isInt()) || (lType->isBool()) || (lType->isChar())) {
-			ta->nodeType(this, BasicType::produce(BOOL));
-		}
-		else {
-			ta->badEqOpd(myExp1->line(), myExp1->col());
-			ta->nodeType(this, ErrorType::produce());
-			return;
-		}
-		if((rType->isInt()) || (rType->isBool()) || (rType->isChar())) {
-			ta->nodeType(this, BasicType::produce(BOOL));
-		}
-		else {
-			ta->badEqOpd(myExp2->line(), myExp2->col());
+		if (argType != myFrmls[argIdx++]){
+			ta->badCallee(arg->line(), arg->col());
 			ta->nodeType(this, ErrorType::produce());
 			return;
 		}
 	}
-	else { // not the same type, so right side is the problem
-		ta->badEqOpr(myExp2->line(), myExp2->col());
-		ta->nodeType(this, ErrorType::produce());
-		return;
-	}
+	ta->nodeType(this, myFn->getReturnType());
 }
 
-void LessNode::typeAnalysis(TypeAnalysis *ta) {
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
-	auto lType = ta->nodeType(myExp1); 
-	auto rType = ta->nodeType(myExp2);
-
-	if(lType->isInt()) {
-		if(rType->isInt()) {
-			ta->nodeType(this, BasicType::produce(BOOL));
-			return;
-		}
-		else {
-			ta->badRelOpd(myExp2->line(), myExp2->col());
-			ta->nodeType(this, ErrorType::produce());
-			return;
-		}
-	}
-	else {
-		ta->badRelOpd(myExp1->line(), myExp1->col());
-		ta->nodeType(this, ErrorType::produce());
-		if(!(rType->isBool())) {
-			ta->badLogicOpd(myExp2->line(), myExp2->col());
-			return;
-		}
-		return;
+//Operator rules are looked up by operand class; every
+// basic type has a class of its own
+static OpdClass opdClass(const DataType * type){
+	switch (type->getKind()){
+		case ERROR_KIND: return ERROR_OPD;
+		case PTR_KIND: return PTR_OPD;
+		case FN_KIND: return FN_OPD;
+		case BASIC_KIND: break;
 	}
+	if (type->isInt()){ return INT_OPD; }
+	if (type->isBool()){ return BOOL_OPD; }
+	if (type->isChar()){ return CHAR_OPD; }
+	return VOID_OPD;
 }
 
-void LessEqNode::typeAnalysis(TypeAnalysis *ta) {
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
+static constexpr OpRuleTable opRules;
 
-	auto lType = ta->nodeType(myExp1); 
-	auto rType = ta->nodeType(myExp2);
-
-	if(lType->isInt()) {
-		if(rType->isInt()) {
-			ta->nodeType(this, BasicType::produce(BOOL));
-			return;
-		}
-		else {
-			ta->badRelOpd(myExp2->line(), myExp2->col());
-			ta->nodeType(this, ErrorType::produce());
-			return;
-		}
-	}
-	else {
-		ta->badRelOpd(myExp1->line(), myExp1->col());
-		ta->nodeType(this, ErrorType::produce());
-		if(!(rType->isBool())) {
-			ta->badLogicOpd(myExp2->line(), myExp2->col());
-			return;
-		}
-		return;
+static void reportOp(TypeAnalysis * ta, const OpCheck& check,
+	ExpNode * lhs, ExpNode * rhs){
+	ExpNode * opd = check.atRight ? rhs : lhs;
+	size_t l = opd->line();
+	size_t c = opd->col();
+	switch (check.diag){
+		case NO_DIAG: return;
+		case MATH_OPD_DIAG: ta->badMathOpd(l, c); return;
+		case MATH_OPR_DIAG: ta->badMathOpr(l, c); return;
+		case LOGIC_OPD_DIAG: ta->badLogicOpd(l, c); return;
+		case REL_OPD_DIAG: ta->badRelOpd(l, c); return;
+		case EQ_OPD_DIAG: ta->badEqOpd(l, c); return;
+		case EQ_OPR_DIAG: ta->badEqOpr(l, c); return;
 	}
 }
 
-void GreaterNode::typeAnalysis(TypeAnalysis *ta) {
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
-	auto lType = ta->nodeType(myExp1); 
-	auto rType = ta->nodeType(myExp2);
-
-	if(lType->isInt()) {
-		if(rType->isInt()) {
-			ta->nodeType(this, BasicType::produce(BOOL));
+//Apply a rule: report its diagnostics and give the node
+// its result type
+static void applyOp(TypeAnalysis * ta, ExpNode * node, 
+	const OpRule& rule, ExpNode * lhs, ExpNode * rhs){
+	reportOp(ta, rule.first, lhs, rhs);
+	reportOp(ta, rule.second, lhs, rhs);
+	switch (rule.result){
+		case INT_OPD: 
+			ta->nodeType(node, BasicType::produce(INT)); 
 			return;
-		}
-		else {
-			ta->badRelOpd(myExp2->line(), myExp2->col());
-			ta->nodeType(this, ErrorType::produce());
+		case BOOL_OPD: 
+			ta->nodeType(node, BasicType::produce(BOOL)); 
 			return;
-		}
-	}
-	else {
-		ta->badRelOpd(myExp1->line(), myExp1->col());
-		ta->nodeType(this, ErrorType::produce());
-		if(!(rType->isBool())) {
-			ta->badLogicOpd(myExp2->line(), myExp2->col());
-			return;
-		}
-		return;
+		default:
+			ta->nodeType(node, ErrorType::produce());
 	}
 }
 
-void GreaterEqNode::typeAnalysis(TypeAnalysis *ta) {
+void BinaryExpNode::typeAnalysis(TypeAnalysis *ta){
 	myExp1->typeAnalysis(ta);
 	myExp2->typeAnalysis(ta);
 
 	auto lType = ta->nodeType(myExp1); 
 	auto rType = ta->nodeType(myExp2);
-
-	if(lType->isInt()) {
-		if(rType->isInt()) {
-			ta->nodeType(this, BasicType::produce(BOOL));
-			return;
-		}
-		else {
-			ta->badRelOpd(myExp2->line(), myExp2->col());
-			ta->nodeType(this, ErrorType::produce());
-			return;
-		}
-	}
-	else {
-		ta->badRelOpd(myExp1->line(), myExp1->col());
-		ta->nodeType(this, ErrorType::produce());
-		if(!(rType->isBool())) {
-			ta->badLogicOpd(myExp2->line(), myExp2->col());
-			return;
-		}
-		return;
-	}
+	const OpRule& rule = opRules.get(getOp(), 
+		opdClass(lType), opdClass(rType), lType == rType);
+	applyOp(ta, this, rule, myExp1, myExp2);
 }
 
-void AndNode::typeAnalysis(TypeAnalysis *ta) {
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
-	auto lType = ta->nodeType(myExp1); 
-	auto rType = ta->nodeType(myExp2);
+void UnaryExpNode::typeAnalysis(TypeAnalysis *ta){
+	myExp->typeAnalysis(ta);
+	auto type = ta->nodeType(myExp);
+	const OpRule& rule = opRules.get(getOp(), 
+		opdClass(type), ERROR_OPD, false);
+	applyOp(ta, this, rule, myExp, myExp);
+}
 
-	if(lType->isBool()) {
-		if(rType->isBool()) {
-			ta->nodeType(this, BasicType::produce(BOOL));
-			return;
-		}
-		else {
-			ta->badLogicOpd(myExp2->line(), myExp2->col());
-			ta->nodeType(this, ErrorType::produce());
-			return;
-		}
+void PostIncStmtNode::typeAnalysis(TypeAnalysis *ta){ // CHECK IF A FUNCTION
+	myLVal->typeAnalysis(ta);
+	auto lval = ta->nodeType(myLVal);
+	if (lval->isInt()) {
+    	ta->nodeType(this, lval);
 	}
 	else {
-		ta->badRelOpd(myExp1->line(), myExp1->col());
+		ta->badMathOpd(myLVal->line(), myLVal->col());
 		ta->nodeType(this, ErrorType::produce());
-		if(!(rType->isBool())) {
-			ta->badLogicOpd(myExp2->line(), myExp2->col());
-			return;
-		}
-		return;
 	}
 }
 
-void OrNode::typeAnalysis(TypeAnalysis *ta) {
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
-	auto lType = ta->nodeType(myExp1); 
-	auto rType = ta->nodeType(myExp2);
-
-	if(lType->isBool()) {
-		if(rType->isBool()) {
-			ta->nodeType(this, BasicType::produce(BOOL));
-			return;
-		}
-		else {
-			ta->badLogicOpd(myExp2->line(), myExp2->col());
-			ta->nodeType(this, ErrorType::produce());
-			return;
-		}
+void PostDecStmtNode::typeAnalysis(TypeAnalysis *ta){ // CHECK IF A FUNCTION
+	myLVal->typeAnalysis(ta);
+	auto lval = ta->nodeType(myLVal);
+	if (lval->isInt()) {
+    	ta->nodeType(this, lval);
 	}
 	else {
-		ta->badRelOpd(myExp1->line(), myExp1->col());
+		ta->badMathOpd(myLVal->line(), myLVal->col());
 		ta->nodeType(this, ErrorType::produce());
-		if(!(rType->isBool())) {
-			ta->badLogicOpd(myExp2->line(), myExp2->col());
-			return;
-		}
-		return;
 	}
 }
 
@@ -540,135 +591,6 @@ void IfElseStmtNode::typeAnalysis(TypeAnalysis *ta) {
 	ta->nodeType(this, BasicType::produce(VOID));	
 }
 
-void PlusNode::typeAnalysis(TypeAnalysis *ta) {
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
-	auto lType = ta->nodeType(myExp1); 
-	auto rType = ta->nodeType(myExp2);
-
-	if(lType->isInt()) {
-		if(rType->isInt()) {
-			ta->nodeType(this, BasicType::produce(INT)); // int + int , return int
-			return;
-		}
-		else { // int + bool , return error
-			ta->badMathOpr(myExp2->line(), myExp2->col());
-			ta->nodeType(this, ErrorType::produce());
-			return;
-		}
-	}
-	else {  // bool + ?
-		ta->badMathOpr(myExp1->line(), myExp1->col());
-		ta->nodeType(this, ErrorType::produce());
-		if(!(rType->isInt())) { // bool + char , return error
-			ta->badMathOpr(myExp2->line(), myExp2->col());
-			return;
-		}
-		return; // bool + int , return error	
-	}
-}
-
-void MinusNode::typeAnalysis(TypeAnalysis *ta) {
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
-	auto lType = ta->nodeType(myExp1); 
-	auto rType = ta->nodeType(myExp2);
-
-	if(lType->isInt()) {
-		if(rType->isInt()) {
-			ta->nodeType(this, BasicType::produce(INT)); 
-			return;
-		}
-		else { 
-			ta->badMathOpr(myExp2->line(), myExp2->col());
-			ta->nodeType(this, ErrorType::produce());
-			return;
-		}
-	}
-	else { 
-		ta->badMathOpr(myExp1->line(), myExp1->col());
-		ta->nodeType(this, ErrorType::produce());
-		if(!(rType->isInt())) { 
-			ta->badMathOpr(myExp2->line(), myExp2->col());
-			return;
-		}
-		return;
-	}
-}
-
-void DivideNode::typeAnalysis(TypeAnalysis *ta) {
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
-	auto lType = ta->nodeType(myExp1); 
-	auto rType = ta->nodeType(myExp2);
-
-	if(lType->isInt()) {
-		if(rType->isInt()) {
-			ta->nodeType(this, BasicType::produce(INT)); 
-			return;
-		}
-		else { 
-			ta->badMathOpr(myExp2->line(), myExp2->col());
-			ta->nodeType(this, ErrorType::produce());
-			return;
-		}
-	}
-	else { 
-		ta->badMathOpr(myExp1->line(), myExp1->col());
-		ta->nodeType(this, ErrorType::produce());
-		if(!(rType->isInt())) { 
-			ta->badMathOpr(myExp2->line(), myExp2->col());
-			return;
-		}
-		return;
-	}
-}
-
-void TimesNode::typeAnalysis(TypeAnalysis *ta) {
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
-	auto lType = ta->nodeType(myExp1); 
-	auto rType = ta->nodeType(myExp2);
-
-	if(lType->isInt()) {
-		if(rType->isInt()) {
-			ta->nodeType(this, BasicType::produce(INT)); 
-			return;
-		}
-		else { 
-			ta->badMathOpr(myExp2->line(), myExp2->col());
-			ta->nodeType(this, ErrorType::produce());
-			return;
-		}
-	}
-	else { 
-		ta->badMathOpr(myExp1->line(), myExp1->col());
-		ta->nodeType(this, ErrorType::produce());
-		if(!(rType->isInt())) { 
-			ta->badMathOpr(myExp2->line(), myExp2->col());
-			return;
-		}
-		return;
-	}
-}
-
-void EqualsNode::typeAnalysis(TypeAnalysis *ta) {
-	auto lType = ta->nodeType(myExp1);
-	auto rType = ta->nodeType(myExp2);
-	if (lType != rType){
-		ta->badEqOpd(myExp1->line(), myExp1->col());
-		ta->nodeType(this, ErrorType::produce());
-		return;
-	}
-	else{
-		ta->nodeType(this, BasicType::produce(BOOL));
-	}
-}
-
 void ReturnStmtNode::typeAnalysis(TypeAnalysis *ta) {
 	auto fnType = ta->getCurrentFnType();
 	if (myExp == nullptr){
@@ -4,17 +4,19 @@
 #include "ast.hpp"
 #include "symbol_table.hpp"
 #include "types.hpp"
-
-class NameAnalysis;
+#include <vector>
 
 namespace holeyc{
 
+class NameAnalysis;
+class FnCache;
+
 // An instance of this class will be passed over the entire
 // AST. Rather than attaching types to each node, the 
-// TypeAnalysis class contains a map from each ASTNode to it's
-// DataType. Thus, instead of attaching a type field to most nodes,
-// one can instead map the node to it's type, or lookup the node
-// in the map.
+// TypeAnalysis class contains a table from each ASTNode to it's
+// DataType, indexed by the node's dense id. Thus, instead of 
+// attaching a type field to most nodes, one can instead map the 
+// node to it's type, or lookup the node in the table.
 class TypeAnalysis {
 
 private:
@@ -22,11 +24,33 @@ private:
 	// can only be created via the static build function
 	TypeAnalysis(){
 		hasError = false;
+		nameAnalysis = nullptr;
+		firstNodeID = 0;
+		currentFnType = nullptr;
+		table = &nodeToType;
+		ast = nullptr;
 	}
 
 public:
+	//Takes ownership of the name analysis (and so of the
+	// AST): if type analysis fails or throws, both are freed.
 	static TypeAnalysis * build(NameAnalysis * astRoot);
+	//Name and type analysis in one pass over the program,
+	// for when only the verdict and the diagnostics are
+	// wanted. Reports exactly what NameAnalysis::build 
+	// followed by build would. Takes ownership of the AST,
+	// which is freed if the analysis fails or throws.
+	// With a cache, the types of replayed functions' nodes
+	// are never recorded.
+	static TypeAnalysis * buildFused(ProgramNode * ast,
+		FnCache * cache = nullptr);
+	//An analysis of ast with nothing recorded yet, for a 
+	// caller that binds the names itself (with 
+	// ProgramNode::fusedAnalysis). It owns neither the AST
+	// nor any symbols.
+	static TypeAnalysis * blank(ProgramNode * ast);
 	//static TypeAnalysis * build();
+	~TypeAnalysis();
 
 	//The type analysis has an instance variable to say whether
 	// the analysis failed or not. Setting this variable is much
@@ -35,6 +59,21 @@ public:
 	bool passed(){
 		return !hasError;
 	}
+	//Count diagnostics replayed from a cache as found by
+	// this analysis
+	void replayed(bool failed){
+		hasError = hasError || failed;
+	}
+
+	//A context for analysing one declaration while others 
+	// are analysed on other threads. It has its own error
+	// flag and current function, and records types straight
+	// into this analysis's table: every node already has a 
+	// slot there, and nodes of different declarations never
+	// share one, so the workers need no locking.
+	TypeAnalysis * worker();
+	//Fold a worker's result into this analysis and free it
+	void join(TypeAnalysis * worker);
 
 	void setCurrentFnType(const FnType * type){
 		currentFnType = type;
@@ -49,164 +88,197 @@ public:
 	// overloaded: this 2-argument nodeType puts a value into the
 	// map with a given type. 
 	void nodeType(const ASTNode * node, const DataType * type){
-		nodeToType[node] = type;
+		size_t index = slot(node);
+		if (index >= table->size()){
+			//A node added to the tree after parsing. Only
+			// the owner of the table may grow it.
+			if (table != &nodeToType){
+				throw new InternalError("Node outside the"
+					" shared type table");
+			}
+			nodeToType.resize(index + 1, nullptr);
+		}
+		(*table)[index] = type;
 	}
 
 	//Gets the type of a node already placed in the map. Note
 	// that this function name is overloaded: the 1-argument nodeType
 	// gets the type of the given node out of the map.
 	const DataType * nodeType(const ASTNode * node){
-		const DataType * res = nodeToType[node];
+		size_t index = slot(node);
+		const DataType * res = nullptr;
+		if (index < table->size()){
+			res = (*table)[index];
+		}
 		if (res == nullptr){
 			const char * msg = "No type for node ";
 			throw new InternalError(msg);
 		}
-		return nodeToType[node];
+		return res;
+	}
+
+	//The type of a node, or nullptr if it has not been 
+	// given one
+	const DataType * findType(const ASTNode * node) const {
+		size_t index = slot(node);
+		return index < table->size() ? (*table)[index] : nullptr;
 	}
 
 	//The following functions all report and error and 
 	// tell the object that the analysis has failed. 
 	void testErrorType(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::TEST_ERROR,
 		"Found an error here");
 	}
 	void badArgMatch(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::BAD_ARG_TYPE, 
 			"Type of actual does not match"
 			" type of formal");
 	}
 	void badToConsole(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::OUTPUT_FN,
 			"Attempt to output a function");
 	}
 	void badFromConsole(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::READ_FN,
 			"Attempt to read a function");
 	}
 	void badMathOpd(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::BAD_MATH_OPD, 
 			"Arithmetic operator applied"
 			" to invalid operand");
 	}
 	void badMathOpr(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::BAD_MATH_OPR, 
 			"Arithmetic operator applied"
 			" to incompatible operands");
 	}
 	void badIndex(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, "Bad index type");
+		Report::fatal(line, col, DiagCode::BAD_INDEX, "Bad index type");
 	}
 	void badPtrBase(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, "Attempt to index"
+		Report::fatal(line, col, DiagCode::BAD_PTR_BASE, "Attempt to index"
 		  "a non-pointer type"
 		);
 	}
 	void badArgCount(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::BAD_ARG_COUNT,
 			"Function call with wrong"
 			" number of args");
 	}
 	void badCallee(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::CALL_NON_FN,
 			"Attempt to call a "
 			"non-function");
 	}
 	void badAssignOpr(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::BAD_ASSIGN_OPR, 
 			"Invalid assignment operation");
 	}
 	void badAssignOpd(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::BAD_ASSIGN_OPD, 
 			"Invalid assignment operand");
 	}
 	void badEqOpd(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::BAD_EQ_OPD, 
 			"Invalid equality operand");
 	}
 	void badEqOpr(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::BAD_EQ_OPR, 
 			"Invalid equality operation");
 	}
 	void badLogicOpd(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::BAD_LOGIC_OPD,
 			"Logical operator applied to"
 			" non-bool operand");
 	}
 	void badNoRet(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::MISSING_RET, 
 			"Missing return value");
 	}
 	void badRelOpd(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::BAD_REL_OPD,
 			"Relational operator applied to"
 			" non-numeric operand");
 	}
 	void badWriteVoid(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::WRITE_VOID, 
 			"Attempt to write void");
 	}
 
 	void badWhileCond(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::BAD_WHILE_COND,
 			"Non-bool expression used as"
 			" a while condition");
 	}
 	void badIfCond(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::BAD_IF_COND, 
 			"Non-bool expression used as"
 			" an if condition");
 	}
 	void badRetValue(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::BAD_RET, 
 			"Bad return value");
 	}
 	void extraRetValue(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col, 
+		Report::fatal(line, col, DiagCode::EXTRA_RET, 
 			"Return with a value in void"
 			" function");
 	}
 	void writeFn(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::WRITE_FN,
 			"Attempt to write a function");
 	}
 	
 	void readFn(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::READ_FN,
 			"Attempt to read a function");
 	}
 	void fnDeref(size_t line, size_t col){
 		hasError = true;
-		Report::fatal(line, col,
+		Report::fatal(line, col, DiagCode::FN_DEREF,
 			"Attempt to dereference a function");
 	}
 private:
-	HashMap<const ASTNode *, const DataType *> nodeToType;
+	size_t slot(const ASTNode * node) const {
+		if (node->nodeID() < firstNodeID){
+			throw new InternalError("Node from another program");
+		}
+		return node->nodeID() - firstNodeID;
+	}
+	//Sized up front from the program's node count
+	std::vector<const DataType *> nodeToType;
+	//The table types are recorded in: nodeToType, or that
+	// of the analysis a worker was created by
+	std::vector<const DataType *> * table;
+	size_t firstNodeID;
 	const FnType * currentFnType;
 	bool hasError;
+	NameAnalysis * nameAnalysis;
 public:
 	ProgramNode * ast;
 };
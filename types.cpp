@@ -3,12 +3,13 @@
 
 #include "types.hpp"
 #include "ast.hpp"
+#include "hash.hpp"
 
 namespace holeyc{
 
 std::string BasicType::getString() const{
 	std::string res = "";
-	switch(myBaseType){
+	switch(getBaseType()){
 	case BaseType::INT:
 		res += "int";
 		break;
@@ -25,6 +26,120 @@ std::string BasicType::getString() const{
 	return res;
 }
 
+TypeContext& TypeContext::get(){
+	//Built on first use; C++ guarantees this happens once 
+	// even when threads race to get here
+	static TypeContext context;
+	return context;
+}
+
+TypeContext::TypeContext(){
+	myError = new ErrorType();
+	myBasics[BaseType::INT] = new BasicType(BaseType::INT);
+	myBasics[BaseType::VOID] = new BasicType(BaseType::VOID);
+	myBasics[BaseType::BOOL] = new BasicType(BaseType::BOOL);
+	myBasics[BaseType::CHAR] = new BasicType(BaseType::CHAR);
+}
+
+TypeContext::~TypeContext(){
+	for (auto entry : myFns){
+		delete entry.second;
+	}
+	for (PtrType * ptr : myPtrs){
+		delete ptr;
+	}
+	for (BasicType * basic : myBasics){
+		delete basic;
+	}
+	delete myError;
+}
+
+PtrType * TypeContext::ptrTo(const DataType * type){
+	PtrType * cached = type->myPtrTo.load(std::memory_order_acquire);
+	if (cached != nullptr){ return cached; }
+
+	std::lock_guard<std::mutex> guard(myLock);
+	//Someone else may have made it while we waited
+	cached = type->myPtrTo.load(std::memory_order_relaxed);
+	if (cached != nullptr){ return cached; }
+	PtrType * made = nullptr;
+	if (const BasicType * basic = type->asBasic()){
+		made = new PtrType(basic, 1, type);
+	} else if (const PtrType * ptr = type->asPtr()){
+		made = new PtrType(ptr->myBasicType, ptr->getLevel() + 1, type);
+	} else {
+		throw new InternalError("pointer to non-scalar type");
+	}
+	myPtrs.push_back(made);
+	type->myPtrTo.store(made, std::memory_order_release);
+	return made;
+}
+
+PtrType * TypeContext::ptr(const BasicType * basicType, int level){
+	if (level <= 0){
+		throw new InternalError("bad pointer level");
+	}
+	PtrType * res = ptrTo(basicType);
+	for (int i = 1; i < level; i++){
+		res = ptrTo(res);
+	}
+	return res;
+}
+
+size_t TypeContext::FnKeyHash::operator()(
+	const std::vector<const DataType *>& key) const {
+	Hasher hash(key.size());
+	for (const DataType * type : key){
+		hash.add(reinterpret_cast<uintptr_t>(type));
+	}
+	return static_cast<size_t>(hash.done());
+}
+
+FnType * TypeContext::fn(const std::vector<const DataType *>& formals,
+	const DataType * retType){
+	std::vector<const DataType *> key;
+	key.reserve(formals.size() + 1);
+	key.push_back(retType);
+	key.insert(key.end(), formals.begin(), formals.end());
+
+	std::lock_guard<std::mutex> guard(myLock);
+	FnType *& found = myFns[key];
+	if (found == nullptr){
+		found = new FnType(formals, retType);
+	}
+	return found;
+}
+
+ErrorType * ErrorType::produce(){
+	return TypeContext::get().error();
+}
+
+BasicType * BasicType::produce(BaseType base){
+	return TypeContext::get().basic(base);
+}
+
+PtrType * PtrType::produce(const BasicType * basicType, int level){
+	return TypeContext::get().ptr(basicType, level);
+}
+
+DataType * PtrType::incLevel() const {
+	return TypeContext::get().ptrTo(this);
+}
+
+DataType * PtrType::refType(const DataType * type){
+	if (type->asError()){ 
+		return ErrorType::produce();
+	} else if (type->asBasic() || type->asPtr()){ 
+		return TypeContext::get().ptrTo(type);
+	}
+	return nullptr;
+}
+
+FnType * FnType::produce(const std::vector<const DataType *>& formals,
+	const DataType * retType){
+	return TypeContext::get().fn(formals, retType);
+}
+
 DataType * CharTypeNode::getType() { 
 	BasicType * base = BasicType::CHAR();
 	if (isPtr){
@@ -1,8 +1,12 @@
 #ifndef XXLANG_DATA_TYPES
 #define XXLANG_DATA_TYPES
 
+#include <atomic>
+#include <cstdint>
 #include <list>
+#include <mutex>
 #include <sstream>
+#include <vector>
 #include "errors.hpp"
 
 #include <unordered_map>
@@ -23,53 +27,75 @@ class BasicType;
 class FnType;
 class PtrType;
 class ErrorType;
+class TypeContext;
 
-enum BaseType{
+enum BaseType : uint8_t {
 	INT, VOID, BOOL, CHAR
 };
 
+//Which subclass of DataType a type is
+enum TypeKind : uint8_t {
+	ERROR_KIND, BASIC_KIND, PTR_KIND, FN_KIND
+};
+
 //This class is the superclass for all holeyc types. You
 // can get information about which type is implemented
 // concretely using the as<X> functions, or query information
-// using the is<X> functions.
+// using the is<X> functions. Every type carries its kind, 
+// base type and pointer level itself, so the queries are 
+// plain inline loads rather than virtual calls (they sit on
+// the hot path of every operator check).
 class DataType{
 public:
+	virtual ~DataType(){ }
 	virtual std::string getString() const = 0;
-	virtual const BasicType * asBasic() const { return nullptr; }
-	virtual const PtrType * asPtr() const { return nullptr; }
-	virtual const FnType * asFn() const { return nullptr; }
-	virtual const ErrorType * asError() const { return nullptr; }
-	virtual bool isVoid() const { return false; }
-	virtual bool isInt() const { return false; }
-	virtual bool isBool() const { return false; }
-	virtual bool isChar() const { return false; }
-	virtual bool isPtr() const { return false; }
-	virtual bool validVarType() const = 0 ;
+	TypeKind getKind() const { return myKind; }
+	inline const BasicType * asBasic() const;
+	inline const PtrType * asPtr() const;
+	inline const FnType * asFn() const;
+	inline const ErrorType * asError() const;
+	bool isVoid() const { return isBasic(BaseType::VOID); }
+	bool isInt() const { return isBasic(BaseType::INT); }
+	bool isBool() const { return isBasic(BaseType::BOOL); }
+	bool isChar() const { return isBasic(BaseType::CHAR); }
+	bool isPtr() const { return myKind == PTR_KIND; }
+	bool validVarType() const {
+		return myKind == PTR_KIND 
+			|| (myKind == BASIC_KIND && myBase != BaseType::VOID);
+	}
 protected:
+	DataType(TypeKind kind, BaseType base, int level) 
+	: myKind(kind), myBase(base), myLevel(level), myPtrTo(nullptr){ }
+	//For basic and pointer types, the underlying base type
+	BaseType getBase() const { return myBase; }
+	//For pointer types, the levels of indirection
+	int getPtrLevel() const { return myLevel; }
+private:
+	friend class TypeContext;
+	bool isBasic(BaseType base) const {
+		return myKind == BASIC_KIND && myBase == base;
+	}
+	const TypeKind myKind;
+	const BaseType myBase;
+	const int myLevel;
+	//The (interned) type of a pointer to this type, once
+	// something has asked for it
+	mutable std::atomic<PtrType *> myPtrTo;
 };
 
 //This DataType subclass is the superclass for all holeyc types. 
 // Note that there is exactly one instance of this 
 class ErrorType : public DataType{
 public:
-	static ErrorType * produce(){
-		//Note: this static member will only ever be initialized 
-		// ONCE, no matter how many times the function is called.
-		// That means there will only ever be 1 instance of errorType
-		// in the entire codebase.
-		static ErrorType * error = new ErrorType();
-		
-		return error;
-	}
-	virtual const ErrorType * asError() const override { return this; }
+	static ErrorType * produce();
 	virtual std::string getString() const override { 
 		return "ERROR";
 	}
-	virtual bool validVarType() const override { return false; }
 private:
-	ErrorType(){ 
+	friend class TypeContext;
+	ErrorType() : DataType(ERROR_KIND, BaseType::VOID, 0){ 
 		/* private constructor, can only 
-		be called from produce */
+		be called from the TypeContext */
 	}
 	size_t line;
 	size_t col;
@@ -98,101 +124,48 @@ public:
 	// and ensures that the memory needs of a program are kept
 	// down: rather than having a distinct type for every base
 	// INT (for example), only one is constructed and kept in
-	// the flyweights list. That type is then re-used anywhere
+	// the TypeContext. That type is then re-used anywhere
 	// it's needed. 
 
 	//Note the use of the static function declaration, which 
 	// means that no instance of BasicType is needed to call
 	// the function.
-	static BasicType * produce(BaseType base){
-		//Note the use of the static local variable, which
-		//means that the flyweights variable persists between
-		// multiple calls to this function (it is essentially
-		// a global variable that can only be accessed
-		// in this function).
-		static std::list<BasicType *> flyweights;
-		for(BasicType * fly : flyweights){
-			if (fly->getBaseType() == base){
-				return fly;
-			}
-		}
-		BasicType * newType = new BasicType(base);
-		flyweights.push_back(newType);
-		return newType;
-	}
+	static BasicType * produce(BaseType base);
 	const BasicType * asVar() const {
 		return this;
 	}
 	BasicType * asVar(){
 		return this;
 	}
-	bool isInt() const override {
-		return myBaseType == BaseType::INT;
-	}
-	bool isBool() const override {
-		return myBaseType == BaseType::BOOL;
-	}
-	virtual bool isVoid() const override { 
-		return myBaseType == BaseType::VOID; 
-	}
-	virtual bool isChar() const override {
-		return myBaseType == BaseType::CHAR;
-	}
-	virtual bool validVarType() const override {
-		return !isVoid();
-	}
-	virtual BaseType getBaseType() const { return myBaseType; }
+	BaseType getBaseType() const { return getBase(); }
 	virtual std::string getString() const override;
 private:
+	friend class TypeContext;
 	BasicType(BaseType base) 
-	: myBaseType(base){ }
-	BaseType myBaseType;
+	: DataType(BASIC_KIND, base, 0){ }
 };
 
 class PtrType : public DataType{
 public:
-	static PtrType * produce(const BasicType * basicType, int level){
-		if (level <= 0){
-			throw new InternalError("bad pointer level");
-		}
-
-		//Note the use of the static local variable, which
-		//means that the flyweights variable persists between
-		// multiple calls to this function (it is essentially
-		// a global variable that can only be accessed
-		// in this function).
-		static std::list<PtrType *> flyweights;
-		for(PtrType * fly : flyweights){
-			if (fly->myBasicType == basicType){
-				if (fly->myLevel == level){
-					return fly;
-				}
-			}
-		}
-		PtrType * newType = new PtrType(basicType, level);
-		flyweights.push_back(newType);
-		return newType;
-	}
+	static PtrType * produce(const BasicType * basicType, int level);
 
 	std::string getString() const override{
 		std::string res = myBasicType->getString();
-		for (int i = 0 ; i < myLevel ; i++){
+		for (int i = 0 ; i < getLevel() ; i++){
 			res += "ptr";
 		}
 		return res;
 	}
 
 	/* Add a level of indirection from a pointer type */
-	DataType * incLevel() const {
-		return PtrType::produce(myBasicType, myLevel + 1);
-	}
+	DataType * incLevel() const;
 
 	/* Remove a level of indirection to the pointer type */
-	DataType * decLevel() const{
-		return PtrType::produce(myBasicType, myLevel - 1);
+	const DataType * decLevel() const{
+		return myPointee;
 	}
 
-	static DataType * derefType(const DataType * type){
+	static const DataType * derefType(const DataType * type){
 		if (type->asError()){ 
 			return ErrorType::produce();
 		} else if (const PtrType * t = type->asPtr()){ 
@@ -204,47 +177,36 @@ public:
 		}
 	}
 
-	static DataType * refType(const DataType * type){
-		if (type->asError()){ 
-			return ErrorType::produce();
-		} else if (const PtrType * t = type->asPtr()){ 
-			return t->incLevel(); 
-		} else if (const BasicType * t = type->asBasic()){ 
-			return PtrType::produce(t, 1);
-		}
-		return nullptr;
-	}
+	static DataType * refType(const DataType * type);
 
-	virtual bool validVarType() const override {
-		return true;
-	}
-	bool isPtr() const override { return true; } 
-	const PtrType * asPtr() const override { return this; }
-	int getLevel(){ return myLevel; }
+	int getLevel() const { return getPtrLevel(); }
 	
 private:
-	PtrType(const BasicType * basicType, int level)
-	: myBasicType(basicType), myLevel(level){
-		/* private constructor, can only be called from produce */
+	friend class TypeContext;
+	PtrType(const BasicType * basicType, int level, const DataType * pointee)
+	: DataType(PTR_KIND, basicType->getBaseType(), level),
+	  myBasicType(basicType), myPointee(pointee){
+		/* private constructor, can only be called from 
+		the TypeContext */
 	}
 	const BasicType * myBasicType;
-	int myLevel;
+	//The type one level of indirection down
+	const DataType * myPointee;
 };
 
 //DataType subclass to represent the type of a function. It will
 // have a list of argument types and a return type. 
+//Function types are interned like all others, so two
+// functions have the same signature exactly when they have
+// the same FnType.
 class FnType : public DataType{
 public:
-	FnType(const std::list<const DataType *>* formalsIn, const DataType * retTypeIn) 
-	: DataType(),
-	  myFormalTypes(formalsIn),
-	  myRetType(retTypeIn)
-	{
-	}
+	static FnType * produce(const std::vector<const DataType *>& formals,
+		const DataType * retType);
 	std::string getString() const override{
 		std::string result = "";
 		bool first = true;
-		for (auto elt : *myFormalTypes){
+		for (auto elt : myFormalTypes){
 			if (first) { first = false; }
 			else { result += ","; }
 			result += elt->getString();
@@ -253,20 +215,76 @@ public:
 		result += myRetType->getString();
 		return result;
 	}
-	virtual const FnType * asFn() const override { return this; }
-
 	const DataType * getReturnType() const {
 		return myRetType;
 	}
-	const std::list<const DataType *> * getFormalTypes() const {
+	const std::vector<const DataType *>& getFormalTypes() const {
 		return myFormalTypes;
 	}
-	virtual bool validVarType() const override { return false; }
 private:
-	const std::list<const DataType *> * myFormalTypes;
+	friend class TypeContext;
+	FnType(const std::vector<const DataType *>& formalsIn, const DataType * retTypeIn) 
+	: DataType(FN_KIND, BaseType::VOID, 0),
+	  myFormalTypes(formalsIn),
+	  myRetType(retTypeIn)
+	{
+	}
+	std::vector<const DataType *> myFormalTypes;
 	const DataType * myRetType;
 };
 
+inline const BasicType * DataType::asBasic() const {
+	return myKind == BASIC_KIND ? static_cast<const BasicType *>(this) : nullptr;
+}
+
+inline const PtrType * DataType::asPtr() const {
+	return myKind == PTR_KIND ? static_cast<const PtrType *>(this) : nullptr;
+}
+
+inline const FnType * DataType::asFn() const {
+	return myKind == FN_KIND ? static_cast<const FnType *>(this) : nullptr;
+}
+
+inline const ErrorType * DataType::asError() const {
+	return myKind == ERROR_KIND ? static_cast<const ErrorType *>(this) : nullptr;
+}
+
+//Interns every type, so that two types are equal exactly 
+// when they are the same object. There is one context for 
+// the whole process, and it is safe to use from several 
+// threads at once. Basic types and the error type are built
+// up front; pointer and function types are interned in hash
+// tables under a lock, and every type caches the pointer type
+// that refers to it, so taking & of a type is a single 
+// atomic load after the first time.
+class TypeContext{
+public:
+	static TypeContext& get();
+	ErrorType * error() const { return myError; }
+	BasicType * basic(BaseType base) const { return myBasics[base]; }
+	//The type of a pointer to type (which must be a basic
+	// or pointer type)
+	PtrType * ptrTo(const DataType * type);
+	PtrType * ptr(const BasicType * basicType, int level);
+	FnType * fn(const std::vector<const DataType *>& formals,
+		const DataType * retType);
+private:
+	TypeContext();
+	~TypeContext();
+	struct FnKeyHash{
+		size_t operator()(const std::vector<const DataType *>& key) const;
+	};
+
+	ErrorType * myError;
+	BasicType * myBasics[4];
+	std::mutex myLock;
+	//Keyed by return type followed by the formal types
+	std::unordered_map<std::vector<const DataType *>, FnType *, 
+		FnKeyHash> myFns;
+	//Every pointer type, for freeing
+	std::vector<PtrType *> myPtrs;
+};
+
 }
 
 #endif
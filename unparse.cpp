@@ -4,7 +4,12 @@
 namespace holeyc{
 
 static void doIndent(std::ostream& out, int indent){
-	for (int k = 0 ; k < indent; k++){ out << "\t"; }
+	static const char tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+	static const int maxTabs = sizeof(tabs) - 1;
+	for ( ; indent > maxTabs; indent -= maxTabs){
+		out.write(tabs, maxTabs);
+	}
+	if (indent > 0){ out.write(tabs, indent); }
 }
 
 void ProgramNode::unparse(std::ostream& out, int indent){